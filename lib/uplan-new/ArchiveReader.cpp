@@ -0,0 +1,295 @@
+#include "ArchiveReader.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <zlib.h>
+
+namespace UPlanGeneration {
+
+namespace {
+
+uint16_t le16(const std::string& s, size_t pos) {
+    return static_cast<uint16_t>(static_cast<unsigned char>(s[pos]) |
+                                 (static_cast<unsigned char>(s[pos + 1]) << 8));
+}
+
+uint32_t le32(const std::string& s, size_t pos) {
+    return static_cast<uint32_t>(le16(s, pos)) | (static_cast<uint32_t>(le16(s, pos + 2)) << 16);
+}
+
+// Inflates into a buffer that grows as output is produced (doubling, capped at limit)
+// instead of trusting the size declared by the archive
+bool inflateRaw(const char* data, size_t size, size_t expected, size_t limit, std::string& out) {
+    out.clear();
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) return false;
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs.avail_in = static_cast<uInt>(size);
+
+    // One spare byte past the limit tells "exactly at the limit" from "over it"
+    const size_t capacity = limit == SIZE_MAX ? limit : limit + 1;
+    size_t produced = 0;
+    int rc = Z_OK;
+    while (rc == Z_OK) {
+        if (produced == out.size()) {
+            if (produced == capacity) break;   // over the limit
+            size_t grow = std::max<size_t>(64 * 1024, std::min(expected, size * 4));
+            out.resize(std::min(capacity, std::max(produced * 2, grow)));
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(&out[produced]);
+        zs.avail_out = static_cast<uInt>(std::min<size_t>(out.size() - produced, UINT32_MAX));
+        uInt before = zs.avail_out;
+        rc = inflate(&zs, Z_NO_FLUSH);
+        produced += before - zs.avail_out;
+        if (rc == Z_BUF_ERROR && zs.avail_in == 0) break;   // truncated input
+        if (rc == Z_BUF_ERROR) rc = Z_OK;                    // output full: grow and retry
+    }
+    inflateEnd(&zs);
+    out.resize(produced);
+    return rc == Z_STREAM_END && produced <= limit && produced == expected;
+}
+
+size_t storedBytes(const std::vector<ArchiveEntry>& entries) {
+    size_t total = 0;
+    for (const auto& entry : entries) total += entry.data.size();
+    return total;
+}
+
+// Bytes that may still be extracted for one entry (SIZE_MAX = unlimited)
+size_t entryAllowance(const ArchiveLimits& limits, size_t total) {
+    size_t allowance = limits.max_entry_bytes ? limits.max_entry_bytes : SIZE_MAX;
+    if (limits.max_total_bytes) {
+        allowance = std::min(allowance, total < limits.max_total_bytes ? limits.max_total_bytes - total : 0);
+    }
+    return allowance;
+}
+
+bool isZip(const std::string& data) {
+    return data.size() >= 4 && data.compare(0, 4, "PK\x03\x04", 4) == 0;
+}
+
+bool isTar(const std::string& data) {
+    return data.size() >= 512 && data.compare(257, 5, "ustar") == 0;
+}
+
+uint64_t parseOctal(const char* field, size_t length) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < length && field[i]; ++i) {
+        if (field[i] == ' ') continue;
+        if (field[i] < '0' || field[i] > '7') break;
+        value = value * 8 + static_cast<uint64_t>(field[i] - '0');
+    }
+    return value;
+}
+
+std::string headerParam(const std::string& headers, const std::string& param) {
+    std::string key = param + "=\"";
+    size_t pos = headers.find(key);
+    if (pos == std::string::npos) return "";
+    pos += key.size();
+    size_t end = headers.find('"', pos);
+    return end == std::string::npos ? "" : headers.substr(pos, end - pos);
+}
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+bool extractZip(const std::string& data, std::vector<ArchiveEntry>& entries, const ArchiveLimits& limits) {
+    // End of central directory: last 22 bytes + up to 64 KiB of comment
+    if (data.size() < 22) return false;
+    size_t eocd = std::string::npos;
+    size_t lowest = data.size() > 22 + 65535 ? data.size() - 22 - 65535 : 0;
+    for (size_t pos = data.size() - 22; ; --pos) {
+        if (le32(data, pos) == 0x06054b50) {
+            eocd = pos;
+            break;
+        }
+        if (pos == lowest) break;
+    }
+    if (eocd == std::string::npos) {
+        std::cerr << "[ERROR] Invalid zip: end of central directory not found" << std::endl;
+        return false;
+    }
+
+    uint16_t count = le16(data, eocd + 10);
+    size_t pos = le32(data, eocd + 16);
+    if (count == 0xFFFF || pos == 0xFFFFFFFF) {
+        std::cerr << "[ERROR] Zip64 archives are not supported" << std::endl;
+        return false;
+    }
+
+    size_t total = storedBytes(entries);
+    for (uint16_t i = 0; i < count; ++i) {
+        if (pos + 46 > data.size() || le32(data, pos) != 0x02014b50) {
+            std::cerr << "[ERROR] Invalid zip central directory" << std::endl;
+            return false;
+        }
+        uint16_t method = le16(data, pos + 10);
+        uint32_t compressed = le32(data, pos + 20);
+        uint32_t uncompressed = le32(data, pos + 24);
+        uint16_t name_len = le16(data, pos + 28);
+        uint16_t extra_len = le16(data, pos + 30);
+        uint16_t comment_len = le16(data, pos + 32);
+        uint32_t local = le32(data, pos + 42);
+        std::string name = data.substr(pos + 46, name_len);
+        pos += 46 + name_len + extra_len + comment_len;
+
+        if (name.empty() || name.back() == '/') continue;   // directory
+
+        if (local + 30 > data.size() || le32(data, local) != 0x04034b50) {
+            std::cerr << "[ERROR] Invalid zip local header for " << name << std::endl;
+            return false;
+        }
+        size_t offset = local + 30 + le16(data, local + 26) + le16(data, local + 28);
+        if (offset + compressed > data.size()) {
+            std::cerr << "[ERROR] Truncated zip entry: " << name << std::endl;
+            return false;
+        }
+
+        if (method != 0 && method != 8) {
+            std::cerr << "[WARNING] Unsupported zip compression method " << method << ", skipping: " << name << std::endl;
+            continue;
+        }
+        // The declared size is only a hint: it is checked here and again after inflating
+        const size_t allowance = entryAllowance(limits, total);
+        if (uncompressed > allowance) {
+            std::cerr << "[ERROR] Zip entry " << name << " exceeds the extraction limit (" << uncompressed
+                      << " bytes)" << std::endl;
+            return false;
+        }
+
+        ArchiveEntry entry;
+        entry.name = name;
+        if (method == 0) {
+            if (compressed != uncompressed) {
+                std::cerr << "[ERROR] Invalid stored zip entry: " << name << std::endl;
+                return false;
+            }
+            entry.data = data.substr(offset, compressed);
+        } else if (!inflateRaw(data.data() + offset, compressed, uncompressed, allowance, entry.data)) {
+            std::cerr << "[ERROR] Cannot inflate zip entry (corrupt or over the extraction limit): " << name << std::endl;
+            return false;
+        }
+        total += entry.data.size();
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+bool extractTar(const std::string& data, std::vector<ArchiveEntry>& entries, const ArchiveLimits& limits) {
+    size_t pos = 0;
+    std::string long_name;
+    size_t total = storedBytes(entries);
+
+    while (pos + 512 <= data.size()) {
+        const char* header = data.data() + pos;
+        if (header[0] == '\0') break;   // end-of-archive blocks
+
+        uint64_t size = parseOctal(header + 124, 12);
+        char type = header[156];
+        size_t content = pos + 512;
+        if (content + size > data.size()) {
+            std::cerr << "[ERROR] Truncated tar entry" << std::endl;
+            return false;
+        }
+
+        std::string name;
+        if (!long_name.empty()) {
+            name = long_name;
+            long_name.clear();
+        } else {
+            std::string prefix(header + 345, strnlen(header + 345, 155));
+            name.assign(header, strnlen(header, 100));
+            if (!prefix.empty()) name = prefix + "/" + name;
+        }
+
+        if (type == 'L') {
+            // GNU long name for the next entry
+            long_name.assign(data, content, size);
+            while (!long_name.empty() && long_name.back() == '\0') long_name.pop_back();
+        } else if (type == '0' || type == '\0') {
+            if (size > entryAllowance(limits, total)) {
+                std::cerr << "[ERROR] Tar entry " << name << " exceeds the extraction limit (" << size << " bytes)" << std::endl;
+                return false;
+            }
+            entries.push_back({name, data.substr(content, size)});
+            total += size;
+        }
+
+        pos = content + ((size + 511) / 512) * 512;
+    }
+    return true;
+}
+
+bool extractArchive(const std::string& data, std::vector<ArchiveEntry>& entries, const ArchiveLimits& limits) {
+    if (isZip(data)) return extractZip(data, entries, limits);
+    if (isTar(data)) return extractTar(data, entries, limits);
+    std::cerr << "[ERROR] Unknown archive format (expected zip or tar)" << std::endl;
+    return false;
+}
+
+std::string multipartBoundary(const std::string& content_type) {
+    size_t pos = content_type.find("boundary=");
+    if (pos == std::string::npos) return "";
+    std::string boundary = content_type.substr(pos + 9);
+    size_t end = boundary.find(';');
+    if (end != std::string::npos) boundary.resize(end);
+    if (boundary.size() >= 2 && boundary.front() == '"' && boundary.back() == '"') {
+        boundary = boundary.substr(1, boundary.size() - 2);
+    }
+    return boundary;
+}
+
+bool parseMultipart(const std::string& body, const std::string& boundary, std::vector<ArchiveEntry>& entries,
+                    const ArchiveLimits& limits) {
+    if (boundary.empty()) {
+        std::cerr << "[ERROR] Missing multipart boundary" << std::endl;
+        return false;
+    }
+    const std::string delimiter = "--" + boundary;
+
+    size_t pos = body.find(delimiter);
+    if (pos == std::string::npos) {
+        std::cerr << "[ERROR] Multipart boundary not found in body" << std::endl;
+        return false;
+    }
+
+    while (true) {
+        pos += delimiter.size();
+        if (body.compare(pos, 2, "--") == 0) break;   // closing delimiter
+        if (body.compare(pos, 2, "\r\n") == 0) pos += 2;
+
+        size_t headers_end = body.find("\r\n\r\n", pos);
+        if (headers_end == std::string::npos) return false;
+        std::string headers = body.substr(pos, headers_end - pos);
+        size_t content = headers_end + 4;
+
+        size_t next = body.find("\r\n" + delimiter, content);
+        if (next == std::string::npos) {
+            std::cerr << "[ERROR] Unterminated multipart part" << std::endl;
+            return false;
+        }
+
+        std::string filename = headerParam(headers, "filename");
+        if (!filename.empty()) {
+            std::string data = body.substr(content, next - content);
+            if (endsWith(filename, ".zip") || endsWith(filename, ".tar")) {
+                if (!extractArchive(data, entries, limits)) return false;
+            } else if (data.size() > entryAllowance(limits, storedBytes(entries))) {
+                std::cerr << "[ERROR] Upload part " << filename << " exceeds the extraction limit" << std::endl;
+                return false;
+            } else {
+                entries.push_back({filename, std::move(data)});
+            }
+        }
+        pos = next + 2;
+    }
+    return true;
+}
+
+} // namespace UPlanGeneration
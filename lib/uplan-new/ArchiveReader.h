@@ -0,0 +1,44 @@
+#ifndef ARCHIVE_READER_H
+#define ARCHIVE_READER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace UPlanGeneration {
+
+// Fichero extraído en memoria de un zip/tar o de una parte multipart/form-data
+struct ArchiveEntry {
+    std::string name;
+    std::string data;
+};
+
+// Límites de lo extraído en memoria (0 = sin límite). El total cuenta todas las
+// entradas de `entries`, también las que ya tenía antes de la extracción. El tamaño
+// descomprimido que declara un zip no se usa para reservar memoria: la salida crece
+// por bloques y la extracción falla en cuanto una entrada o el total pasan del límite.
+struct ArchiveLimits {
+    size_t max_entry_bytes = size_t(256) << 20;
+    size_t max_total_bytes = 0;
+};
+
+// Extrae en memoria un zip (stored/deflate, requiere zlib) o un tar (ustar/GNU),
+// detectando el formato por su cabecera. Sólo se devuelven ficheros regulares.
+bool extractArchive(const std::string& data, std::vector<ArchiveEntry>& entries,
+                    const ArchiveLimits& limits = ArchiveLimits());
+bool extractZip(const std::string& data, std::vector<ArchiveEntry>& entries,
+                const ArchiveLimits& limits = ArchiveLimits());
+bool extractTar(const std::string& data, std::vector<ArchiveEntry>& entries,
+                const ArchiveLimits& limits = ArchiveLimits());
+
+// Separa un cuerpo multipart/form-data en sus ficheros (partes con filename).
+// Las partes que son a su vez zip/tar se extraen también.
+bool parseMultipart(const std::string& body, const std::string& boundary, std::vector<ArchiveEntry>& entries,
+                    const ArchiveLimits& limits = ArchiveLimits());
+
+// Extrae el boundary de un Content-Type "multipart/form-data; boundary=..."
+std::string multipartBoundary(const std::string& content_type);
+
+} // namespace UPlanGeneration
+
+#endif // ARCHIVE_READER_H
@@ -0,0 +1,289 @@
+#include "AsyncGenerator.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace UPlanGeneration {
+
+namespace {
+
+// Fire-and-forget wrapper: starts immediately and frees its frame when done
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {}
+    };
+};
+
+Detached runDetached(Task<void> task, std::atomic<size_t>& counter) {
+    try {
+        co_await task;
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Async task failed: " << e.what() << std::endl;
+    }
+    --counter;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// EventLoop
+// ---------------------------------------------------------------------------
+
+EventLoop::EventLoop() {
+    epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd < 0 || wake_fd < 0) {
+        std::cerr << "[ERROR] Cannot create event loop: " << std::strerror(errno) << std::endl;
+        return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;   // nullptr marks the wake-up eventfd
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+}
+
+EventLoop::~EventLoop() {
+    if (wake_fd >= 0) ::close(wake_fd);
+    if (epoll_fd >= 0) ::close(epoll_fd);
+}
+
+void EventLoop::wake() {
+    uint64_t one = 1;
+    // Only fails with EAGAIN when the counter is saturated, i.e. already awake
+    [[maybe_unused]] ssize_t n = ::write(wake_fd, &one, sizeof(one));
+}
+
+void EventLoop::stop() {
+    running = false;
+    wake();
+}
+
+void EventLoop::post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        ready.push_back(handle);
+    }
+    wake();
+}
+
+void EventLoop::spawn(Task<void> task) {
+    ++spawned;
+    runDetached(std::move(task), spawned);
+}
+
+bool EventLoop::FdAwaiter::await_suspend(std::coroutine_handle<> awaiting) {
+    handle = awaiting;
+    epoll_event ev{};
+    ev.events = events | EPOLLONESHOT;
+    ev.data.ptr = this;
+    if (::epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0 &&
+        (errno != EEXIST || ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_MOD, fd, &ev) != 0)) {
+        // Not pollable: resume at once and let the caller's I/O call report the error
+        ready_events = EPOLLERR;
+        return false;
+    }
+    return true;
+}
+
+EventLoop::FdAwaiter EventLoop::readable(int fd) {
+    return FdAwaiter{*this, fd, EPOLLIN | EPOLLRDHUP};
+}
+
+EventLoop::FdAwaiter EventLoop::writable(int fd) {
+    return FdAwaiter{*this, fd, EPOLLOUT};
+}
+
+bool EventLoop::run() {
+    if (epoll_fd < 0 || wake_fd < 0) return false;
+    running = true;
+    epoll_event events[256];
+    std::vector<std::coroutine_handle<>> batch;
+
+    while (running) {
+        int n = ::epoll_wait(epoll_fd, events, 256, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[ERROR] epoll_wait failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        // Collect every ready waiter before resuming any of them: a resumed coroutine
+        // may finish and destroy the frame that holds another FdAwaiter of this batch
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.ptr == nullptr) {
+                uint64_t count;
+                while (::read(wake_fd, &count, sizeof(count)) > 0) {}
+                continue;
+            }
+            // One-shot: deregister so the descriptor can be awaited again (or closed)
+            auto* waiter = static_cast<FdAwaiter*>(events[i].data.ptr);
+            ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, waiter->fd, nullptr);
+            waiter->ready_events = events[i].events;
+            batch.push_back(waiter->handle);
+        }
+
+        // Coroutines handed back by the worker pools
+        {
+            std::lock_guard<std::mutex> lock(ready_mutex);
+            batch.insert(batch.end(), ready.begin(), ready.end());
+            ready.clear();
+        }
+        for (auto handle : batch) handle.resume();
+        batch.clear();
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// WorkerPool
+// ---------------------------------------------------------------------------
+
+WorkerPool::WorkerPool(unsigned count) {
+    if (count == 0) count = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < count; ++i) {
+        threads.emplace_back([this] {
+            while (true) {
+                std::function<void()> work;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return closing || !queue.empty(); });
+                    if (queue.empty()) return;
+                    work = std::move(queue.front());
+                    queue.pop_front();
+                }
+                work();
+            }
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    cv.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void WorkerPool::execute(std::function<void()> work) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(work));
+    }
+    cv.notify_one();
+}
+
+// ---------------------------------------------------------------------------
+// Generator API
+// ---------------------------------------------------------------------------
+
+// The offloaded lambdas capture only by reference: parameters and locals live in the
+// coroutine frame, which outlives the suspension (by-value captures of non-trivial
+// objects inside co_await temporaries are miscompiled by some GCC releases).
+
+Task<std::vector<WaypointComplete>> loadTrajectoryAsync(AsyncRuntime& runtime, std::string csv_path) {
+    UplanGeneratorComplete generator(runtime.config);
+    auto waypoints = co_await offload(runtime.loop, runtime.io, [&] {
+        return generator.loadWaypointsFromCSV(csv_path);
+    });
+    co_return waypoints;
+}
+
+Task<std::vector<VolumeRecord>> generateVolumesAsync(AsyncRuntime& runtime, std::vector<WaypointComplete> waypoints,
+                                                     double start_timestamp, int plan_id) {
+    UplanGeneratorComplete generator(runtime.config);
+    auto records = co_await offload(runtime.loop, runtime.cpu, [&] {
+        return generator.generateVolumeRecords(generator.reduceWaypoints(waypoints), start_timestamp, plan_id);
+    });
+    co_return records;
+}
+
+Task<nlohmann::json> generateUplanAsync(AsyncRuntime& runtime, BatchJob job) {
+    // Reading a trajectory file is I/O: do it on the I/O pool before taking a CPU thread
+    if (job.csv_content.empty() && !job.csv_path.empty()) {
+        job.csv_content = co_await offload(runtime.loop, runtime.io, [&] {
+            std::ifstream file(job.csv_path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        });
+    }
+    UplanGeneratorComplete generator(runtime.config);
+    generator.setValidator(runtime.validator);
+    nlohmann::json uplan = co_await offload(runtime.loop, runtime.cpu, [&] {
+        std::istringstream input(job.csv_content);
+        auto waypoints = generator.loadWaypointsFromStream(input, job.name);
+        if (waypoints.empty()) return nlohmann::json();
+        return generator.generateCompleteUplan(job.uplan_id, job.name, waypoints, job.start_timestamp,
+                                               job.category, job.uasType, job.mtom, job.vMax);
+    });
+    co_return uplan;
+}
+
+Task<bool> writeAsync(AsyncRuntime& runtime, std::string path, std::string data) {
+    bool written = co_await offload(runtime.loop, runtime.io, [&] {
+        std::ofstream file(path, std::ios::binary);
+        file << data;
+        file.close();
+        if (!file) {
+            std::cerr << "[ERROR] Cannot write file: " << path << std::endl;
+            return false;
+        }
+        return true;
+    });
+    co_return written;
+}
+
+Task<ssize_t> readSomeAsync(EventLoop& loop, int fd, char* buffer, size_t length) {
+    while (true) {
+        ssize_t n = ::read(fd, buffer, length);
+        if (n >= 0) co_return n;
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) co_return -1;
+        co_await loop.readable(fd);
+    }
+}
+
+Task<bool> writeAllAsync(EventLoop& loop, int fd, std::string data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == ENOTSOCK) {
+            // Pipes and other non-socket descriptors
+            n = ::write(fd, data.data() + sent, data.size() - sent);
+            if (n > 0) {
+                sent += static_cast<size_t>(n);
+                continue;
+            }
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            co_await loop.writable(fd);
+            continue;
+        }
+        co_return false;
+    }
+    co_return true;
+}
+
+} // namespace UPlanGeneration
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,276 @@
+#ifndef ASYNC_GENERATOR_H
+#define ASYNC_GENERATOR_H
+
+// API asíncrona con corrutinas de C++20 para el servicio de generación. Con un
+// estándar anterior este fichero (y AsyncGenerator.cpp) quedan vacíos, de modo que
+// el resto de la librería sigue compilando en C++17.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+#include <nlohmann/json.hpp>
+#include "BatchDriver.h"
+#include "UplanGeneratorComplete.h"
+#include "VolumeRecord.h"
+
+namespace UPlanGeneration {
+
+// ---------------------------------------------------------------------------
+// Task<T>: corrutina perezosa (empieza al hacer co_await) con continuación
+// ---------------------------------------------------------------------------
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // Symmetric transfer back to whoever awaited the task
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            auto next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+    T take() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void take() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+
+template <typename T = void>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    // Esperar un Task vacío (construido por defecto o ya movido) es un error de uso
+    bool await_ready() const {
+        if (!handle) throw std::logic_error("co_await on an empty Task");
+        return handle.done();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() { return handle.promise().take(); }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------
+// Bucle de eventos (epoll) y pool de hilos
+// ---------------------------------------------------------------------------
+
+// Bucle de eventos de un solo hilo. Las corrutinas se reanudan siempre en el hilo que
+// ejecuta run(); desde otros hilos se devuelven al bucle con post().
+class EventLoop {
+public:
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Ejecuta hasta stop(); retorna false si epoll falla
+    bool run();
+    // Se puede llamar desde cualquier hilo o desde un manejador de señal
+    void stop();
+    // Reanuda la corrutina en el hilo del bucle (thread-safe)
+    void post(std::coroutine_handle<> handle);
+
+    // Espera a que un descriptor no bloqueante sea legible/escribible.
+    // Sólo puede haber una espera pendiente por descriptor.
+    struct FdAwaiter {
+        EventLoop& loop;
+        int fd;
+        uint32_t events;
+        uint32_t ready_events = 0;
+        std::coroutine_handle<> handle{};
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> awaiting);
+        uint32_t await_resume() const noexcept { return ready_events; }
+    };
+    FdAwaiter readable(int fd);
+    FdAwaiter writable(int fd);
+
+    // Lanza una tarea sin esperarla; su marco se libera al terminar
+    void spawn(Task<void> task);
+
+    size_t pendingTasks() const { return spawned; }
+
+private:
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    std::atomic<bool> running{false};
+    std::atomic<size_t> spawned{0};
+
+    std::mutex ready_mutex;
+    std::vector<std::coroutine_handle<>> ready;
+
+    void wake();
+};
+
+// Pool de hilos para trabajo bloqueante (CPU o E/S de ficheros)
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void execute(std::function<void()> work);
+    unsigned size() const { return static_cast<unsigned>(threads.size()); }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> queue;
+    bool closing = false;
+    std::vector<std::thread> threads;
+};
+
+// co_await offload(loop, pool, fn): ejecuta fn en el pool y reanuda en el bucle con su resultado
+template <typename F>
+auto offload(EventLoop& loop, WorkerPool& pool, F function) {
+    using Result = std::invoke_result_t<F&>;
+
+    struct Awaiter {
+        EventLoop& loop;
+        WorkerPool& pool;
+        F function;
+        std::conditional_t<std::is_void_v<Result>, bool, std::optional<Result>> result{};
+        std::exception_ptr error{};
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            pool.execute([this, handle] {
+                try {
+                    if constexpr (std::is_void_v<Result>) {
+                        function();
+                    } else {
+                        result.emplace(function());
+                    }
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                loop.post(handle);
+            });
+        }
+        Result await_resume() {
+            if (error) std::rethrow_exception(error);
+            if constexpr (!std::is_void_v<Result>) return std::move(*result);
+        }
+    };
+    return Awaiter{loop, pool, std::move(function)};
+}
+
+// ---------------------------------------------------------------------------
+// API del generador
+// ---------------------------------------------------------------------------
+
+// Entorno de ejecución del servicio: bucle de eventos, pool de CPU para la generación
+// y pool pequeño para la E/S de ficheros (los ficheros regulares no se pueden esperar
+// con epoll). Un generador por tarea: su construcción sólo copia la configuración.
+struct AsyncRuntime {
+    explicit AsyncRuntime(const UplanConfigComplete& config, unsigned cpu_threads = 0, unsigned io_threads = 2)
+        : config(config), cpu(cpu_threads), io(io_threads) {}
+
+    UplanConfigComplete config;
+    const UplanSchemaValidator* validator = nullptr;
+    EventLoop loop;
+    WorkerPool cpu;
+    WorkerPool io;
+};
+
+// Los parámetros se pasan por valor: las tareas son perezosas y pueden sobrevivir al llamador
+Task<std::vector<WaypointComplete>> loadTrajectoryAsync(AsyncRuntime& runtime, std::string csv_path);
+Task<std::vector<VolumeRecord>> generateVolumesAsync(AsyncRuntime& runtime, std::vector<WaypointComplete> waypoints,
+                                                     double start_timestamp, int plan_id);
+// Uplan completo de un trabajo (CSV en memoria o fichero), como en el BatchDriver
+Task<nlohmann::json> generateUplanAsync(AsyncRuntime& runtime, BatchJob job);
+Task<bool> writeAsync(AsyncRuntime& runtime, std::string path, std::string data);
+
+// Sockets no bloqueantes: lectura de lo disponible (0 = cerrado, -1 = error) y escritura completa
+Task<ssize_t> readSomeAsync(EventLoop& loop, int fd, char* buffer, size_t length);
+Task<bool> writeAllAsync(EventLoop& loop, int fd, std::string data);
+
+} // namespace UPlanGeneration
+
+#endif // __cpp_impl_coroutine
+
+#endif // ASYNC_GENERATOR_H
@@ -0,0 +1,290 @@
+#include "BatchDriver.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <unistd.h>
+
+namespace UPlanGeneration {
+
+namespace {
+
+// Memory model per plan. Rows are estimated from the shortest realistic CSV row
+// (time,lat,lon,alt), which bounds the row count from above; each waypoint is held
+// raw, reduced and as segment geometry, and each volume as a JSON tree plus its
+// serialized Uplan/OI text. One volume is emitted per reduced segment, i.e. per
+// WAYPOINT_COMPRESSION_FACTOR input rows; the row bound is the only safety margin.
+constexpr size_t BYTES_PER_CSV_ROW = 48;
+constexpr size_t BYTES_PER_WAYPOINT = 3 * sizeof(WaypointComplete) + sizeof(SegmentGeometry);
+constexpr size_t BYTES_PER_VOLUME = 4096;
+constexpr size_t ROWS_PER_VOLUME = UplanGeneratorComplete::WAYPOINT_COMPRESSION_FACTOR;
+constexpr size_t BYTES_PER_PLAN = 64 * 1024;   // generator state, metadata, output buffers
+
+size_t planBytes(size_t waypoints, size_t volumes) {
+    return BYTES_PER_PLAN + waypoints * BYTES_PER_WAYPOINT + volumes * BYTES_PER_VOLUME;
+}
+
+} // namespace
+
+BatchDriver::BatchDriver(const UplanConfigComplete& config, unsigned workers)
+    : config(config), worker_count(workers), nodes(detectNumaTopology()) {
+    if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queues.resize(nodes.size());
+}
+
+BatchDriver::~BatchDriver() {
+    finish();
+}
+
+void BatchDriver::start(ResultCallback onResult) {
+    on_result = std::move(onResult);
+    closing = false;
+    ok_count = 0;
+    fail_count = 0;
+    skip_count = 0;
+    in_flight = 0;
+    peak_in_flight = 0;
+    steal_count = 0;
+    for (unsigned i = 0; i < worker_count; ++i) {
+        threads.emplace_back(&BatchDriver::workerLoop, this, i);
+    }
+    std::cout << "[INFO] Batch driver started with " << worker_count << " workers";
+    if (nodes.size() > 1) std::cout << " on " << nodes.size() << " NUMA nodes";
+    if (memory_budget > 0) std::cout << ", memory budget " << (memory_budget >> 20) << " MB";
+    std::cout << std::endl;
+}
+
+void BatchDriver::submit(BatchJob job) {
+    const size_t bytes = memory_budget > 0 ? estimateJobBytes(job) : 0;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        queues[next_queue].push_back({std::move(job), bytes});
+        next_queue = (next_queue + 1) % queues.size();
+        ++queued;
+    }
+    // With a budget only the queue heads may be admissible; wake everyone
+    if (memory_budget > 0) {
+        queue_cv.notify_all();
+    } else {
+        queue_cv.notify_one();
+    }
+}
+
+size_t BatchDriver::estimateJobBytes(const BatchJob& job) {
+    size_t input = job.csv_content.size();
+    if (input == 0 && !job.csv_path.empty()) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(job.csv_path, ec);
+        input = ec ? 0 : static_cast<size_t>(size);
+    }
+    const size_t rows = input / BYTES_PER_CSV_ROW + 1;
+    return input + planBytes(rows, rows / ROWS_PER_VOLUME + 1);
+}
+
+size_t BatchDriver::availableMemory() {
+    // cgroup v2, then v1; "max" or absurdly large values mean no container limit
+    for (const char* path : {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"}) {
+        std::ifstream file(path);
+        unsigned long long limit = 0;
+        if (file >> limit && limit > 0 && limit < (1ULL << 60)) {
+            return static_cast<size_t>(limit);
+        }
+    }
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    return pages > 0 && page_size > 0 ? static_cast<size_t>(pages) * static_cast<size_t>(page_size) : 0;
+}
+
+bool BatchDriver::admits(size_t bytes) const {
+    return memory_budget == 0 || in_flight == 0 || in_flight + bytes <= memory_budget;
+}
+
+void BatchDriver::reserve(size_t& held, size_t bytes) {
+    if (memory_budget == 0 || bytes == held) return;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        // Growing an admitted plan never blocks (it would deadlock); it only delays new admissions
+        in_flight = in_flight - held + bytes;
+        peak_in_flight = std::max(peak_in_flight, in_flight);
+    }
+    if (bytes < held) queue_cv.notify_all();
+    held = bytes;
+}
+
+void BatchDriver::finish() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        closing = true;
+    }
+    queue_cv.notify_all();
+    for (auto& t : threads) {
+        if (t.joinable()) t.join();
+    }
+    threads.clear();
+    if (journal) journal->flush();
+}
+
+size_t BatchDriver::run(std::vector<BatchJob> jobs, ResultCallback onResult) {
+    start(std::move(onResult));
+    for (auto& job : jobs) {
+        submit(std::move(job));
+    }
+    finish();
+    std::cout << "[INFO] Batch finished: " << ok_count << " generated, " << fail_count << " failed";
+    if (skip_count > 0) std::cout << ", " << skip_count << " already completed";
+    if (nodes.size() > 1) std::cout << ", " << steal_count << " taken from another NUMA node";
+    if (memory_budget > 0) std::cout << ", peak estimated memory " << (peak_in_flight >> 20) << " MB";
+    std::cout << std::endl;
+    return ok_count;
+}
+
+bool BatchDriver::takeNext(size_t node, Pending& next) {
+    // Own queue first; its head waits for memory rather than being overtaken
+    auto& own = queues[node];
+    if (!own.empty()) {
+        if (!admits(own.front().bytes)) return false;
+        next = std::move(own.front());
+        own.pop_front();
+        --queued;
+        return true;
+    }
+    // Own queue empty: steal the head of another node's queue
+    for (size_t k = 1; k < queues.size(); ++k) {
+        auto& other = queues[(node + k) % queues.size()];
+        if (!other.empty() && admits(other.front().bytes)) {
+            next = std::move(other.front());
+            other.pop_front();
+            --queued;
+            ++steal_count;
+            return true;
+        }
+    }
+    return false;
+}
+
+void BatchDriver::workerLoop(unsigned index) {
+    // Workers are spread over the NUMA nodes and pinned to a CPU of their node before
+    // anything is allocated, so first-touch places their memory on the local node
+    const size_t node = index % nodes.size();
+    if (nodes.size() > 1) {
+        const auto& cpus = nodes[node].cpus;
+        int cpu = cpus[(index / nodes.size()) % cpus.size()];
+        if (!pinCurrentThread(cpu)) {
+            std::cerr << "[WARNING] Cannot pin batch worker " << index << " to CPU " << cpu << std::endl;
+        }
+    }
+
+    // Each worker owns its generator; terrain cache, validator and geozone index are shared
+    UplanGeneratorComplete generator(config);
+    generator.setTerrain(terrain);
+    generator.setValidator(validator);
+    generator.setGeozones(geozones);
+
+    while (true) {
+        BatchJob job;
+        size_t reserved = 0;
+        {
+            // Admission in submission order per queue: a head waits until its estimate fits
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            Pending next;
+            while (!takeNext(node, next)) {
+                if (closing && queued == 0) return;   // closing and drained
+                queue_cv.wait(lock);
+            }
+            job = std::move(next.job);
+            reserved = next.bytes;
+            in_flight += reserved;
+            peak_in_flight = std::max(peak_in_flight, in_flight);
+        }
+        // The next queued plan may fit as well
+        if (memory_budget > 0) queue_cv.notify_all();
+
+        bool skipped = false;
+        BatchResult result = process(generator, job, skipped, reserved);
+        if (skipped) {
+            ++skip_count;
+            reserve(reserved, 0);
+            continue;
+        }
+        (result.ok ? ok_count : fail_count)++;
+
+        // Serialization and file I/O run here, in parallel across workers
+        if (on_result) on_result(result);
+        // Journal only once the callback has persisted the output
+        if (journal && result.ok && !result.output.empty()) {
+            journal->record(result.input_hash, result.job.name, result.output, result.job.uplan_id);
+        }
+        // Serialized and written: drop the result before releasing its reservation
+        result = BatchResult();
+        reserve(reserved, 0);
+    }
+}
+
+uint64_t BatchDriver::inputHash(const BatchJob& job, const std::string& csv_content) {
+    // Same CSV with different generation parameters is a different plan. The id is left
+    // out: it depends on arrival order (see the journal entry, which records it)
+    std::ostringstream params;
+    params.precision(17);
+    params << job.name << '\n' << job.start_timestamp << '\n' << job.category << '\n'
+           << job.uasType << '\n' << job.mtom << '\n' << job.vMax << '\n';
+    const std::string p = params.str();
+    uint64_t h = BatchJournal::hash(p.data(), p.size());
+    return BatchJournal::hash(csv_content.data(), csv_content.size(), h);
+}
+
+BatchResult BatchDriver::process(UplanGeneratorComplete& generator, BatchJob& job, bool& skipped, size_t& reserved) {
+    BatchResult result;
+
+    if (journal) {
+        // The hash needs the file content; read it once and parse from memory
+        if (job.csv_content.empty() && !job.csv_path.empty()) {
+            std::ifstream file(job.csv_path, std::ios::binary);
+            job.csv_content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        result.input_hash = inputHash(job, job.csv_content);
+        if (journal->isCompleted(result.input_hash)) {
+            std::cout << "[INFO] Skipping " << job.name << ": already completed ("
+                      << journal->outputOf(result.input_hash) << ")" << std::endl;
+            skipped = true;
+            return result;
+        }
+    }
+
+    std::vector<WaypointComplete> waypoints;
+    if (!job.csv_content.empty()) {
+        std::istringstream input(job.csv_content);
+        waypoints = generator.loadWaypointsFromStream(input, job.name);
+        // The CSV text is no longer needed; do not carry it into the result
+        job.csv_content.clear();
+        job.csv_content.shrink_to_fit();
+    } else {
+        waypoints = generator.loadWaypointsFromCSV(job.csv_path);
+    }
+    // Loaded: the CSV text is gone, the waypoint count is now known
+    reserve(reserved, planBytes(waypoints.size(), waypoints.size() / ROWS_PER_VOLUME + 1));
+
+    if (waypoints.empty()) {
+        result.error = "no waypoints loaded";
+    } else {
+        try {
+            result.uplan = generator.generateCompleteUplan(
+                job.uplan_id, job.name, waypoints, job.start_timestamp,
+                job.category, job.uasType, job.mtom, job.vMax);
+            if (result.uplan.empty()) result.error = "Uplan generation failed";
+            // Generated: the Uplan JSON (to be serialized by the callback) dominates
+            const size_t volumes = result.uplan.contains("operationVolumes") ? result.uplan["operationVolumes"].size() : 0;
+            reserve(reserved, planBytes(waypoints.size(), volumes));
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+    }
+
+    result.ok = result.error.empty();
+    result.job = std::move(job);
+    return result;
+}
+
+} // namespace UPlanGeneration
@@ -0,0 +1,150 @@
+#ifndef BATCH_DRIVER_H
+#define BATCH_DRIVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <nlohmann/json.hpp>
+#include "UplanGeneratorComplete.h"
+#include "BatchJournal.h"
+#include "NumaTopology.h"
+
+namespace UPlanGeneration {
+
+// Un plan a generar: la trayectoria puede venir de un fichero o en memoria
+struct BatchJob {
+    int uplan_id = 0;
+    std::string name;              // nombre del plan (nombre del CSV)
+    std::string csv_path;          // fichero de trayectoria, o bien...
+    std::string csv_content;       // ...su contenido ya en memoria (tiene prioridad)
+    double start_timestamp = 0.0;
+    std::string category;
+    std::string uasType;
+    double mtom = 0.0;
+    double vMax = 0.0;
+};
+
+struct BatchResult {
+    BatchJob job;
+    bool ok = false;
+    nlohmann::json uplan;
+    std::string error;
+    uint64_t input_hash = 0;       // hash de la entrada (CSV + parámetros)
+    std::string output;            // ubicación de la salida; el callback la rellena al guardar
+};
+
+// Generación de Uplans en paralelo con un generador por worker.
+// Los resultados se entregan según terminan (no en orden de envío). El callback se
+// ejecuta en el worker, en paralelo con los de otros workers, para que la serialización
+// y la escritura de un plan no esperen a las de los demás: lo que comparta entre planes
+// (un stream, contadores) lo protege el propio callback, y sólo durante la entrega.
+//
+// Con un diario (setJournal) los planes cuya entrada ya figura como completada se omiten
+// sin llamar al callback, y cada resultado correcto cuyo callback rellene result.output
+// se registra en el diario tras retornar el callback (la salida ya está escrita).
+//
+// Con un presupuesto de memoria (setMemoryBudget) cada plan reserva una estimación de
+// su memoria al ser admitido (a partir del tamaño del CSV) y la ajusta en cada etapa
+// (carga, generación, serialización/escritura en el callback) hasta liberarla al
+// terminar. Un plan sólo se admite si cabe en el presupuesto; si no, los workers
+// esperan (en orden de envío) a que otros planes liberen memoria. Un plan mayor que
+// todo el presupuesto se ejecuta solo.
+//
+// En máquinas con varios nodos NUMA los workers se reparten entre nodos y se fijan a
+// CPUs de su nodo; su generador (y todo lo que reserva) se crea ya fijado, así que su
+// memoria es local al nodo. Cada nodo tiene su cola: los planes se reparten entre colas
+// y un worker sólo toma planes de otro nodo cuando la suya está vacía.
+class BatchDriver {
+public:
+    using ResultCallback = std::function<void(BatchResult& result)>;
+
+    // workers = 0 -> std::thread::hardware_concurrency()
+    explicit BatchDriver(const UplanConfigComplete& config, unsigned workers = 0);
+    ~BatchDriver();
+
+    BatchDriver(const BatchDriver&) = delete;
+    BatchDriver& operator=(const BatchDriver&) = delete;
+
+    void setTerrain(DemTileCache* dem) { terrain = dem; }
+    void setValidator(const UplanSchemaValidator* schema_validator) { validator = schema_validator; }
+    // Filtro de geozonas con rechazo temprano (ver UplanGeneratorComplete::setGeozones)
+    void setGeozones(const GeozoneIndex* index) { geozones = index; }
+    void setJournal(BatchJournal* batch_journal) { journal = batch_journal; }
+    // Presupuesto de memoria en bytes para los planes en curso (0 = sin límite)
+    void setMemoryBudget(size_t bytes) { memory_budget = bytes; }
+
+    // Arranca los workers
+    void start(ResultCallback onResult);
+    // Encola un plan (se puede llamar mientras los workers están procesando)
+    void submit(BatchJob job);
+    // Espera a que terminen todos los planes encolados y detiene los workers
+    void finish();
+
+    // start + submit de todos + finish; retorna el número de planes generados
+    size_t run(std::vector<BatchJob> jobs, ResultCallback onResult);
+
+    unsigned workerCount() const { return worker_count; }
+    const std::vector<NumaNode>& numaNodes() const { return nodes; }
+    size_t stolen() const { return steal_count; }
+    size_t succeeded() const { return ok_count; }
+    size_t failed() const { return fail_count; }
+    size_t skipped() const { return skip_count; }
+    size_t peakInFlightBytes() const { return peak_in_flight; }
+
+    // Estimación de memoria de un plan antes de cargarlo (tamaño del CSV)
+    static size_t estimateJobBytes(const BatchJob& job);
+    // Memoria disponible para el proceso: límite del cgroup o memoria física
+    static size_t availableMemory();
+
+    // Hash de la entrada de un plan: contenido del CSV + parámetros de generación (sin el
+    // id del plan, que el diario guarda aparte)
+    static uint64_t inputHash(const BatchJob& job, const std::string& csv_content);
+
+private:
+    UplanConfigComplete config;
+    unsigned worker_count;
+    DemTileCache* terrain = nullptr;
+    const UplanSchemaValidator* validator = nullptr;
+    const GeozoneIndex* geozones = nullptr;
+    BatchJournal* journal = nullptr;
+    std::vector<NumaNode> nodes;
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    struct Pending {
+        BatchJob job;
+        size_t bytes;       // estimación de admisión
+    };
+    std::vector<std::deque<Pending>> queues;   // una por nodo NUMA
+    size_t queued = 0;
+    size_t next_queue = 0;
+    bool closing = false;
+
+    // Memoria reservada por los planes en curso (protegido por queue_mutex)
+    size_t memory_budget = 0;
+    size_t in_flight = 0;
+    size_t peak_in_flight = 0;
+
+    ResultCallback on_result;
+
+    std::vector<std::thread> threads;
+    std::atomic<size_t> ok_count{0};
+    std::atomic<size_t> fail_count{0};
+    std::atomic<size_t> skip_count{0};
+    std::atomic<size_t> steal_count{0};
+
+    void workerLoop(unsigned index);
+    bool takeNext(size_t node, Pending& next);
+    bool admits(size_t bytes) const;
+    void reserve(size_t& held, size_t bytes);
+    BatchResult process(UplanGeneratorComplete& generator, BatchJob& job, bool& skipped, size_t& reserved);
+};
+
+} // namespace UPlanGeneration
+
+#endif // BATCH_DRIVER_H
@@ -0,0 +1,212 @@
+#include "BatchJournal.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace UPlanGeneration {
+
+namespace {
+
+// Journal fields are tab-separated, one entry per line
+std::string sanitize(const std::string& field) {
+    std::string out = field;
+    for (char& c : out) {
+        if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+    }
+    return out;
+}
+
+bool planLess(const BatchJournal::CompletedPlan& a, const BatchJournal::CompletedPlan& b) {
+    return a.name != b.name ? a.name < b.name : a.output < b.output;
+}
+
+} // namespace
+
+BatchJournal::BatchJournal(const std::string& path, size_t group_size, std::chrono::milliseconds group_delay)
+    : path(path), group_size(group_size ? group_size : 1), group_delay(group_delay),
+      last_flush(std::chrono::steady_clock::now()) {}
+
+BatchJournal::~BatchJournal() {
+    flush();
+    if (fd >= 0) ::close(fd);
+}
+
+uint64_t BatchJournal::hash(const void* data, size_t length, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool BatchJournal::open() {
+    std::lock_guard<std::mutex> lock(mutex);
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "[ERROR] Cannot open batch journal: " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "[ERROR] Cannot stat batch journal: " << path << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    std::string content(static_cast<size_t>(st.st_size), '\0');
+    if (!content.empty() && pread(fd, &content[0], content.size(), 0) != static_cast<ssize_t>(content.size())) {
+        std::cerr << "[ERROR] Cannot read batch journal: " << path << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // Replay complete lines; a torn last line (crash mid-write) is cut off
+    size_t pos = 0, valid = 0;
+    while (pos < content.size()) {
+        size_t end = content.find('\n', pos);
+        if (end == std::string::npos) break;
+        std::string line = content.substr(pos, end - pos);
+        size_t tab1 = line.find('\t');
+        size_t tab2 = tab1 == std::string::npos ? std::string::npos : line.find('\t', tab1 + 1);
+        uint64_t h;
+        if (tab2 != std::string::npos && std::sscanf(line.c_str(), "%16" SCNx64, &h) == 1) {
+            // The id column is missing in journals written before it was recorded
+            size_t tab3 = line.find('\t', tab2 + 1);
+            int uplan_id = 0;
+            if (tab3 != std::string::npos) {
+                std::from_chars(line.data() + tab3 + 1, line.data() + line.size(), uplan_id);
+            }
+            completed[h] = {line.substr(tab1 + 1, tab2 - tab1 - 1),
+                            line.substr(tab2 + 1, tab3 == std::string::npos ? std::string::npos : tab3 - tab2 - 1),
+                            uplan_id};
+        }
+        pos = end + 1;
+        valid = pos;
+    }
+    if (valid < content.size()) {
+        std::cerr << "[WARNING] Discarding incomplete batch journal entry in " << path << std::endl;
+        if (ftruncate(fd, static_cast<off_t>(valid)) != 0) {
+            std::cerr << "[ERROR] Cannot truncate batch journal: " << path << std::endl;
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+    }
+    lseek(fd, 0, SEEK_END);
+
+    if (!completed.empty()) {
+        std::cout << "[INFO] Batch journal " << path << ": " << completed.size() << " plans already completed" << std::endl;
+    }
+    return true;
+}
+
+bool BatchJournal::isCompleted(uint64_t input_hash) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return completed.count(input_hash) > 0;
+}
+
+std::string BatchJournal::outputOf(uint64_t input_hash) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = completed.find(input_hash);
+    return it == completed.end() ? "" : it->second.output;
+}
+
+size_t BatchJournal::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return completed.size();
+}
+
+std::vector<BatchJournal::CompletedPlan> BatchJournal::completedPlans() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<CompletedPlan> plans;
+    plans.reserve(completed.size());
+    for (const auto& [hash, entry] : completed) plans.push_back({hash, entry.name, entry.output, entry.uplan_id});
+    std::sort(plans.begin(), plans.end(), planLess);
+    return plans;
+}
+
+std::vector<BatchJournal::CompletedPlan> BatchJournal::completedPlans(const std::vector<uint64_t>& input_hashes) const {
+    std::vector<uint64_t> hashes = input_hashes;
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<CompletedPlan> plans;
+    for (uint64_t hash : hashes) {
+        auto it = completed.find(hash);
+        if (it != completed.end()) plans.push_back({hash, it->second.name, it->second.output, it->second.uplan_id});
+    }
+    std::sort(plans.begin(), plans.end(), planLess);
+    return plans;
+}
+
+void BatchJournal::record(uint64_t input_hash, const std::string& name, const std::string& output, int uplan_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016" PRIx64, input_hash);
+    pending += hex;
+    pending += '\t';
+    pending += sanitize(output);
+    pending += '\t';
+    pending += sanitize(name);
+    pending += '\t';
+    pending += std::to_string(uplan_id);
+    pending += '\n';
+    ++pending_entries;
+    completed[input_hash] = {sanitize(output), sanitize(name), uplan_id};
+
+    if (pending_entries >= group_size || std::chrono::steady_clock::now() - last_flush >= group_delay) {
+        flushLocked();
+    }
+}
+
+bool BatchJournal::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return flushLocked();
+}
+
+bool BatchJournal::flushIfDue() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pending.empty() || std::chrono::steady_clock::now() - last_flush < group_delay) return true;
+    return flushLocked();
+}
+
+bool BatchJournal::flushLocked() {
+    last_flush = std::chrono::steady_clock::now();
+    if (pending.empty()) return true;
+    if (fd < 0) return false;
+
+    size_t written = 0;
+    while (written < pending.size()) {
+        ssize_t n = ::write(fd, pending.data() + written, pending.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[ERROR] Cannot write batch journal: " << path << std::endl;
+            // What reached the file must not be written again by the next flush, or the
+            // line it belongs to would be garbled
+            pending.erase(0, written);
+            pending_entries = static_cast<size_t>(std::count(pending.begin(), pending.end(), '\n'));
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    if (fdatasync(fd) != 0) {
+        std::cerr << "[ERROR] Cannot sync batch journal: " << path << std::endl;
+        return false;
+    }
+    pending.clear();
+    pending_entries = 0;
+    return true;
+}
+
+} // namespace UPlanGeneration
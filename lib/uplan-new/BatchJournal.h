@@ -0,0 +1,87 @@
+#ifndef BATCH_JOURNAL_H
+#define BATCH_JOURNAL_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UPlanGeneration {
+
+// Diario append-only de planes completados en una ejecución por lotes.
+// Cada línea registra el hash de la entrada (CSV + parámetros del plan), la salida
+// escrita, el nombre del plan y su id (que no forma parte del hash: al reanudar, el
+// plan recupera el id con el que se escribió su salida). Al reanudar tras un fallo, el BatchDriver omite las
+// entradas ya completadas, así que el coste de recuperación es proporcional al
+// trabajo pendiente.
+//
+// Las entradas se escriben agrupadas (una escritura + fdatasync por grupo de
+// group_size entradas o cada group_delay): tras un fallo sólo se repiten, como
+// mucho, los planes del último grupo sin volcar. record() sólo comprueba el plazo al
+// añadir una entrada; un proceso de larga duración debe llamar a flushIfDue() de vez
+// en cuando para que el último grupo no quede pendiente mientras no llegan planes.
+class BatchJournal {
+public:
+    explicit BatchJournal(const std::string& path, size_t group_size = 64,
+                          std::chrono::milliseconds group_delay = std::chrono::milliseconds(1000));
+    ~BatchJournal();
+
+    BatchJournal(const BatchJournal&) = delete;
+    BatchJournal& operator=(const BatchJournal&) = delete;
+
+    // Carga las entradas existentes (descarta una última línea incompleta) y abre para añadir
+    bool open();
+
+    bool isCompleted(uint64_t input_hash) const;
+    std::string outputOf(uint64_t input_hash) const;
+
+    // Registra un plan completado (se vuelca al completar el grupo)
+    void record(uint64_t input_hash, const std::string& name, const std::string& output, int uplan_id = 0);
+
+    // Vuelca las entradas pendientes (durable al retornar true)
+    bool flush();
+    // Vuelca las entradas pendientes si ha pasado group_delay desde el último volcado
+    bool flushIfDue();
+
+    struct CompletedPlan {
+        uint64_t input_hash;
+        std::string name;
+        std::string output;
+        int uplan_id;           // 0 en diarios anteriores a registrar el id
+    };
+
+    size_t size() const;
+    // Planes completados, incluidos los de ejecuciones anteriores, ordenados por nombre
+    std::vector<CompletedPlan> completedPlans() const;
+    // Sólo los de estas entradas (p. ej. los trabajos de una ejecución), una vez cada uno
+    std::vector<CompletedPlan> completedPlans(const std::vector<uint64_t>& input_hashes) const;
+    const std::string& getPath() const { return path; }
+
+    // Hash FNV-1a de 64 bits, encadenable
+    static uint64_t hash(const void* data, size_t length, uint64_t seed = 14695981039346656037ULL);
+
+private:
+    std::string path;
+    size_t group_size;
+    std::chrono::milliseconds group_delay;
+    int fd = -1;
+
+    mutable std::mutex mutex;
+    struct Entry {
+        std::string output;
+        std::string name;
+        int uplan_id;
+    };
+    std::unordered_map<uint64_t, Entry> completed;   // hash -> plan completado
+    std::string pending;
+    size_t pending_entries = 0;
+    std::chrono::steady_clock::time_point last_flush;
+
+    bool flushLocked();
+};
+
+} // namespace UPlanGeneration
+
+#endif // BATCH_JOURNAL_H
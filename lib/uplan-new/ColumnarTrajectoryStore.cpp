@@ -0,0 +1,357 @@
+#include "ColumnarTrajectoryStore.h"
+#include "UplanFastReader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+namespace UPlanGeneration {
+
+namespace {
+
+const char BLOCK_MAGIC[8] = {'U', 'T', 'C', 'O', 'L', 'B', '0', '1'};
+const size_t AUTO_FLUSH_ROWS = 1 << 20;
+
+struct BlockHeader {
+    char magic[8];
+    uint32_t rows;
+    uint32_t crc;           // over the payload
+    double min_time, max_time;
+    double min_lat, max_lat;
+    double min_lon, max_lon;
+    double min_alt, max_alt;
+};
+
+static_assert(sizeof(BlockHeader) == 80, "BlockHeader layout changed");
+
+// Payload: flight ids (uint32, padded to 8 bytes) followed by time, lat, lon, alt (double)
+size_t flightColumnBytes(uint32_t rows) {
+    return (static_cast<size_t>(rows) * sizeof(uint32_t) + 7) & ~size_t(7);
+}
+
+size_t payloadBytes(uint32_t rows) {
+    return flightColumnBytes(rows) + static_cast<size_t>(rows) * 4 * sizeof(double);
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool appendFile(const std::string& path, const std::string& data) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, data.data(), data.size()) && fdatasync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+bool overlaps(double a_min, double a_max, double b_min, double b_max) {
+    return a_min <= b_max && b_min <= a_max;
+}
+
+} // namespace
+
+ColumnarTrajectoryStore::ColumnarTrajectoryStore(const std::string& directory, double cell_size_deg, uint32_t block_rows)
+    : directory(directory), cell_size(cell_size_deg), block_rows(std::max<uint32_t>(1, block_rows)) {}
+
+bool ColumnarTrajectoryStore::open() {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec) {
+        std::cerr << "[ERROR] Cannot create trajectory store: " << directory << std::endl;
+        return false;
+    }
+
+    // The partitioning parameters are fixed when the store is created
+    const std::string meta_path = directory + "/store.json";
+    if (fs::exists(meta_path)) {
+        std::ifstream meta_file(meta_path);
+        nlohmann::json meta = nlohmann::json::parse(meta_file, nullptr, false);
+        if (meta.is_discarded() || !meta.contains("cell_size") || !meta.contains("block_rows")) {
+            std::cerr << "[ERROR] Invalid trajectory store metadata: " << meta_path << std::endl;
+            return false;
+        }
+        cell_size = meta["cell_size"].get<double>();
+        block_rows = meta["block_rows"].get<uint32_t>();
+    } else {
+        std::ofstream meta_file(meta_path);
+        meta_file << nlohmann::json{{"version", 1}, {"cell_size", cell_size}, {"block_rows", block_rows}}.dump(4);
+        if (!meta_file) {
+            std::cerr << "[ERROR] Cannot write trajectory store metadata: " << meta_path << std::endl;
+            return false;
+        }
+    }
+
+    flight_ids.clear();
+    flight_index.clear();
+    std::ifstream flights(directory + "/flights.txt");
+    std::string line;
+    while (std::getline(flights, line)) {
+        flight_index.emplace(line, static_cast<uint32_t>(flight_ids.size()));
+        flight_ids.push_back(line);
+    }
+    flights_persisted = flight_ids.size();
+
+    std::cout << "[INFO] Opened trajectory store " << directory << " (" << flight_ids.size() << " flights)" << std::endl;
+    return true;
+}
+
+bool ColumnarTrajectoryStore::append(const std::string& flight_id, const std::vector<WaypointComplete>& waypoints,
+                                     double start_timestamp) {
+    if (flight_id.empty() || flight_id.find('\n') != std::string::npos) {
+        std::cerr << "[ERROR] Invalid flight id for trajectory store: " << flight_id << std::endl;
+        return false;
+    }
+
+    auto it = flight_index.find(flight_id);
+    if (it == flight_index.end()) {
+        it = flight_index.emplace(flight_id, static_cast<uint32_t>(flight_ids.size())).first;
+        flight_ids.push_back(flight_id);
+    }
+    const uint32_t flight = it->second;
+
+    for (const auto& w : waypoints) {
+        const double t = start_timestamp + w.time;
+        PartitionKey key(static_cast<int64_t>(std::floor(t / 86400.0)),
+                         static_cast<int32_t>(std::floor(w.lat / cell_size)),
+                         static_cast<int32_t>(std::floor(w.lon / cell_size)));
+        Rows& rows = pending[key];
+        rows.flight.push_back(flight);
+        rows.time.push_back(t);
+        rows.lat.push_back(w.lat);
+        rows.lon.push_back(w.lon);
+        rows.alt.push_back(w.h);
+    }
+    pending_rows += waypoints.size();
+
+    return pending_rows < AUTO_FLUSH_ROWS || flush();
+}
+
+std::string ColumnarTrajectoryStore::partitionPath(const PartitionKey& key) const {
+    std::time_t day_start = static_cast<std::time_t>(std::get<0>(key) * 86400);
+    std::tm tm;
+    gmtime_r(&day_start, &tm);
+    char day[16];
+    std::strftime(day, sizeof(day), "%Y-%m-%d", &tm);
+    return directory + "/" + day + "/" + std::to_string(std::get<1>(key)) + "_" + std::to_string(std::get<2>(key)) + ".col";
+}
+
+bool ColumnarTrajectoryStore::writePartition(const PartitionKey& key, Rows& rows) {
+    // Time-sorted rows give tight time zone maps per block
+    const size_t n = rows.time.size();
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return rows.time[a] < rows.time[b]; });
+
+    std::string out;
+    for (size_t begin = 0; begin < n; begin += block_rows) {
+        const uint32_t count = static_cast<uint32_t>(std::min<size_t>(block_rows, n - begin));
+
+        std::string payload(payloadBytes(count), '\0');
+        uint32_t* flight = reinterpret_cast<uint32_t*>(&payload[0]);
+        double* time = reinterpret_cast<double*>(&payload[flightColumnBytes(count)]);
+        double* lat = time + count;
+        double* lon = lat + count;
+        double* alt = lon + count;
+
+        BlockHeader header;
+        std::memcpy(header.magic, BLOCK_MAGIC, sizeof(BLOCK_MAGIC));
+        header.rows = count;
+        header.min_time = header.min_lat = header.min_lon = header.min_alt = std::numeric_limits<double>::max();
+        header.max_time = header.max_lat = header.max_lon = header.max_alt = std::numeric_limits<double>::lowest();
+
+        for (uint32_t r = 0; r < count; ++r) {
+            const uint32_t i = order[begin + r];
+            flight[r] = rows.flight[i];
+            time[r] = rows.time[i];
+            lat[r] = rows.lat[i];
+            lon[r] = rows.lon[i];
+            alt[r] = rows.alt[i];
+            header.min_time = std::min(header.min_time, time[r]);
+            header.max_time = std::max(header.max_time, time[r]);
+            header.min_lat = std::min(header.min_lat, lat[r]);
+            header.max_lat = std::max(header.max_lat, lat[r]);
+            header.min_lon = std::min(header.min_lon, lon[r]);
+            header.max_lon = std::max(header.max_lon, lon[r]);
+            header.min_alt = std::min(header.min_alt, alt[r]);
+            header.max_alt = std::max(header.max_alt, alt[r]);
+        }
+        header.crc = static_cast<uint32_t>(::crc32(0L, reinterpret_cast<const Bytef*>(payload.data()),
+                                                   static_cast<uInt>(payload.size())));
+
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out += payload;
+    }
+
+    const std::string path = partitionPath(key);
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    if (!appendFile(path, out)) {
+        std::cerr << "[ERROR] Cannot write trajectory partition: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ColumnarTrajectoryStore::flush() {
+    // New flight ids must be durable before any block that references them
+    if (flights_persisted < flight_ids.size()) {
+        std::string lines;
+        for (size_t i = flights_persisted; i < flight_ids.size(); ++i) {
+            lines += flight_ids[i];
+            lines.push_back('\n');
+        }
+        if (!appendFile(directory + "/flights.txt", lines)) {
+            std::cerr << "[ERROR] Cannot write flight dictionary: " << directory << "/flights.txt" << std::endl;
+            return false;
+        }
+        flights_persisted = flight_ids.size();
+    }
+
+    // Drop each partition as soon as it is on disk so that a retry after a failed
+    // write does not append the already written blocks again
+    size_t flushed_rows = pending_rows;
+    size_t flushed_partitions = pending.size();
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (!writePartition(it->first, it->second)) return false;
+        pending_rows -= it->second.time.size();
+        it = pending.erase(it);
+    }
+    std::cout << "[INFO] Flushed " << flushed_rows << " samples into " << flushed_partitions << " partitions" << std::endl;
+    pending_rows = 0;
+    return true;
+}
+
+void ColumnarTrajectoryStore::scanPartition(const std::string& path, const TrajectoryQuery& q,
+                                            std::map<uint32_t, std::vector<WaypointComplete>>& results,
+                                            TrajectoryQueryStats& stats) const {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return;
+    }
+    const uint64_t size = static_cast<uint64_t>(st.st_size);
+
+    std::vector<char> payload;
+    uint64_t offset = 0;
+    while (offset + sizeof(BlockHeader) <= size) {
+        BlockHeader header;
+        if (pread(fd, &header, sizeof(header), static_cast<off_t>(offset)) != static_cast<ssize_t>(sizeof(header)) ||
+            std::memcmp(header.magic, BLOCK_MAGIC, sizeof(BLOCK_MAGIC)) != 0) {
+            std::cerr << "[WARNING] Corrupt block in " << path << " at offset " << offset << std::endl;
+            break;
+        }
+        const size_t bytes = payloadBytes(header.rows);
+        if (offset + sizeof(header) + bytes > size) {
+            std::cerr << "[WARNING] Truncated block in " << path << " at offset " << offset << std::endl;
+            break;
+        }
+        const uint64_t payload_offset = offset + sizeof(header);
+        offset = payload_offset + bytes;
+        ++stats.blocks_total;
+
+        // Zone map pruning: the columns of a non-matching block are never read
+        if (!overlaps(header.min_time, header.max_time, q.t0, q.t1) ||
+            !overlaps(header.min_lat, header.max_lat, q.min_lat, q.max_lat) ||
+            !overlaps(header.min_lon, header.max_lon, q.min_lon, q.max_lon) ||
+            !overlaps(header.min_alt, header.max_alt, q.min_alt, q.max_alt)) {
+            continue;
+        }
+
+        payload.resize(bytes);
+        if (pread(fd, payload.data(), bytes, static_cast<off_t>(payload_offset)) != static_cast<ssize_t>(bytes) ||
+            static_cast<uint32_t>(::crc32(0L, reinterpret_cast<const Bytef*>(payload.data()), static_cast<uInt>(bytes))) != header.crc) {
+            std::cerr << "[WARNING] Block CRC mismatch in " << path << ", skipping" << std::endl;
+            continue;
+        }
+        ++stats.blocks_read;
+        stats.rows_read += header.rows;
+
+        const uint32_t n = header.rows;
+        const uint32_t* flight = reinterpret_cast<const uint32_t*>(payload.data());
+        const double* time = reinterpret_cast<const double*>(payload.data() + flightColumnBytes(n));
+        const double* lat = time + n;
+        const double* lon = lat + n;
+        const double* alt = lon + n;
+
+        for (uint32_t r = 0; r < n; ++r) {
+            if (time[r] >= q.t0 && time[r] <= q.t1 &&
+                lat[r] >= q.min_lat && lat[r] <= q.max_lat &&
+                lon[r] >= q.min_lon && lon[r] <= q.max_lon &&
+                alt[r] >= q.min_alt && alt[r] <= q.max_alt) {
+                results[flight[r]].push_back({lat[r], lon[r], alt[r], time[r]});
+                ++stats.rows_matched;
+            }
+        }
+    }
+    ::close(fd);
+}
+
+std::vector<FlightSamples> ColumnarTrajectoryStore::query(const TrajectoryQuery& q, TrajectoryQueryStats* stats_out) const {
+    TrajectoryQueryStats stats;
+    std::map<uint32_t, std::vector<WaypointComplete>> results;
+
+    std::error_code ec;
+    for (const auto& day_entry : fs::directory_iterator(directory, ec)) {
+        if (!day_entry.is_directory()) continue;
+
+        // Day pruning from the partition directory name (UTC day)
+        const std::string day = day_entry.path().filename().string() + "T00:00:00";
+        long long day_start;
+        if (!parseIsoTimestamp(day.data(), day.size(), day_start)) continue;
+
+        const bool day_matches = overlaps(static_cast<double>(day_start), static_cast<double>(day_start + 86400), q.t0, q.t1);
+        for (const auto& cell_entry : fs::directory_iterator(day_entry.path(), ec)) {
+            if (cell_entry.path().extension() != ".col") continue;
+            ++stats.partitions_total;
+            if (!day_matches) continue;
+
+            // Cell pruning from the file name
+            int cy, cx;
+            if (std::sscanf(cell_entry.path().filename().c_str(), "%d_%d.col", &cy, &cx) != 2) continue;
+            if (!overlaps(cy * cell_size, (cy + 1) * cell_size, q.min_lat, q.max_lat) ||
+                !overlaps(cx * cell_size, (cx + 1) * cell_size, q.min_lon, q.max_lon)) {
+                continue;
+            }
+
+            ++stats.partitions_scanned;
+            scanPartition(cell_entry.path().string(), q, results, stats);
+        }
+    }
+
+    std::vector<FlightSamples> flights;
+    flights.reserve(results.size());
+    for (auto& entry : results) {
+        std::sort(entry.second.begin(), entry.second.end(),
+                  [](const WaypointComplete& a, const WaypointComplete& b) { return a.time < b.time; });
+        FlightSamples samples;
+        samples.id = entry.first < flight_ids.size() ? flight_ids[entry.first] : std::to_string(entry.first);
+        samples.samples = std::move(entry.second);
+        flights.push_back(std::move(samples));
+    }
+
+    if (stats_out) *stats_out = stats;
+    return flights;
+}
+
+} // namespace UPlanGeneration
@@ -0,0 +1,101 @@
+#ifndef COLUMNAR_TRAJECTORY_STORE_H
+#define COLUMNAR_TRAJECTORY_STORE_H
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "UplanGeneratorComplete.h"
+
+namespace UPlanGeneration {
+
+// Predicado de consulta: ventana temporal (unix timestamp) + bbox (+ banda de altitud opcional)
+struct TrajectoryQuery {
+    double t0 = std::numeric_limits<double>::lowest();
+    double t1 = std::numeric_limits<double>::max();
+    double min_lon = -180.0;
+    double min_lat = -90.0;
+    double max_lon = 180.0;
+    double max_lat = 90.0;
+    double min_alt = std::numeric_limits<double>::lowest();
+    double max_alt = std::numeric_limits<double>::max();
+};
+
+struct TrajectoryQueryStats {
+    size_t partitions_total = 0;
+    size_t partitions_scanned = 0;
+    size_t blocks_total = 0;
+    size_t blocks_read = 0;
+    size_t rows_read = 0;
+    size_t rows_matched = 0;
+};
+
+// Muestras de un vuelo que cumplen el predicado, ordenadas por tiempo.
+// WaypointComplete::time es aquí un unix timestamp (usar start_timestamp = 0 al generar).
+struct FlightSamples {
+    std::string id;
+    std::vector<WaypointComplete> samples;
+};
+
+// Almacén histórico de trayectorias en disco, columnar y particionado:
+//
+//  <dir>/store.json                 tamaño de celda y filas por bloque
+//  <dir>/flights.txt                diccionario de vuelos (una línea por id)
+//  <dir>/YYYY-MM-DD/<cy>_<cx>.col   partición (día UTC, celda de rejilla)
+//
+// Cada partición es una secuencia append-only de bloques; cada bloque lleva en su
+// cabecera un zone map (min/max de tiempo, lat, lon y altitud) y sus columnas
+// (vuelo, tiempo, lat, lon, alt) contiguas con CRC32. Las consultas descartan primero
+// particiones por día/celda, luego bloques por zone map (sin leer sus columnas) y sólo
+// filtran fila a fila los bloques que pueden contener resultados.
+class ColumnarTrajectoryStore {
+public:
+    explicit ColumnarTrajectoryStore(const std::string& directory, double cell_size_deg = 0.1, uint32_t block_rows = 8192);
+
+    // Abre (o crea) el almacén y carga el diccionario de vuelos
+    bool open();
+
+    // Añade las muestras de un vuelo (tiempos relativos a start_timestamp).
+    // Se acumulan en memoria hasta flush().
+    bool append(const std::string& flight_id, const std::vector<WaypointComplete>& waypoints, double start_timestamp);
+
+    // Escribe a disco (durable) todas las muestras pendientes
+    bool flush();
+
+    // Vuelos con muestras dentro del predicado (sólo las muestras que lo cumplen).
+    // Sólo ve lo ya escrito con flush().
+    std::vector<FlightSamples> query(const TrajectoryQuery& query, TrajectoryQueryStats* stats = nullptr) const;
+
+    size_t flightCount() const { return flight_ids.size(); }
+    size_t pendingRows() const { return pending_rows; }
+
+private:
+    struct Rows {
+        std::vector<uint32_t> flight;
+        std::vector<double> time, lat, lon, alt;
+    };
+    using PartitionKey = std::tuple<int64_t, int32_t, int32_t>;   // día, celda lat, celda lon
+
+    std::string directory;
+    double cell_size;
+    uint32_t block_rows;
+
+    std::vector<std::string> flight_ids;
+    std::unordered_map<std::string, uint32_t> flight_index;
+    size_t flights_persisted = 0;
+
+    std::map<PartitionKey, Rows> pending;
+    size_t pending_rows = 0;
+
+    std::string partitionPath(const PartitionKey& key) const;
+    bool writePartition(const PartitionKey& key, Rows& rows);
+    void scanPartition(const std::string& path, const TrajectoryQuery& query,
+                       std::map<uint32_t, std::vector<WaypointComplete>>& results, TrajectoryQueryStats& stats) const;
+};
+
+} // namespace UPlanGeneration
+
+#endif // COLUMNAR_TRAJECTORY_STORE_H
@@ -0,0 +1,228 @@
+#include "CzmlWriter.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <limits>
+
+namespace UPlanGeneration {
+
+namespace {
+
+const size_t FLUSH_THRESHOLD = 1 << 20;
+const double METERS_PER_DEG_LAT = 110540.0;
+const double METERS_PER_DEG_LON = 111320.0;   // at the equator, scaled by cos(lat)
+
+void appendNumber(std::string& out, double value, int decimals) {
+    char buf[64];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, decimals);
+    char* end = result.ptr;
+    // Trim trailing zeros (and the dot) to keep the stream small
+    if (decimals > 0) {
+        while (end > buf && end[-1] == '0') --end;
+        if (end > buf && end[-1] == '.') --end;
+    }
+    if (end - buf == 2 && buf[0] == '-' && buf[1] == '0') {
+        out.push_back('0');
+        return;
+    }
+    out.append(buf, end);
+}
+
+void appendString(std::string& out, const std::string& s) {
+    out.push_back('"');
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char esc[8];
+                std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out += esc;
+            } else {
+                out.push_back(c);
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+// ISO 8601 UTC with whole seconds
+void appendIso(std::string& out, long long timestamp) {
+    std::time_t t = static_cast<std::time_t>(timestamp);
+    std::tm tm;
+    gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    out += buf;
+}
+
+void appendInterval(std::string& out, long long begin, long long end) {
+    out.push_back('"');
+    appendIso(out, begin);
+    out.push_back('/');
+    appendIso(out, end);
+    out.push_back('"');
+}
+
+// Synchronized euclidean distance: how far p is from where the straight a->b
+// motion would put the aircraft at p's time
+double syncDistance(const WaypointComplete& a, const WaypointComplete& b, const WaypointComplete& p) {
+    double span = b.time - a.time;
+    double f = span > 0.0 ? (p.time - a.time) / span : 0.0;
+    double lat = a.lat + (b.lat - a.lat) * f;
+    double lon = a.lon + (b.lon - a.lon) * f;
+    double h = a.h + (b.h - a.h) * f;
+    double dx = (p.lon - lon) * METERS_PER_DEG_LON * std::cos(p.lat * M_PI / 180.0);
+    double dy = (p.lat - lat) * METERS_PER_DEG_LAT;
+    double dz = p.h - h;
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+} // namespace
+
+std::vector<size_t> decimateTrajectory(const std::vector<WaypointComplete>& wp, double tolerance) {
+    std::vector<size_t> kept;
+    if (wp.size() <= 2) {
+        for (size_t i = 0; i < wp.size(); ++i) kept.push_back(i);
+        return kept;
+    }
+
+    std::vector<char> keep(wp.size(), 0);
+    keep.front() = keep.back() = 1;
+
+    // Iterative Douglas-Peucker (explicit stack: trajectories can have 100k+ samples)
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.emplace_back(0, wp.size() - 1);
+    while (!stack.empty()) {
+        auto [first, last] = stack.back();
+        stack.pop_back();
+        double worst = -1.0;
+        size_t worst_index = first;
+        for (size_t k = first + 1; k < last; ++k) {
+            double d = syncDistance(wp[first], wp[last], wp[k]);
+            if (d > worst) {
+                worst = d;
+                worst_index = k;
+            }
+        }
+        if (worst > tolerance) {
+            keep[worst_index] = 1;
+            if (worst_index - first > 1) stack.emplace_back(first, worst_index);
+            if (last - worst_index > 1) stack.emplace_back(worst_index, last);
+        }
+    }
+
+    for (size_t i = 0; i < wp.size(); ++i) {
+        if (keep[i]) kept.push_back(i);
+    }
+    return kept;
+}
+
+CzmlWriter::CzmlWriter(std::ostream& out, const CzmlOptions& options)
+    : out(out), options(options),
+      clock_start(std::numeric_limits<double>::max()),
+      clock_end(std::numeric_limits<double>::lowest()) {}
+
+void CzmlWriter::flush() {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+void CzmlWriter::begin(const std::string& name) {
+    buffer += "[\n{\"id\":\"document\",\"name\":";
+    appendString(buffer, name);
+    buffer += ",\"version\":\"1.0\"}";
+    flush();
+}
+
+void CzmlWriter::addFlight(const std::string& id, const std::string& name,
+                           const std::vector<WaypointComplete>& waypoints, double start_timestamp,
+                           const std::vector<VolumeRecord>& volumes) {
+    if (waypoints.empty()) return;
+
+    const bool agl = options.altitude_reference == "AGL";
+    const std::vector<size_t> kept = decimateTrajectory(waypoints, options.tolerance);
+
+    const long long epoch = static_cast<long long>(std::floor(start_timestamp + waypoints.front().time));
+    const long long end = static_cast<long long>(std::ceil(start_timestamp + waypoints.back().time));
+    clock_start = std::min(clock_start, static_cast<double>(epoch));
+    clock_end = std::max(clock_end, static_cast<double>(end));
+
+    buffer += ",\n{\"id\":";
+    appendString(buffer, id);
+    buffer += ",\"name\":";
+    appendString(buffer, name);
+    buffer += ",\"availability\":";
+    appendInterval(buffer, epoch, end);
+    buffer += ",\"position\":{\"epoch\":\"";
+    appendIso(buffer, epoch);
+    buffer += "\",\"interpolationAlgorithm\":\"LINEAR\",\"cartographicDegrees\":[";
+    for (size_t n = 0; n < kept.size(); ++n) {
+        const WaypointComplete& w = waypoints[kept[n]];
+        if (n) buffer.push_back(',');
+        appendNumber(buffer, start_timestamp + w.time - static_cast<double>(epoch), 3);
+        buffer.push_back(',');
+        appendNumber(buffer, w.lon, 7);
+        buffer.push_back(',');
+        appendNumber(buffer, w.lat, 7);
+        buffer.push_back(',');
+        appendNumber(buffer, w.h, 2);
+    }
+    buffer += "]},\"point\":{\"pixelSize\":6,\"color\":{\"rgba\":[255,200,0,255]}";
+    if (agl) buffer += ",\"heightReference\":\"RELATIVE_TO_GROUND\"";
+    buffer += "},\"path\":{\"width\":2,\"leadTime\":0,\"trailTime\":600,\"resolution\":5,"
+              "\"material\":{\"solidColor\":{\"color\":{\"rgba\":[255,200,0,200]}}}}}";
+    samples += kept.size();
+    ++flights;
+
+    if (options.write_volumes) {
+        for (const auto& v : volumes) {
+            buffer += ",\n{\"id\":";
+            appendString(buffer, id + "/volume/" + std::to_string(v.ordinal));
+            buffer += ",\"parent\":";
+            appendString(buffer, id);
+            buffer += ",\"availability\":";
+            appendInterval(buffer, v.time_begin, v.time_end);
+            buffer += ",\"polygon\":{\"positions\":{\"cartographicDegrees\":[";
+            for (int k = 0; k < 4; ++k) {
+                if (k) buffer.push_back(',');
+                appendNumber(buffer, v.corner_lon[k], 7);
+                buffer.push_back(',');
+                appendNumber(buffer, v.corner_lat[k], 7);
+                buffer += ",0";
+            }
+            buffer += "]},\"height\":";
+            appendNumber(buffer, v.min_alt, 2);
+            buffer += ",\"extrudedHeight\":";
+            appendNumber(buffer, v.max_alt, 2);
+            if (agl) buffer += ",\"heightReference\":\"RELATIVE_TO_GROUND\",\"extrudedHeightReference\":\"RELATIVE_TO_GROUND\"";
+            buffer += ",\"material\":{\"solidColor\":{\"color\":{\"rgba\":[0,153,255,90]}}},\"outline\":false}}";
+            if (buffer.size() >= FLUSH_THRESHOLD) flush();
+        }
+    }
+    flush();
+}
+
+void CzmlWriter::finish() {
+    if (flights > 0) {
+        // The scenario interval is only known now: a later "document" packet updates the clock
+        const long long begin = static_cast<long long>(clock_start);
+        const long long end = static_cast<long long>(clock_end);
+        buffer += ",\n{\"id\":\"document\",\"clock\":{\"interval\":";
+        appendInterval(buffer, begin, end);
+        buffer += ",\"currentTime\":\"";
+        appendIso(buffer, begin);
+        buffer += "\",\"multiplier\":10,\"range\":\"LOOP_STOP\",\"step\":\"SYSTEM_CLOCK_MULTIPLIER\"}}";
+    }
+    buffer += "\n]\n";
+    flush();
+    out.flush();
+}
+
+} // namespace UPlanGeneration
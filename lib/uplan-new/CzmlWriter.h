@@ -0,0 +1,61 @@
+#ifndef CZML_WRITER_H
+#define CZML_WRITER_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "UplanGeneratorComplete.h"
+#include "VolumeRecord.h"
+
+namespace UPlanGeneration {
+
+struct CzmlOptions {
+    double tolerance = 2.0;                  // error máximo de la trayectoria decimada (m)
+    std::string altitude_reference = "AGL";  // AGL -> alturas relativas al terreno en Cesium
+    bool write_volumes = true;               // entidades de volumen con su intervalo de disponibilidad
+};
+
+// Índices de los waypoints que se conservan al decimar una trayectoria: ningún punto
+// descartado se aleja más de tolerance metros de la posición interpolada linealmente
+// en el tiempo entre los puntos conservados (Douglas-Peucker con distancia sincronizada).
+// El primero y el último se conservan siempre.
+std::vector<size_t> decimateTrajectory(const std::vector<WaypointComplete>& waypoints, double tolerance);
+
+// Escritor CZML en streaming para reproducir escenarios en Cesium: cada vuelo se
+// escribe como un paquete con posición muestreada (waypoints decimados) y, opcionalmente,
+// un paquete por volumen con su ventana temporal. No se construye ningún DOM JSON;
+// cada paquete se serializa y se vuelca al stream en cuanto se añade el vuelo.
+class CzmlWriter {
+public:
+    CzmlWriter(std::ostream& out, const CzmlOptions& options = CzmlOptions());
+
+    // Paquete "document" (siempre el primero)
+    void begin(const std::string& name);
+
+    // Añade un vuelo. Los tiempos de los waypoints son relativos a start_timestamp.
+    void addFlight(const std::string& id, const std::string& name,
+                   const std::vector<WaypointComplete>& waypoints, double start_timestamp,
+                   const std::vector<VolumeRecord>& volumes = {});
+
+    // Cierra el array; añade el reloj del escenario (intervalo total de los vuelos escritos)
+    void finish();
+
+    size_t flightCount() const { return flights; }
+    size_t sampleCount() const { return samples; }
+
+private:
+    std::ostream& out;
+    CzmlOptions options;
+    std::string buffer;
+    size_t flights = 0;
+    size_t samples = 0;
+    double clock_start;
+    double clock_end;
+
+    void flush();
+};
+
+} // namespace UPlanGeneration
+
+#endif // CZML_WRITER_H
@@ -0,0 +1,254 @@
+#include "DemTileCache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace UPlanGeneration {
+
+namespace {
+
+const int16_t SRTM_VOID = -32768;
+const int16_t EMPTY_MIN = INT16_MAX;   // pyramid cell with only voids
+const int16_t EMPTY_MAX = INT16_MIN;
+
+int64_t tileKey(int lat_deg, int lon_deg) {
+    return (static_cast<int64_t>(lat_deg) << 32) ^ static_cast<uint32_t>(lon_deg);
+}
+
+} // namespace
+
+struct DemTileCache::Tile {
+    int lat_deg = 0;             // south-west corner
+    int lon_deg = 0;
+    int n = 0;                   // samples per side (1201 or 3601)
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    // level k (k >= 1) at index k-1: dims[k-1] x dims[k-1] cells of 2^k x 2^k pixels
+    std::vector<int> dims;
+    std::vector<std::vector<int16_t>> level_min;
+    std::vector<std::vector<int16_t>> level_max;
+
+    ~Tile() {
+        if (data) munmap(const_cast<unsigned char*>(data), size);
+    }
+
+    int16_t raw(int row, int col) const {
+        // SRTM samples are big-endian int16, row 0 = north edge
+        const unsigned char* p = data + (static_cast<size_t>(row) * n + col) * 2;
+        return static_cast<int16_t>((p[0] << 8) | p[1]);
+    }
+
+    void buildPyramid() {
+        int prev_dim = n;
+        for (int k = 1; prev_dim > 1; ++k) {
+            int dim = (prev_dim + 1) / 2;
+            std::vector<int16_t> mins(static_cast<size_t>(dim) * dim, EMPTY_MIN);
+            std::vector<int16_t> maxs(static_cast<size_t>(dim) * dim, EMPTY_MAX);
+            for (int r = 0; r < prev_dim; ++r) {
+                for (int c = 0; c < prev_dim; ++c) {
+                    int16_t lo, hi;
+                    if (k == 1) {
+                        lo = hi = raw(r, c);
+                        if (lo == SRTM_VOID) continue;
+                    } else {
+                        size_t src = static_cast<size_t>(r) * prev_dim + c;
+                        lo = level_min.back()[src];
+                        hi = level_max.back()[src];
+                    }
+                    size_t dst = static_cast<size_t>(r / 2) * dim + c / 2;
+                    mins[dst] = std::min(mins[dst], lo);
+                    maxs[dst] = std::max(maxs[dst], hi);
+                }
+            }
+            dims.push_back(dim);
+            level_min.push_back(std::move(mins));
+            level_max.push_back(std::move(maxs));
+            prev_dim = dim;
+        }
+    }
+
+    // Min/max over the inclusive pixel window using at most 2x2 cells of one level
+    bool range(int r0, int r1, int c0, int c1, int16_t& lo, int16_t& hi) const {
+        int span = std::max(r1 - r0, c1 - c0) + 1;
+        int k = 0;
+        while ((1 << k) < span) ++k;
+
+        lo = EMPTY_MIN;
+        hi = EMPTY_MAX;
+        for (int r = r0 >> k; r <= (r1 >> k); ++r) {
+            for (int c = c0 >> k; c <= (c1 >> k); ++c) {
+                if (k == 0) {
+                    int16_t v = raw(r, c);
+                    if (v == SRTM_VOID) continue;
+                    lo = std::min(lo, v);
+                    hi = std::max(hi, v);
+                } else {
+                    size_t idx = static_cast<size_t>(r) * dims[k - 1] + c;
+                    lo = std::min(lo, level_min[k - 1][idx]);
+                    hi = std::max(hi, level_max[k - 1][idx]);
+                }
+            }
+        }
+        return lo <= hi;
+    }
+};
+
+DemTileCache::DemTileCache(const std::string& directory, size_t max_tiles)
+    : directory(directory), max_tiles(std::max<size_t>(1, max_tiles)) {}
+
+DemTileCache::~DemTileCache() = default;
+
+std::string DemTileCache::tileName(int lat_deg, int lon_deg) const {
+    // Worst case for any int: "S-2147483648W-2147483648.hgt"
+    char name[32];
+    std::snprintf(name, sizeof(name), "%c%02d%c%03d.hgt",
+                  lat_deg >= 0 ? 'N' : 'S', std::abs(lat_deg),
+                  lon_deg >= 0 ? 'E' : 'W', std::abs(lon_deg));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+std::shared_ptr<DemTileCache::Tile> DemTileCache::loadTile(int lat_deg, int lon_deg) {
+    std::string path = tileName(lat_deg, lon_deg);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[WARNING] DEM tile not found: " << path << std::endl;
+        return nullptr;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = static_cast<size_t>(st.st_size);
+    int n = 0;
+    if (size == 3601u * 3601u * 2u) n = 3601;
+    else if (size == 1201u * 1201u * 2u) n = 1201;
+    if (n == 0) {
+        std::cerr << "[ERROR] Unsupported DEM tile size (" << size << " bytes): " << path << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "[ERROR] Cannot mmap DEM tile " << path << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    auto t = std::make_shared<Tile>();
+    t->lat_deg = lat_deg;
+    t->lon_deg = lon_deg;
+    t->n = n;
+    t->data = static_cast<const unsigned char*>(base);
+    t->size = size;
+    t->buildPyramid();
+
+    std::cout << "[INFO] Loaded DEM tile: " << path << " (" << n << "x" << n << ")" << std::endl;
+    return t;
+}
+
+std::shared_ptr<DemTileCache::Tile> DemTileCache::tile(int lat_deg, int lon_deg) {
+    int64_t key = tileKey(lat_deg, lon_deg);
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = tiles.find(key);
+    if (it != tiles.end()) {
+        lru.splice(lru.begin(), lru, it->second.second);
+        return it->second.first;
+    }
+    if (missing.count(key)) return nullptr;
+
+    auto pending = loading.find(key);
+    if (pending != loading.end()) {
+        // Another worker is loading this tile: wait for it without holding the cache
+        std::shared_future<std::shared_ptr<Tile>> result = pending->second;
+        lock.unlock();
+        return result.get();
+    }
+    std::promise<std::shared_ptr<Tile>> loaded;
+    loading.emplace(key, loaded.get_future().share());
+    lock.unlock();
+
+    // mmap + pyramid build outside the lock: other tiles stay available meanwhile
+    std::shared_ptr<Tile> t = loadTile(lat_deg, lon_deg);
+
+    lock.lock();
+    loading.erase(key);
+    if (!t) {
+        missing[key] = true;
+    } else {
+        if (tiles.size() >= max_tiles) {
+            // Tiles still referenced by a caller stay mapped until released
+            tiles.erase(lru.back());
+            lru.pop_back();
+        }
+        lru.push_front(key);
+        tiles[key] = {t, lru.begin()};
+    }
+    lock.unlock();
+    loaded.set_value(t);
+    return t;
+}
+
+bool DemTileCache::heightRange(double min_lon, double min_lat, double max_lon, double max_lat,
+                               double& min_height, double& max_height) {
+    int16_t lo = EMPTY_MIN;
+    int16_t hi = EMPTY_MAX;
+
+    int lat0 = static_cast<int>(std::floor(min_lat));
+    int lat1 = static_cast<int>(std::floor(max_lat));
+    int lon0 = static_cast<int>(std::floor(min_lon));
+    int lon1 = static_cast<int>(std::floor(max_lon));
+
+    for (int lat_deg = lat0; lat_deg <= lat1; ++lat_deg) {
+        for (int lon_deg = lon0; lon_deg <= lon1; ++lon_deg) {
+            std::shared_ptr<Tile> t = tile(lat_deg, lon_deg);
+            if (!t) return false;
+
+            double scale = t->n - 1;
+            double south = std::max(min_lat, static_cast<double>(lat_deg));
+            double north = std::min(max_lat, static_cast<double>(lat_deg + 1));
+            double west = std::max(min_lon, static_cast<double>(lon_deg));
+            double east = std::min(max_lon, static_cast<double>(lon_deg + 1));
+
+            int r0 = std::clamp(static_cast<int>(std::floor((lat_deg + 1 - north) * scale)), 0, t->n - 1);
+            int r1 = std::clamp(static_cast<int>(std::ceil((lat_deg + 1 - south) * scale)), 0, t->n - 1);
+            int c0 = std::clamp(static_cast<int>(std::floor((west - lon_deg) * scale)), 0, t->n - 1);
+            int c1 = std::clamp(static_cast<int>(std::ceil((east - lon_deg) * scale)), 0, t->n - 1);
+
+            int16_t tlo, thi;
+            if (t->range(r0, r1, c0, c1, tlo, thi)) {
+                lo = std::min(lo, tlo);
+                hi = std::max(hi, thi);
+            }
+        }
+    }
+
+    if (lo > hi) return false;  // only voids
+    min_height = lo;
+    max_height = hi;
+    return true;
+}
+
+bool DemTileCache::elevationAt(double lat, double lon, double& height) {
+    int lat_deg = static_cast<int>(std::floor(lat));
+    int lon_deg = static_cast<int>(std::floor(lon));
+    std::shared_ptr<Tile> t = tile(lat_deg, lon_deg);
+    if (!t) return false;
+
+    double scale = t->n - 1;
+    int row = std::clamp(static_cast<int>(std::lround((lat_deg + 1 - lat) * scale)), 0, t->n - 1);
+    int col = std::clamp(static_cast<int>(std::lround((lon - lon_deg) * scale)), 0, t->n - 1);
+    int16_t v = t->raw(row, col);
+    if (v == SRTM_VOID) return false;
+    height = v;
+    return true;
+}
+
+} // namespace UPlanGeneration
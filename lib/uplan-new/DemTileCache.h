@@ -0,0 +1,58 @@
+#ifndef DEM_TILE_CACHE_H
+#define DEM_TILE_CACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include <future>
+
+namespace UPlanGeneration {
+
+// Caché de teselas DEM SRTM (.hgt, 1" o 3") mapeadas con mmap y con desalojo LRU.
+//
+// Al cargar una tesela se precalcula una pirámide de mínimos/máximos (el nivel k
+// agrupa bloques de 2^k x 2^k píxeles), de modo que el rango de alturas de un
+// rectángulo se obtiene leyendo como mucho 2x2 celdas del nivel adecuado en lugar
+// de recorrer todos los píxeles cubiertos. El resultado es conservador: el mínimo
+// puede ser algo menor y el máximo algo mayor que los reales.
+class DemTileCache {
+public:
+    explicit DemTileCache(const std::string& directory, size_t max_tiles = 16);
+    ~DemTileCache();
+
+    DemTileCache(const DemTileCache&) = delete;
+    DemTileCache& operator=(const DemTileCache&) = delete;
+
+    // Altura mínima y máxima del terreno (m AMSL) en el rectángulo lon/lat dado
+    bool heightRange(double min_lon, double min_lat, double max_lon, double max_lat,
+                     double& min_height, double& max_height);
+
+    // Altura del terreno (m AMSL) en el punto (muestra más cercana)
+    bool elevationAt(double lat, double lon, double& height);
+
+private:
+    struct Tile;
+
+    std::string directory;
+    size_t max_tiles;
+    std::mutex mutex;
+    std::list<int64_t> lru;    // más reciente al principio
+    std::unordered_map<int64_t, std::pair<std::shared_ptr<Tile>, std::list<int64_t>::iterator>> tiles;
+    std::unordered_map<int64_t, bool> missing;  // teselas sin fichero (no reintentar)
+    // Teselas cargándose: la carga (mmap y pirámide) se hace fuera del mutex y los
+    // demás hilos que piden la misma tesela esperan a su resultado
+    std::unordered_map<int64_t, std::shared_future<std::shared_ptr<Tile>>> loading;
+
+    std::shared_ptr<Tile> tile(int lat_deg, int lon_deg);
+    std::shared_ptr<Tile> loadTile(int lat_deg, int lon_deg);
+    std::string tileName(int lat_deg, int lon_deg) const;
+};
+
+} // namespace UPlanGeneration
+
+#endif // DEM_TILE_CACHE_H
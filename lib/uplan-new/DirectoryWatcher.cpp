@@ -0,0 +1,125 @@
+#include "DirectoryWatcher.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace UPlanGeneration {
+
+DirectoryWatcher::DirectoryWatcher(const std::string& directory, const std::string& extension,
+                                   std::chrono::milliseconds debounce)
+    : directory(directory), extension(extension), debounce(debounce) {}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    if (inotify_fd >= 0) ::close(inotify_fd);
+}
+
+bool DirectoryWatcher::matches(const std::string& name) const {
+    // Hidden/temporary files (".name.csv.tmp", editor swap files) are ignored
+    return !name.empty() && name[0] != '.' && fs::path(name).extension() == extension;
+}
+
+void DirectoryWatcher::scan(const FileCallback& onFile) const {
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file(ec) && matches(entry.path().filename().string())) {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto& file : files) onFile(file);
+}
+
+bool DirectoryWatcher::run(FileCallback onFile, bool include_existing, IdleCallback onIdle) {
+    inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        std::cerr << "[ERROR] inotify_init1 failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Watch before scanning so that no file written in between is missed
+    if (::inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+        std::cerr << "[ERROR] Cannot watch " << directory << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::cout << "[INFO] Watching " << directory << " for *" << extension << " files" << std::endl;
+    running = true;
+    if (include_existing) scan(onFile);
+
+    using Clock = std::chrono::steady_clock;
+    std::map<std::string, Clock::time_point> pending;   // file -> delivery deadline
+    alignas(inotify_event) char buffer[64 * 1024];
+    bool ok = true;
+
+    while (running) {
+        int timeout = 200;
+        auto now = Clock::now();
+        for (const auto& [name, deadline] : pending) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+            timeout = std::max(0, std::min(timeout, static_cast<int>(wait) + 1));
+        }
+
+        pollfd pfd{inotify_fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[ERROR] poll failed: " << std::strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+        if (ready == 0 && onIdle) onIdle();
+
+        if (ready > 0 && (pfd.revents & POLLIN)) {
+            ssize_t length;
+            bool gone = false;
+            while ((length = ::read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + length;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                    p += sizeof(inotify_event) + event->len;
+
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        std::cerr << "[WARNING] inotify queue overflow, rescanning " << directory << std::endl;
+                        scan(onFile);
+                        pending.clear();
+                    } else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                        gone = true;
+                    } else if (event->len > 0 && matches(event->name)) {
+                        // A new close/rename restarts the quiet period of that file
+                        pending[(fs::path(directory) / event->name).string()] = Clock::now() + debounce;
+                    }
+                }
+            }
+            if (gone) {
+                std::cerr << "[ERROR] Watched directory removed: " << directory << std::endl;
+                ok = false;
+                break;
+            }
+        }
+
+        now = Clock::now();
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->second <= now) {
+                onFile(it->first);
+                it = pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    ::close(inotify_fd);
+    inotify_fd = -1;
+    std::cout << "[INFO] Stopped watching " << directory << std::endl;
+    return ok;
+}
+
+} // namespace UPlanGeneration
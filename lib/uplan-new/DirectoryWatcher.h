@@ -0,0 +1,50 @@
+#ifndef DIRECTORY_WATCHER_H
+#define DIRECTORY_WATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+
+namespace UPlanGeneration {
+
+// Vigila una carpeta con inotify y entrega cada fichero nuevo con la extensión dada
+// cuando termina de escribirse (IN_CLOSE_WRITE, o IN_MOVED_TO para escritores que
+// renombran al terminar). Los eventos de un mismo fichero se agrupan: el fichero se
+// entrega cuando lleva `debounce` sin eventos nuevos.
+//
+// Si la cola de inotify desborda se vuelve a recorrer la carpeta y se entregan todos
+// los ficheros (el consumidor debe tolerar repeticiones, p. ej. con un BatchJournal).
+class DirectoryWatcher {
+public:
+    using FileCallback = std::function<void(const std::string& path)>;
+    using IdleCallback = std::function<void()>;
+
+    DirectoryWatcher(const std::string& directory, const std::string& extension = ".csv",
+                     std::chrono::milliseconds debounce = std::chrono::milliseconds(500));
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Bucle de vigilancia; retorna cuando se llama a stop() o hay un error fatal.
+    // Con include_existing se entregan primero los ficheros que ya estaban en la carpeta.
+    // onIdle (opcional) se llama cada vez que la espera termina sin eventos (como mucho
+    // cada 200 ms), p. ej. para volcar trabajo agrupado por tiempo.
+    bool run(FileCallback onFile, bool include_existing = true, IdleCallback onIdle = nullptr);
+    void stop() { running = false; }
+
+private:
+    std::string directory;
+    std::string extension;
+    std::chrono::milliseconds debounce;
+    int inotify_fd = -1;
+    std::atomic<bool> running{false};
+
+    bool matches(const std::string& name) const;
+    void scan(const FileCallback& onFile) const;
+};
+
+} // namespace UPlanGeneration
+
+#endif // DIRECTORY_WATCHER_H
@@ -0,0 +1,124 @@
+#include "FlightPlanLoadWriter.h"
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include "UplanFastReader.h"
+
+namespace UPlanGeneration {
+
+namespace {
+
+const char* NULL_FIELD = "\\N";
+
+// scheduledAt as a MySQL DATETIME literal in UTC
+std::string scheduledAt(const nlohmann::json& uplan) {
+    auto volumes = uplan.find("operationVolumes");
+    if (volumes == uplan.end() || !volumes->is_array() || volumes->empty()) return "";
+    auto begin = volumes->front().find("timeBegin");
+    if (begin == volumes->front().end() || !begin->is_string()) return "";
+
+    const std::string& text = begin->get_ref<const std::string&>();
+    long long timestamp;
+    if (!parseIsoTimestamp(text.data(), text.size(), timestamp)) return "";
+    std::time_t t = static_cast<std::time_t>(timestamp);
+    std::tm tm;
+    gmtime_r(&t, &tm);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+    return buffer;
+}
+
+} // namespace
+
+FlightPlanLoadWriter::FlightPlanLoadWriter(const std::string& path, const FlightPlanLoadOptions& options)
+    : path(path), options(options) {}
+
+FlightPlanLoadWriter::~FlightPlanLoadWriter() {
+    if (file.is_open()) close();
+}
+
+bool FlightPlanLoadWriter::open() {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "[ERROR] Cannot open file for writing: " << path << std::endl;
+        return false;
+    }
+    rows = 0;
+    return true;
+}
+
+void FlightPlanLoadWriter::appendField(std::string& out, const std::string& value) {
+    for (char c : value) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\0': out += "\\0"; break;
+            default: out += c;
+        }
+    }
+}
+
+bool FlightPlanLoadWriter::add(const std::string& name, const nlohmann::json& uplan) {
+    if (!file.is_open()) return false;
+
+    // customName, status, fileContent, csvResult, userId, folderId, uplan, scheduledAt
+    line.clear();
+    appendField(line, name);
+    line += '\t';
+    appendField(line, options.status);
+    line += '\t';
+    line += NULL_FIELD;
+    line += "\t0\t";
+    line += options.user_id > 0 ? std::to_string(options.user_id) : NULL_FIELD;
+    line += '\t';
+    line += options.folder_id > 0 ? std::to_string(options.folder_id) : NULL_FIELD;
+    line += '\t';
+    appendField(line, options.precision ? dumpWithPrecision(uplan, *options.precision) : uplan.dump());
+    line += '\t';
+    std::string scheduled = scheduledAt(uplan);
+    line += scheduled.empty() ? NULL_FIELD : scheduled;
+    line += '\n';
+
+    file.write(line.data(), static_cast<std::streamsize>(line.size()));
+    if (!file) {
+        std::cerr << "[ERROR] Cannot write flight plan row to " << path << std::endl;
+        return false;
+    }
+    ++rows;
+    return true;
+}
+
+std::string FlightPlanLoadWriter::loadStatement() const {
+    std::string quoted;
+    for (char c : std::filesystem::absolute(path).string()) {
+        if (c == '\'' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return "LOAD DATA LOCAL INFILE '" + quoted + "'\n"
+           "INTO TABLE flightplan CHARACTER SET utf8mb4\n"
+           "FIELDS TERMINATED BY '\\t' ESCAPED BY '\\\\'\n"
+           "LINES TERMINATED BY '\\n'\n"
+           "(customName, status, fileContent, csvResult, userId, folderId, uplan, scheduledAt);\n";
+}
+
+bool FlightPlanLoadWriter::close() {
+    if (!file.is_open()) return false;
+    file.close();
+    if (!file) {
+        std::cerr << "[ERROR] Cannot write flight plan load file: " << path << std::endl;
+        return false;
+    }
+
+    std::ofstream sql(path + ".sql");
+    sql << loadStatement();
+    if (!sql) {
+        std::cerr << "[ERROR] Cannot write " << path << ".sql" << std::endl;
+        return false;
+    }
+    std::cout << "[INFO] Wrote " << rows << " flight plans to " << path << " (load with " << path << ".sql)" << std::endl;
+    return true;
+}
+
+} // namespace UPlanGeneration
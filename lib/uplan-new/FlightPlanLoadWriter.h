@@ -0,0 +1,56 @@
+#ifndef FLIGHT_PLAN_LOAD_WRITER_H
+#define FLIGHT_PLAN_LOAD_WRITER_H
+
+#include <fstream>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "JsonPrecisionWriter.h"
+
+namespace UPlanGeneration {
+
+struct FlightPlanLoadOptions {
+    std::string status = "procesado";   // como en la importación de Uplans externos
+    int user_id = 0;                    // 0 -> NULL
+    int folder_id = 0;                  // 0 -> NULL
+    const JsonPrecision* precision = nullptr;   // precisión del JSON del Uplan (nullptr = completa)
+};
+
+// Fichero de carga masiva de planes generados para la tabla `flightplan` (MySQL):
+// una fila por plan en el formato por defecto de LOAD DATA (campos separados por
+// tabuladores, escapes con '\', NULL como \N) con las mismas columnas que rellena la
+// importación de Uplans externos de la API (customName, status, uplan, scheduledAt a
+// partir del timeBegin del primer volumen...). El id lo asigna la base de datos.
+//
+// close() escribe junto al fichero (<fichero>.sql) la sentencia LOAD DATA LOCAL INFILE
+// que lo carga en una sola operación, en lugar de crear los planes uno a uno por la API.
+class FlightPlanLoadWriter {
+public:
+    explicit FlightPlanLoadWriter(const std::string& path, const FlightPlanLoadOptions& options = FlightPlanLoadOptions());
+    ~FlightPlanLoadWriter();
+
+    FlightPlanLoadWriter(const FlightPlanLoadWriter&) = delete;
+    FlightPlanLoadWriter& operator=(const FlightPlanLoadWriter&) = delete;
+
+    bool open();
+    // Añade un plan (name = customName)
+    bool add(const std::string& name, const nlohmann::json& uplan);
+    // Cierra el fichero de datos y escribe la sentencia de carga
+    bool close();
+
+    size_t rowCount() const { return rows; }
+    std::string loadStatement() const;
+
+    // Escapa un campo para LOAD DATA (FIELDS ESCAPED BY '\\')
+    static void appendField(std::string& line, const std::string& value);
+
+private:
+    std::string path;
+    FlightPlanLoadOptions options;
+    std::ofstream file;
+    std::string line;
+    size_t rows = 0;
+};
+
+} // namespace UPlanGeneration
+
+#endif // FLIGHT_PLAN_LOAD_WRITER_H
@@ -0,0 +1,321 @@
+#include "GeozoneIndex.h"
+#include "UplanFastReader.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace UPlanGeneration {
+
+namespace {
+
+constexpr size_t MAX_ZONE_CELLS = 4096;
+constexpr int CIRCLE_VERTICES = 32;
+constexpr double METERS_PER_DEGREE = 111320.0;
+
+double orientation(double ax, double ay, double bx, double by, double cx, double cy) {
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+bool onSegment(double ax, double ay, double bx, double by, double px, double py) {
+    return std::min(ax, bx) <= px && px <= std::max(ax, bx) && std::min(ay, by) <= py && py <= std::max(ay, by);
+}
+
+// Closed segments, touching counts as intersecting
+bool segmentsIntersect(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+    double d1 = orientation(cx, cy, dx, dy, ax, ay);
+    double d2 = orientation(cx, cy, dx, dy, bx, by);
+    double d3 = orientation(ax, ay, bx, by, cx, cy);
+    double d4 = orientation(ax, ay, bx, by, dx, dy);
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) return true;
+    return (d1 == 0 && onSegment(cx, cy, dx, dy, ax, ay)) || (d2 == 0 && onSegment(cx, cy, dx, dy, bx, by)) ||
+           (d3 == 0 && onSegment(ax, ay, bx, by, cx, cy)) || (d4 == 0 && onSegment(ax, ay, bx, by, dx, dy));
+}
+
+// Even-odd rule over a closed ring
+bool pointInRing(const std::vector<double>& lon, const std::vector<double>& lat, double x, double y) {
+    bool inside = false;
+    for (size_t i = 0, j = lon.size() - 1; i < lon.size(); j = i++) {
+        if ((lat[i] > y) != (lat[j] > y) && x < (lon[j] - lon[i]) * (y - lat[i]) / (lat[j] - lat[i]) + lon[i]) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// The volume rectangle is convex: inside when on the same side of every edge
+bool pointInQuad(const VolumeRecord& volume, double x, double y) {
+    int sign = 0;
+    for (int i = 0; i < 4; ++i) {
+        int j = (i + 1) % 4;
+        double side = orientation(volume.corner_lon[i], volume.corner_lat[i], volume.corner_lon[j], volume.corner_lat[j], x, y);
+        if (side == 0) continue;
+        int s = side > 0 ? 1 : -1;
+        if (sign == 0) sign = s;
+        else if (s != sign) return false;
+    }
+    return true;
+}
+
+double toMeters(double value, const std::string& uom) {
+    return uom == "FT" || uom == "ft" ? value * 0.3048 : value;
+}
+
+const nlohmann::json* member(const nlohmann::json& object, const char* key) {
+    if (!object.is_object()) return nullptr;
+    auto it = object.find(key);
+    return it == object.end() || it->is_null() ? nullptr : &*it;
+}
+
+bool readTimestamp(const nlohmann::json& object, const char* key, const char* alternative, long long& timestamp) {
+    const nlohmann::json* value = member(object, key);
+    if (!value) value = member(object, alternative);
+    if (!value || !value->is_string()) return false;
+    const auto& text = value->get_ref<const std::string&>();
+    return parseIsoTimestamp(text.data(), text.size(), timestamp);
+}
+
+bool readRing(const nlohmann::json& coordinates, Geozone& zone) {
+    if (!coordinates.is_array() || coordinates.size() < 3) return false;
+    for (const auto& position : coordinates) {
+        if (!position.is_array() || position.size() < 2 || !position[0].is_number() || !position[1].is_number()) return false;
+        double lon = position[0].get<double>();
+        double lat = position[1].get<double>();
+        // Projected coordinates (e.g. EPSG:25830) are not supported
+        if (std::fabs(lon) > 180.0 || std::fabs(lat) > 90.0) return false;
+        zone.ring_lon.push_back(lon);
+        zone.ring_lat.push_back(lat);
+    }
+    if (zone.ring_lon.front() != zone.ring_lon.back() || zone.ring_lat.front() != zone.ring_lat.back()) {
+        zone.ring_lon.push_back(zone.ring_lon.front());
+        zone.ring_lat.push_back(zone.ring_lat.front());
+    }
+    return true;
+}
+
+void circleRing(double lon, double lat, double radius_m, Geozone& zone) {
+    double dlat = radius_m / METERS_PER_DEGREE;
+    double dlon = dlat / std::max(std::cos(lat * M_PI / 180.0), 1e-6);
+    for (int i = 0; i <= CIRCLE_VERTICES; ++i) {
+        // Circumscribed polygon so that the whole circle is covered
+        double angle = 2.0 * M_PI * (i % CIRCLE_VERTICES) / CIRCLE_VERTICES;
+        double scale = 1.0 / std::cos(M_PI / CIRCLE_VERTICES);
+        zone.ring_lon.push_back(lon + dlon * scale * std::cos(angle));
+        zone.ring_lat.push_back(lat + dlat * scale * std::sin(angle));
+    }
+}
+
+} // namespace
+
+const char* geozoneTypeName(GeozoneType type) {
+    switch (type) {
+        case GeozoneType::Prohibited: return "PROHIBITED";
+        case GeozoneType::ReqAuthorization: return "REQ_AUTHORIZATION";
+        case GeozoneType::Conditional: return "CONDITIONAL";
+    }
+    return "UNKNOWN";
+}
+
+GeozoneIndex::GeozoneIndex(double cell_deg) : cell_deg(cell_deg) {}
+
+bool GeozoneIndex::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "[ERROR] Cannot open geozones file: " << path << std::endl;
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // The geo-awareness response starts with '#' comment lines
+    size_t start = 0;
+    while ((start = text.find_first_not_of(" \t\r\n", start)) != std::string::npos && text[start] == '#') {
+        size_t end = text.find('\n', start);
+        start = end == std::string::npos ? text.size() : end + 1;
+    }
+    if (start == std::string::npos) start = text.size();
+    nlohmann::json document = nlohmann::json::parse(text.begin() + static_cast<std::ptrdiff_t>(start), text.end(),
+                                                     nullptr, false);
+    if (document.is_discarded()) {
+        std::cerr << "[ERROR] Invalid geozones JSON: " << path << std::endl;
+        return false;
+    }
+    if (!loadJson(document)) {
+        std::cerr << "[ERROR] No geozones found in: " << path << std::endl;
+        return false;
+    }
+    std::cout << "[INFO] Loaded " << zones.size() << " geozones from " << path << std::endl;
+    return true;
+}
+
+bool GeozoneIndex::loadJson(const nlohmann::json& document) {
+    zones.clear();
+    cells.clear();
+    large_zones.clear();
+
+    const nlohmann::json* features = &document;
+    if (const nlohmann::json* geozones = member(document, "geozones")) features = geozones;
+    if (const nlohmann::json* list = member(*features, "features")) features = list;
+    if (!features->is_array()) return false;
+
+    size_t skipped = 0;
+    for (const auto& feature : *features) {
+        if (!addFeature(feature)) ++skipped;
+    }
+    if (skipped > 0) {
+        std::cerr << "[WARNING] Skipped " << skipped << " geozones (no restriction or unsupported geometry)" << std::endl;
+    }
+    return !zones.empty();
+}
+
+bool GeozoneIndex::addFeature(const nlohmann::json& feature) {
+    const nlohmann::json* geometry = member(feature, "geometry");
+    const nlohmann::json* properties = member(feature, "properties");
+    if (!geometry || !properties) return false;
+
+    Geozone zone;
+    const nlohmann::json* type = member(*properties, "type");
+    const std::string type_name = type && type->is_string() ? type->get<std::string>() : "";
+    if (type_name == "PROHIBITED") zone.type = GeozoneType::Prohibited;
+    else if (type_name == "REQ_AUTHORIZATION") zone.type = GeozoneType::ReqAuthorization;
+    else if (type_name == "CONDITIONAL") zone.type = GeozoneType::Conditional;
+    else return false;   // NO_RESTRICTION or unknown
+
+    if (const nlohmann::json* id = member(*properties, "identifier"); id && id->is_string()) zone.identifier = id->get<std::string>();
+    if (const nlohmann::json* name = member(feature, "name"); name && name->is_string()) zone.name = name->get<std::string>();
+    else if (const nlohmann::json* alt = member(*properties, "name"); alt && alt->is_string()) zone.name = alt->get<std::string>();
+
+    // Vertical limits live in the geometry in the geo-awareness response
+    const nlohmann::json* vertical = member(*geometry, "verticalReference");
+    if (!vertical) vertical = member(*properties, "verticalReference");
+    if (vertical) {
+        const nlohmann::json* uom = member(*vertical, "uom");
+        const std::string unit = uom && uom->is_string() ? uom->get<std::string>() : "M";
+        if (const nlohmann::json* lower = member(*vertical, "lower"); lower && lower->is_number()) {
+            zone.has_lower = true;
+            zone.lower = toMeters(lower->get<double>(), unit);
+            if (const nlohmann::json* ref = member(*vertical, "lowerReference"); ref && ref->is_string()) zone.lower_reference = ref->get<std::string>();
+        }
+        if (const nlohmann::json* upper = member(*vertical, "upper"); upper && upper->is_number()) {
+            zone.has_upper = true;
+            zone.upper = toMeters(upper->get<double>(), unit);
+            if (const nlohmann::json* ref = member(*vertical, "upperReference"); ref && ref->is_string()) zone.upper_reference = ref->get<std::string>();
+        }
+    }
+
+    if (const nlohmann::json* applicability = member(*properties, "limitedApplicability")) {
+        long long from, to;
+        if (readTimestamp(*applicability, "startDatetime", "startDateTime", from) &&
+            readTimestamp(*applicability, "endDatetime", "endDateTime", to)) {
+            zone.has_validity = true;
+            zone.valid_from = from;
+            zone.valid_to = to;
+        }
+    }
+
+    const nlohmann::json* geometry_type = member(*geometry, "type");
+    const nlohmann::json* coordinates = member(*geometry, "coordinates");
+    const nlohmann::json* radius = member(*geometry, "radius");
+    const std::string shape = geometry_type && geometry_type->is_string() ? geometry_type->get<std::string>() : "";
+    if (!coordinates) return false;
+
+    if (radius && radius->is_number() && coordinates->is_array() && coordinates->size() >= 2 && (*coordinates)[0].is_number()) {
+        circleRing((*coordinates)[0].get<double>(), (*coordinates)[1].get<double>(), radius->get<double>(), zone);
+        addZone(std::move(zone));
+    } else if (shape == "Polygon" && coordinates->is_array() && !coordinates->empty()) {
+        // Holes are not subtracted: the outer ring alone is conservative
+        if (!readRing((*coordinates)[0], zone)) return false;
+        addZone(std::move(zone));
+    } else if (shape == "MultiPolygon" && coordinates->is_array()) {
+        bool added = false;
+        for (const auto& polygon : *coordinates) {
+            Geozone part = zone;
+            if (polygon.is_array() && !polygon.empty() && readRing(polygon[0], part)) {
+                addZone(std::move(part));
+                added = true;
+            }
+        }
+        return added;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+uint64_t GeozoneIndex::cellKey(int64_t ix, int64_t iy) const {
+    return (static_cast<uint64_t>(ix) << 32) ^ static_cast<uint32_t>(iy);
+}
+
+void GeozoneIndex::addZone(Geozone zone) {
+    zone.min_lon = *std::min_element(zone.ring_lon.begin(), zone.ring_lon.end());
+    zone.max_lon = *std::max_element(zone.ring_lon.begin(), zone.ring_lon.end());
+    zone.min_lat = *std::min_element(zone.ring_lat.begin(), zone.ring_lat.end());
+    zone.max_lat = *std::max_element(zone.ring_lat.begin(), zone.ring_lat.end());
+
+    const uint32_t id = static_cast<uint32_t>(zones.size());
+    int64_t ix0 = static_cast<int64_t>(std::floor(zone.min_lon / cell_deg));
+    int64_t ix1 = static_cast<int64_t>(std::floor(zone.max_lon / cell_deg));
+    int64_t iy0 = static_cast<int64_t>(std::floor(zone.min_lat / cell_deg));
+    int64_t iy1 = static_cast<int64_t>(std::floor(zone.max_lat / cell_deg));
+    zones.push_back(std::move(zone));
+
+    if (static_cast<uint64_t>(ix1 - ix0 + 1) * static_cast<uint64_t>(iy1 - iy0 + 1) > MAX_ZONE_CELLS) {
+        large_zones.push_back(id);
+        return;
+    }
+    for (int64_t ix = ix0; ix <= ix1; ++ix) {
+        for (int64_t iy = iy0; iy <= iy1; ++iy) {
+            cells[cellKey(ix, iy)].push_back(id);
+        }
+    }
+}
+
+bool GeozoneIndex::intersects(const Geozone& zone, const VolumeRecord& volume, const std::string& altitude_reference) const {
+    if (zone.has_validity && (volume.time_end < zone.valid_from || volume.time_begin > zone.valid_to)) return false;
+    // A limit in another reference cannot be compared without terrain: it does not exclude
+    if (zone.has_lower && zone.lower_reference == altitude_reference && volume.max_alt < zone.lower) return false;
+    if (zone.has_upper && zone.upper_reference == altitude_reference && volume.min_alt > zone.upper) return false;
+    if (volume.max_lon < zone.min_lon || volume.min_lon > zone.max_lon ||
+        volume.max_lat < zone.min_lat || volume.min_lat > zone.max_lat) {
+        return false;
+    }
+
+    const size_t n = zone.ring_lon.size();
+    for (int i = 0; i < 4; ++i) {
+        int j = (i + 1) % 4;
+        for (size_t k = 0; k + 1 < n; ++k) {
+            if (segmentsIntersect(volume.corner_lon[i], volume.corner_lat[i], volume.corner_lon[j], volume.corner_lat[j],
+                                  zone.ring_lon[k], zone.ring_lat[k], zone.ring_lon[k + 1], zone.ring_lat[k + 1])) {
+                return true;
+            }
+        }
+    }
+    // No crossing edges: one contains the other, or they are disjoint
+    return pointInRing(zone.ring_lon, zone.ring_lat, volume.corner_lon[0], volume.corner_lat[0]) ||
+           pointInQuad(volume, zone.ring_lon[0], zone.ring_lat[0]);
+}
+
+void GeozoneIndex::conflicts(const VolumeRecord& volume, const std::string& altitude_reference,
+                             std::vector<size_t>& result) const {
+    result.clear();
+    std::vector<uint32_t> candidates(large_zones);
+    int64_t ix0 = static_cast<int64_t>(std::floor(volume.min_lon / cell_deg));
+    int64_t ix1 = static_cast<int64_t>(std::floor(volume.max_lon / cell_deg));
+    int64_t iy0 = static_cast<int64_t>(std::floor(volume.min_lat / cell_deg));
+    int64_t iy1 = static_cast<int64_t>(std::floor(volume.max_lat / cell_deg));
+    for (int64_t ix = ix0; ix <= ix1; ++ix) {
+        for (int64_t iy = iy0; iy <= iy1; ++iy) {
+            auto it = cells.find(cellKey(ix, iy));
+            if (it != cells.end()) candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (uint32_t id : candidates) {
+        if (intersects(zones[id], volume, altitude_reference)) result.push_back(id);
+    }
+    std::stable_partition(result.begin(), result.end(), [&](size_t id) { return zones[id].hard(); });
+}
+
+} // namespace UPlanGeneration
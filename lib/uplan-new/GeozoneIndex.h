@@ -0,0 +1,92 @@
+#ifndef GEOZONE_INDEX_H
+#define GEOZONE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "VolumeRecord.h"
+
+namespace UPlanGeneration {
+
+enum class GeozoneType { Prohibited, ReqAuthorization, Conditional };
+
+// Geozona preparada para consultas: anillo exterior en lon/lat (WGS84), límites
+// verticales en metros y ventana de validez. Un límite ausente (null) no limita.
+struct Geozone {
+    std::string identifier;
+    std::string name;
+    GeozoneType type = GeozoneType::Conditional;
+    std::vector<double> ring_lon;   // cerrado (último = primero)
+    std::vector<double> ring_lat;
+    double min_lon = 0.0, min_lat = 0.0, max_lon = 0.0, max_lat = 0.0;
+    double lower = 0.0, upper = 0.0;
+    bool has_lower = false, has_upper = false;
+    std::string lower_reference, upper_reference;
+    long long valid_from = 0, valid_to = 0;   // unix (s)
+    bool has_validity = false;
+
+    // Conflicto duro: el plan no se puede aprobar (PROHIBITED)
+    bool hard() const { return type == GeozoneType::Prohibited; }
+};
+
+const char* geozoneTypeName(GeozoneType type);
+
+// Índice de geozonas en rejilla (cell_deg grados) para filtrar volúmenes mientras se
+// generan. Lee la respuesta del servicio de geo-awareness (geozones_static_NEW.json:
+// {"geozones": FeatureCollection}, con las líneas de comentario '#' iniciales), una
+// FeatureCollection o un array de Features. Las zonas NO_RESTRICTION se descartan.
+//
+// Es conservador: un volumen entra en una zona si su rectángulo corta el polígono (los
+// huecos no se restan), sus altitudes solapan los límites de la zona que usan la misma
+// referencia (AGL/AMSL) que el volumen y su ventana temporal cae en la validez de la
+// zona (el horario diario de limitedApplicability no se aplica).
+class GeozoneIndex {
+public:
+    explicit GeozoneIndex(double cell_deg = 0.05);
+
+    bool load(const std::string& path);
+    bool loadJson(const nlohmann::json& document);
+
+    size_t size() const { return zones.size(); }
+    const Geozone& zone(size_t index) const { return zones[index]; }
+
+    // Zonas (índices) en las que entra el volumen, las duras primero
+    void conflicts(const VolumeRecord& volume, const std::string& altitude_reference,
+                   std::vector<size_t>& result) const;
+
+private:
+    double cell_deg;
+    std::vector<Geozone> zones;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    std::vector<uint32_t> large_zones;   // demasiadas celdas: se prueban siempre
+
+    bool addFeature(const nlohmann::json& feature);
+    void addZone(Geozone zone);
+    uint64_t cellKey(int64_t ix, int64_t iy) const;
+    bool intersects(const Geozone& zone, const VolumeRecord& volume, const std::string& altitude_reference) const;
+};
+
+// Resultado del filtro de geozonas para un volumen
+struct GeozoneConflict {
+    size_t segment = 0;     // índice del segmento (waypoints reducidos segment -> segment + 1)
+    size_t zone = 0;        // índice en el GeozoneIndex
+    bool hard = false;
+    VolumeRecord volume{};  // volumen del segmento (geometría y ventana temporal)
+};
+
+// Filtro de geozonas durante la generación de volúmenes: cada volumen se prueba al
+// crearlo. Con early_abort la generación se detiene en el primer conflicto duro y
+// retorna vacío; conflicts.back() es entonces el segmento responsable.
+struct GeozoneScreening {
+    const GeozoneIndex* index = nullptr;
+    bool early_abort = true;
+    std::vector<GeozoneConflict> conflicts;
+    bool aborted = false;
+};
+
+} // namespace UPlanGeneration
+
+#endif // GEOZONE_INDEX_H
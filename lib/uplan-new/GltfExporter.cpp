@@ -0,0 +1,306 @@
+#include "GltfExporter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <nlohmann/json.hpp>
+
+namespace UPlanGeneration {
+
+namespace {
+
+const double WGS84_A = 6378137.0;
+const double WGS84_E2 = 6.69437999014e-3;
+const double DEG_TO_RAD = M_PI / 180.0;
+
+const uint32_t GLB_MAGIC = 0x46546C67;        // "glTF"
+const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;   // "JSON"
+const uint32_t GLB_CHUNK_BIN = 0x004E4942;    // "BIN\0"
+const int GL_FLOAT = 5126;
+const int GL_UNSIGNED_INT = 5125;
+const int GL_ARRAY_BUFFER = 34962;
+const int GL_ELEMENT_ARRAY_BUFFER = 34963;
+
+struct Vec3 {
+    double x, y, z;
+    Vec3 operator-(const Vec3& o) const { return {x - o.x, y - o.y, z - o.z}; }
+    Vec3 operator+(const Vec3& o) const { return {x + o.x, y + o.y, z + o.z}; }
+    Vec3 operator*(double k) const { return {x * k, y * k, z * k}; }
+};
+
+Vec3 cross(const Vec3& a, const Vec3& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+double dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// Geodetic -> ECEF, returned in glTF axes (Y up): (x, z, -y)
+Vec3 toGltf(double lat, double lon, double h) {
+    double phi = lat * DEG_TO_RAD;
+    double lambda = lon * DEG_TO_RAD;
+    double n = WGS84_A / std::sqrt(1.0 - WGS84_E2 * std::sin(phi) * std::sin(phi));
+    double x = (n + h) * std::cos(phi) * std::cos(lambda);
+    double y = (n + h) * std::cos(phi) * std::sin(lambda);
+    double z = (n * (1.0 - WGS84_E2) + h) * std::sin(phi);
+    return {x, z, -y};
+}
+
+struct MeshBuffers {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> feature_ids;
+    std::vector<float> time_begin;
+    std::vector<float> time_end;
+    std::vector<uint32_t> indices;
+    float min_pos[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float max_pos[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+};
+
+void addQuad(MeshBuffers& mesh, Vec3 p[4], const Vec3& box_center, float feature, float t0, float t1) {
+    Vec3 n = cross(p[1] - p[0], p[2] - p[0]);
+    Vec3 face_center = (p[0] + p[1] + p[2] + p[3]) * 0.25;
+    if (dot(n, face_center - box_center) < 0.0) {
+        std::swap(p[1], p[3]);   // keep CCW winding seen from outside
+        n = n * -1.0;
+    }
+    double length = std::sqrt(dot(n, n));
+    n = length > 1e-9 ? n * (1.0 / length) : Vec3{0.0, 1.0, 0.0};   // flat box (min_alt == max_alt)
+
+    uint32_t base = static_cast<uint32_t>(mesh.feature_ids.size());
+    for (int k = 0; k < 4; ++k) {
+        const float v[3] = {static_cast<float>(p[k].x), static_cast<float>(p[k].y), static_cast<float>(p[k].z)};
+        for (int a = 0; a < 3; ++a) {
+            mesh.positions.push_back(v[a]);
+            mesh.min_pos[a] = std::min(mesh.min_pos[a], v[a]);
+            mesh.max_pos[a] = std::max(mesh.max_pos[a], v[a]);
+        }
+        mesh.normals.push_back(static_cast<float>(n.x));
+        mesh.normals.push_back(static_cast<float>(n.y));
+        mesh.normals.push_back(static_cast<float>(n.z));
+        mesh.feature_ids.push_back(feature);
+        mesh.time_begin.push_back(t0);
+        mesh.time_end.push_back(t1);
+    }
+    const uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+    for (uint32_t q : quad) mesh.indices.push_back(base + q);
+}
+
+void appendBytes(std::string& bin, const void* data, size_t size) {
+    bin.append(static_cast<const char*>(data), size);
+}
+
+void putLe32(std::string& out, uint32_t v) {
+    const char b[4] = {static_cast<char>(v & 0xFF), static_cast<char>((v >> 8) & 0xFF),
+                       static_cast<char>((v >> 16) & 0xFF), static_cast<char>((v >> 24) & 0xFF)};
+    out.append(b, 4);
+}
+
+struct Extent {
+    double min_lon, min_lat, max_lon, max_lat, min_alt, max_alt;
+    int64_t time_origin;
+};
+
+Extent extentOf(const std::vector<VolumeRecord>& records) {
+    Extent e{std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+             std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(),
+             std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(),
+             std::numeric_limits<int64_t>::max()};
+    for (const auto& r : records) {
+        e.min_lon = std::min(e.min_lon, r.min_lon);
+        e.min_lat = std::min(e.min_lat, r.min_lat);
+        e.max_lon = std::max(e.max_lon, r.max_lon);
+        e.max_lat = std::max(e.max_lat, r.max_lat);
+        e.min_alt = std::min(e.min_alt, r.min_alt);
+        e.max_alt = std::max(e.max_alt, r.max_alt);
+        e.time_origin = std::min(e.time_origin, r.time_begin);
+    }
+    return e;
+}
+
+} // namespace
+
+std::string buildVolumesGlb(const std::vector<VolumeRecord>& records) {
+    if (records.empty()) return "";
+
+    const Extent extent = extentOf(records);
+    // Float positions are kept relative to the scenario centre (mm precision over tens of km)
+    const Vec3 center = toGltf((extent.min_lat + extent.max_lat) / 2.0, (extent.min_lon + extent.max_lon) / 2.0,
+                               (extent.min_alt + extent.max_alt) / 2.0);
+
+    MeshBuffers mesh;
+    mesh.positions.reserve(records.size() * 24 * 3);
+    mesh.normals.reserve(records.size() * 24 * 3);
+    mesh.feature_ids.reserve(records.size() * 24);
+    mesh.time_begin.reserve(records.size() * 24);
+    mesh.time_end.reserve(records.size() * 24);
+    mesh.indices.reserve(records.size() * 36);
+
+    nlohmann::json plan_ids = nlohmann::json::array();
+    nlohmann::json ordinals = nlohmann::json::array();
+    nlohmann::json begins = nlohmann::json::array();
+    nlohmann::json ends = nlohmann::json::array();
+
+    for (size_t i = 0; i < records.size(); ++i) {
+        const VolumeRecord& r = records[i];
+        Vec3 bottom[4], top[4];
+        Vec3 box_center{0.0, 0.0, 0.0};
+        for (int k = 0; k < 4; ++k) {
+            bottom[k] = toGltf(r.corner_lat[k], r.corner_lon[k], r.min_alt) - center;
+            top[k] = toGltf(r.corner_lat[k], r.corner_lon[k], r.max_alt) - center;
+            box_center = box_center + (bottom[k] + top[k]) * 0.125;
+        }
+
+        const float feature = static_cast<float>(i);
+        const float t0 = static_cast<float>(r.time_begin - extent.time_origin);
+        const float t1 = static_cast<float>(r.time_end - extent.time_origin);
+
+        Vec3 quad[4] = {bottom[0], bottom[1], bottom[2], bottom[3]};
+        addQuad(mesh, quad, box_center, feature, t0, t1);
+        Vec3 cap[4] = {top[0], top[1], top[2], top[3]};
+        addQuad(mesh, cap, box_center, feature, t0, t1);
+        for (int k = 0; k < 4; ++k) {
+            int next = (k + 1) % 4;
+            Vec3 side[4] = {bottom[k], bottom[next], top[next], top[k]};
+            addQuad(mesh, side, box_center, feature, t0, t1);
+        }
+
+        plan_ids.push_back(r.plan_id);
+        ordinals.push_back(r.ordinal);
+        begins.push_back(r.time_begin);
+        ends.push_back(r.time_end);
+    }
+
+    // Binary chunk: one tightly packed buffer view per attribute (all 4-byte aligned)
+    std::string bin;
+    nlohmann::json buffer_views = nlohmann::json::array();
+    auto addView = [&](const void* data, size_t size, int target) {
+        buffer_views.push_back({{"buffer", 0}, {"byteOffset", bin.size()}, {"byteLength", size}, {"target", target}});
+        appendBytes(bin, data, size);
+        return buffer_views.size() - 1;
+    };
+    const size_t vertex_count = mesh.feature_ids.size();
+    size_t pos_view = addView(mesh.positions.data(), mesh.positions.size() * sizeof(float), GL_ARRAY_BUFFER);
+    size_t nrm_view = addView(mesh.normals.data(), mesh.normals.size() * sizeof(float), GL_ARRAY_BUFFER);
+    size_t fid_view = addView(mesh.feature_ids.data(), vertex_count * sizeof(float), GL_ARRAY_BUFFER);
+    size_t tb_view = addView(mesh.time_begin.data(), vertex_count * sizeof(float), GL_ARRAY_BUFFER);
+    size_t te_view = addView(mesh.time_end.data(), vertex_count * sizeof(float), GL_ARRAY_BUFFER);
+    size_t idx_view = addView(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t), GL_ELEMENT_ARRAY_BUFFER);
+
+    nlohmann::json accessors = nlohmann::json::array({
+        {{"bufferView", pos_view}, {"componentType", GL_FLOAT}, {"count", vertex_count}, {"type", "VEC3"},
+         {"min", {mesh.min_pos[0], mesh.min_pos[1], mesh.min_pos[2]}},
+         {"max", {mesh.max_pos[0], mesh.max_pos[1], mesh.max_pos[2]}}},
+        {{"bufferView", nrm_view}, {"componentType", GL_FLOAT}, {"count", vertex_count}, {"type", "VEC3"}},
+        {{"bufferView", fid_view}, {"componentType", GL_FLOAT}, {"count", vertex_count}, {"type", "SCALAR"}},
+        {{"bufferView", tb_view}, {"componentType", GL_FLOAT}, {"count", vertex_count}, {"type", "SCALAR"}},
+        {{"bufferView", te_view}, {"componentType", GL_FLOAT}, {"count", vertex_count}, {"type", "SCALAR"}},
+        {{"bufferView", idx_view}, {"componentType", GL_UNSIGNED_INT}, {"count", mesh.indices.size()}, {"type", "SCALAR"}}
+    });
+
+    nlohmann::json gltf = {
+        {"asset", {{"version", "2.0"}, {"generator", "uplan-new GltfExporter"}}},
+        {"scene", 0},
+        {"scenes", {{{"nodes", {0}}}}},
+        {"nodes", {{{"mesh", 0}, {"translation", {center.x, center.y, center.z}}}}},
+        {"meshes", {{
+            {"primitives", {{
+                {"attributes", {{"POSITION", 0}, {"NORMAL", 1}, {"_FEATURE_ID_0", 2},
+                                {"_TIME_BEGIN", 3}, {"_TIME_END", 4}}},
+                {"indices", 5},
+                {"material", 0},
+                {"mode", 4}
+            }}},
+            {"extras", {
+                {"timeOrigin", extent.time_origin},
+                {"features", {{"plan_id", plan_ids}, {"ordinal", ordinals},
+                              {"time_begin", begins}, {"time_end", ends}}}
+            }}
+        }}},
+        {"materials", {{
+            {"pbrMetallicRoughness", {{"baseColorFactor", {0.0, 0.6, 1.0, 0.35}},
+                                      {"metallicFactor", 0.0}, {"roughnessFactor", 1.0}}},
+            {"alphaMode", "BLEND"},
+            {"doubleSided", true}
+        }}},
+        {"accessors", accessors},
+        {"bufferViews", buffer_views},
+        {"buffers", {{{"byteLength", bin.size()}}}}
+    };
+
+    std::string json_chunk = gltf.dump();
+    json_chunk.resize((json_chunk.size() + 3) & ~size_t(3), ' ');
+    bin.resize((bin.size() + 3) & ~size_t(3), '\0');
+
+    std::string glb;
+    glb.reserve(12 + 8 + json_chunk.size() + 8 + bin.size());
+    putLe32(glb, GLB_MAGIC);
+    putLe32(glb, 2);
+    putLe32(glb, static_cast<uint32_t>(12 + 8 + json_chunk.size() + 8 + bin.size()));
+    putLe32(glb, static_cast<uint32_t>(json_chunk.size()));
+    putLe32(glb, GLB_CHUNK_JSON);
+    glb += json_chunk;
+    putLe32(glb, static_cast<uint32_t>(bin.size()));
+    putLe32(glb, GLB_CHUNK_BIN);
+    glb += bin;
+    return glb;
+}
+
+bool writeVolumesGlb(const std::vector<VolumeRecord>& records, const std::string& glb_path) {
+    if (records.empty()) {
+        std::cerr << "[ERROR] No volumes to export: " << glb_path << std::endl;
+        return false;
+    }
+    std::string glb = buildVolumesGlb(records);
+    std::ofstream file(glb_path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "[ERROR] Cannot open file for writing: " << glb_path << std::endl;
+        return false;
+    }
+    file.write(glb.data(), static_cast<std::streamsize>(glb.size()));
+    file.close();
+    std::cout << "[INFO] Saved glTF: " << glb_path << " (" << records.size() << " volumes, "
+              << glb.size() << " bytes)" << std::endl;
+    return static_cast<bool>(file);
+}
+
+bool writeVolumesTileset(const std::vector<VolumeRecord>& records, const std::string& dir) {
+    std::filesystem::create_directories(dir);
+    const std::string base = dir.empty() || dir.back() == '/' ? dir : dir + "/";
+    if (!writeVolumesGlb(records, base + "volumes.glb")) return false;
+
+    const Extent e = extentOf(records);
+    // Geometric error of the whole scenario: its diagonal, so the single tile is always refined
+    Vec3 sw = toGltf(e.min_lat, e.min_lon, e.min_alt);
+    Vec3 ne = toGltf(e.max_lat, e.max_lon, e.max_alt);
+    double diagonal = std::sqrt(dot(ne - sw, ne - sw));
+
+    nlohmann::json tileset = {
+        {"asset", {{"version", "1.1"}}},
+        {"geometricError", diagonal},
+        {"root", {
+            {"boundingVolume", {{"region", {e.min_lon * DEG_TO_RAD, e.min_lat * DEG_TO_RAD,
+                                            e.max_lon * DEG_TO_RAD, e.max_lat * DEG_TO_RAD,
+                                            e.min_alt, e.max_alt}}}},
+            {"geometricError", 0.0},
+            {"refine", "ADD"},
+            {"content", {{"uri", "volumes.glb"}}}
+        }}
+    };
+
+    std::string tileset_path = base + "tileset.json";
+    std::ofstream file(tileset_path);
+    if (!file.is_open()) {
+        std::cerr << "[ERROR] Cannot open file for writing: " << tileset_path << std::endl;
+        return false;
+    }
+    file << tileset.dump(4);
+    file.close();
+    std::cout << "[INFO] Saved 3D Tiles tileset: " << tileset_path << std::endl;
+    return true;
+}
+
+} // namespace UPlanGeneration
@@ -0,0 +1,31 @@
+#ifndef GLTF_EXPORTER_H
+#define GLTF_EXPORTER_H
+
+#include <string>
+#include <vector>
+#include "VolumeRecord.h"
+
+namespace UPlanGeneration {
+
+// Exporta volúmenes como cajas extruidas (rectángulo orientado x [min_alt, max_alt])
+// en una única malla glTF binaria (GLB), de forma que el visor 3D dibuja un escenario
+// completo en una llamada en lugar de una entidad por volumen.
+//
+// - Posiciones en ECEF WGS84 relativas al centro del conjunto (la traslación del
+//   nodo lleva el centro), con el eje Y arriba que espera glTF/3D Tiles.
+// - Las altitudes se interpretan como alturas elipsoidales: para que coincidan con
+//   el terreno, generar los planes con referencia AMSL (ver setTerrain).
+// - Atributos por vértice: _FEATURE_ID_0 (índice del volumen), _TIME_BEGIN y
+//   _TIME_END (segundos desde extras.timeOrigin) para filtrar por tiempo en el shader.
+// - extras.features: plan_id, ordinal, time_begin y time_end de cada volumen.
+std::string buildVolumesGlb(const std::vector<VolumeRecord>& records);
+
+// Escribe el GLB en un fichero
+bool writeVolumesGlb(const std::vector<VolumeRecord>& records, const std::string& glb_path);
+
+// Escribe un tileset 3D Tiles 1.1 de un solo tile: <dir>/tileset.json + <dir>/volumes.glb
+bool writeVolumesTileset(const std::vector<VolumeRecord>& records, const std::string& dir);
+
+} // namespace UPlanGeneration
+
+#endif // GLTF_EXPORTER_H
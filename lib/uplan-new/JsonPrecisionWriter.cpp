@@ -0,0 +1,190 @@
+#include "JsonPrecisionWriter.h"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+
+namespace UPlanGeneration {
+
+namespace {
+
+constexpr int MAX_DECIMALS = 15;
+
+const double POW10[MAX_DECIMALS + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+void appendUnsigned(std::string& out, uint64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+// Shortest round-trip representation; integral values keep a ".0" like nlohmann does
+void appendShortest(std::string& out, double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    std::string_view text(buffer, static_cast<size_t>(result.ptr - buffer));
+    out.append(text);
+    if (text.find_first_of(".e") == std::string_view::npos) out += ".0";
+}
+
+void appendString(std::string& out, const std::string& value) {
+    static const char HEX[] = "0123456789abcdef";
+    out += '"';
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out += HEX[c >> 4];
+                    out += HEX[c & 0xF];
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+void newline(std::string& out, int indent, int depth) {
+    if (indent < 0) return;
+    out += '\n';
+    out.append(static_cast<size_t>(indent) * static_cast<size_t>(depth), ' ');
+}
+
+void write(std::string& out, const nlohmann::json& value, const JsonPrecision& precision, int indent, int depth,
+           int decimals) {
+    switch (value.type()) {
+        case nlohmann::json::value_t::object: {
+            if (value.empty()) {
+                out += "{}";
+                return;
+            }
+            out += '{';
+            bool first = true;
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                if (!first) out += ',';
+                first = false;
+                newline(out, indent, depth + 1);
+                appendString(out, it.key());
+                out += indent >= 0 ? ": " : ":";
+                write(out, it.value(), precision, indent, depth + 1, precision.decimalsFor(it.key()));
+            }
+            newline(out, indent, depth);
+            out += '}';
+            return;
+        }
+        case nlohmann::json::value_t::array: {
+            if (value.empty()) {
+                out += "[]";
+                return;
+            }
+            out += '[';
+            bool first = true;
+            for (const auto& element : value) {
+                if (!first) out += ',';
+                first = false;
+                newline(out, indent, depth + 1);
+                write(out, element, precision, indent, depth + 1, decimals);
+            }
+            newline(out, indent, depth);
+            out += ']';
+            return;
+        }
+        case nlohmann::json::value_t::string:
+            appendString(out, value.get_ref<const std::string&>());
+            return;
+        case nlohmann::json::value_t::boolean:
+            out += value.get<bool>() ? "true" : "false";
+            return;
+        case nlohmann::json::value_t::number_integer: {
+            int64_t v = value.get<int64_t>();
+            if (v < 0) out += '-';
+            appendUnsigned(out, v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v));
+            return;
+        }
+        case nlohmann::json::value_t::number_unsigned:
+            appendUnsigned(out, value.get<uint64_t>());
+            return;
+        case nlohmann::json::value_t::number_float: {
+            double v = value.get<double>();
+            if (!std::isfinite(v)) {
+                out += "null";
+            } else if (decimals < 0) {
+                appendShortest(out, v);
+            } else {
+                appendFixed(out, v, decimals);
+            }
+            return;
+        }
+        default:
+            out += "null";
+    }
+}
+
+} // namespace
+
+JsonPrecision JsonPrecision::geographic() {
+    JsonPrecision precision;
+    for (const char* key : {"coordinates", "bbox", "lat", "lon", "latitude", "longitude"}) {
+        precision.decimals[key] = 7;
+    }
+    for (const char* key : {"altitude", "value", "alt", "h", "min_alt", "max_alt", "uasMTOM", "uasMaxSpeed"}) {
+        precision.decimals[key] = 2;
+    }
+    for (const char* key : {"time", "timestamp"}) {
+        precision.decimals[key] = 0;
+    }
+    return precision;
+}
+
+void appendFixed(std::string& out, double value, int decimals) {
+    decimals = std::min(decimals, MAX_DECIMALS);
+    const double scaled = std::fabs(value) * POW10[decimals];
+    if (scaled >= 9.0e18) {
+        // Out of int64 range after scaling: fall back to the shortest representation
+        appendShortest(out, value);
+        return;
+    }
+    uint64_t units = static_cast<uint64_t>(std::llround(scaled));
+    if (units == 0) {
+        out += '0';
+        return;
+    }
+    if (value < 0) out += '-';
+
+    uint64_t divisor = static_cast<uint64_t>(POW10[decimals]);
+    appendUnsigned(out, units / divisor);
+    uint64_t fraction = units % divisor;
+    if (fraction == 0) return;
+
+    // Fraction digits with leading zeros, trailing zeros dropped
+    char digits[MAX_DECIMALS];
+    for (int i = decimals - 1; i >= 0; --i) {
+        digits[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    int length = decimals;
+    while (length > 0 && digits[length - 1] == '0') --length;
+    out += '.';
+    out.append(digits, static_cast<size_t>(length));
+}
+
+void appendWithPrecision(std::string& out, const nlohmann::json& value, const JsonPrecision& precision, int indent) {
+    write(out, value, precision, indent, 0, precision.default_decimals);
+}
+
+std::string dumpWithPrecision(const nlohmann::json& value, const JsonPrecision& precision, int indent) {
+    std::string out;
+    appendWithPrecision(out, value, precision, indent);
+    return out;
+}
+
+} // namespace UPlanGeneration
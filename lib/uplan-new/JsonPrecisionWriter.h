@@ -0,0 +1,37 @@
+#ifndef JSON_PRECISION_WRITER_H
+#define JSON_PRECISION_WRITER_H
+
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace UPlanGeneration {
+
+// Decimales con que se escribe cada campo numérico, por nombre de clave. Los números
+// dentro de arrays heredan la clave del array ("coordinates": [[lon, lat], ...]).
+// -1 = representación más corta que recupera el double (como nlohmann::json::dump).
+struct JsonPrecision {
+    std::unordered_map<std::string, int> decimals;
+    int default_decimals = -1;
+
+    // 7 decimales en coordenadas (~1 cm), 2 en altitudes, velocidades y masas, 0 en tiempos (s)
+    static JsonPrecision geographic();
+
+    int decimalsFor(const std::string& key) const {
+        auto it = decimals.find(key);
+        return it == decimals.end() ? default_decimals : it->second;
+    }
+};
+
+// Serializa como nlohmann::json::dump(indent) pero con los números en coma fija según
+// la precisión de su campo. El formateo es entero (valor escalado y redondeado), sin
+// printf; los ceros finales se omiten ("60.50" -> "60.5", "60.00" -> "60").
+std::string dumpWithPrecision(const nlohmann::json& value, const JsonPrecision& precision, int indent = -1);
+void appendWithPrecision(std::string& out, const nlohmann::json& value, const JsonPrecision& precision, int indent = -1);
+
+// Número en coma fija con `decimals` decimales (decimals >= 0)
+void appendFixed(std::string& out, double value, int decimals);
+
+} // namespace UPlanGeneration
+
+#endif // JSON_PRECISION_WRITER_H
@@ -0,0 +1,457 @@
+#include "MvtExporter.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <sqlite3.h>
+#include <zlib.h>
+#include <nlohmann/json.hpp>
+
+namespace UPlanGeneration {
+
+namespace {
+
+const double MAX_MERCATOR_LAT = 85.0511287798066;
+const size_t TILES_PER_BATCH = 4096;   // tiles encoded in parallel before being written
+
+// Web mercator in world units [0, 1)
+double mercatorX(double lon) {
+    return (lon + 180.0) / 360.0;
+}
+
+double mercatorY(double lat) {
+    lat = std::max(-MAX_MERCATOR_LAT, std::min(MAX_MERCATOR_LAT, lat));
+    double phi = lat * M_PI / 180.0;
+    return (1.0 - std::log(std::tan(phi) + 1.0 / std::cos(phi)) / M_PI) / 2.0;
+}
+
+// --- protobuf helpers (only what the MVT schema needs) ---
+
+void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void putTag(std::string& out, uint32_t field, uint32_t wire_type) {
+    putVarint(out, (static_cast<uint64_t>(field) << 3) | wire_type);
+}
+
+void putBytes(std::string& out, uint32_t field, const std::string& data) {
+    putTag(out, field, 2);
+    putVarint(out, data.size());
+    out += data;
+}
+
+void putPacked(std::string& out, uint32_t field, const std::vector<uint32_t>& values) {
+    std::string packed;
+    for (uint32_t v : values) putVarint(packed, v);
+    putBytes(out, field, packed);
+}
+
+uint32_t zigzag(int32_t v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+// tile.proto Value messages
+std::string intValue(int64_t v) {
+    std::string value;
+    putTag(value, 4, 0);
+    putVarint(value, static_cast<uint64_t>(v));
+    return value;
+}
+
+std::string doubleValue(double v) {
+    std::string value;
+    putTag(value, 3, 1);
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    for (int i = 0; i < 8; ++i) value.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+    return value;
+}
+
+// --- geometry ---
+
+struct Pt {
+    double x, y;
+};
+
+// Sutherland-Hodgman against one axis-aligned edge; exact for the convex volume quads
+template <typename Inside, typename Cross>
+std::vector<Pt> clipEdge(const std::vector<Pt>& in, Inside inside, Cross cross) {
+    std::vector<Pt> out;
+    if (in.empty()) return out;
+    Pt prev = in.back();
+    bool prev_in = inside(prev);
+    for (const Pt& cur : in) {
+        bool cur_in = inside(cur);
+        if (cur_in != prev_in) out.push_back(cross(prev, cur));
+        if (cur_in) out.push_back(cur);
+        prev = cur;
+        prev_in = cur_in;
+    }
+    return out;
+}
+
+std::vector<Pt> clipToBox(std::vector<Pt> ring, double lo, double hi) {
+    auto atX = [](const Pt& a, const Pt& b, double x) {
+        return Pt{x, a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x)};
+    };
+    auto atY = [](const Pt& a, const Pt& b, double y) {
+        return Pt{a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y), y};
+    };
+    ring = clipEdge(ring, [&](const Pt& p) { return p.x >= lo; }, [&](const Pt& a, const Pt& b) { return atX(a, b, lo); });
+    ring = clipEdge(ring, [&](const Pt& p) { return p.x <= hi; }, [&](const Pt& a, const Pt& b) { return atX(a, b, hi); });
+    ring = clipEdge(ring, [&](const Pt& p) { return p.y >= lo; }, [&](const Pt& a, const Pt& b) { return atY(a, b, lo); });
+    ring = clipEdge(ring, [&](const Pt& p) { return p.y <= hi; }, [&](const Pt& a, const Pt& b) { return atY(a, b, hi); });
+    return ring;
+}
+
+// MVT command stream for one polygon ring; empty if it collapses after quantization
+std::vector<uint32_t> encodeRing(const std::vector<Pt>& ring) {
+    std::vector<std::pair<int32_t, int32_t>> q;
+    q.reserve(ring.size());
+    for (const Pt& p : ring) {
+        std::pair<int32_t, int32_t> v(static_cast<int32_t>(std::lround(p.x)), static_cast<int32_t>(std::lround(p.y)));
+        if (q.empty() || q.back() != v) q.push_back(v);
+    }
+    while (q.size() > 1 && q.front() == q.back()) q.pop_back();
+    if (q.size() < 3) return {};
+
+    // Exterior rings must have positive area in tile coordinates (y down)
+    int64_t area = 0;
+    for (size_t i = 0; i < q.size(); ++i) {
+        const auto& a = q[i];
+        const auto& b = q[(i + 1) % q.size()];
+        area += static_cast<int64_t>(a.first) * b.second - static_cast<int64_t>(b.first) * a.second;
+    }
+    if (area == 0) return {};
+    if (area < 0) std::reverse(q.begin(), q.end());
+
+    std::vector<uint32_t> cmd;
+    cmd.reserve(q.size() * 2 + 3);
+    int32_t cx = 0, cy = 0;
+    auto delta = [&](const std::pair<int32_t, int32_t>& v) {
+        cmd.push_back(zigzag(v.first - cx));
+        cmd.push_back(zigzag(v.second - cy));
+        cx = v.first;
+        cy = v.second;
+    };
+    cmd.push_back((1u << 3) | 1u);                                        // MoveTo(1)
+    delta(q[0]);
+    cmd.push_back((static_cast<uint32_t>(q.size() - 1) << 3) | 2u);       // LineTo(n)
+    for (size_t i = 1; i < q.size(); ++i) delta(q[i]);
+    cmd.push_back((1u << 3) | 7u);                                        // ClosePath
+    return cmd;
+}
+
+struct TileJob {
+    int z, x, y;
+    std::vector<uint32_t> indices;
+};
+
+std::vector<TileJob> planTiles(const std::vector<VolumeRecord>& records, const MvtOptions& options) {
+    std::vector<TileJob> jobs;
+    for (int z = options.min_zoom; z <= options.max_zoom; ++z) {
+        const double tiles = std::ldexp(1.0, z);
+        const double margin = static_cast<double>(options.buffer) / options.extent;
+        const int64_t last = static_cast<int64_t>(tiles) - 1;
+        std::unordered_map<uint64_t, size_t> slot;
+
+        for (uint32_t i = 0; i < records.size(); ++i) {
+            const VolumeRecord& r = records[i];
+            int64_t x0 = static_cast<int64_t>(std::floor(mercatorX(r.min_lon) * tiles - margin));
+            int64_t x1 = static_cast<int64_t>(std::floor(mercatorX(r.max_lon) * tiles + margin));
+            int64_t y0 = static_cast<int64_t>(std::floor(mercatorY(r.max_lat) * tiles - margin));
+            int64_t y1 = static_cast<int64_t>(std::floor(mercatorY(r.min_lat) * tiles + margin));
+            x0 = std::max<int64_t>(0, x0);
+            y0 = std::max<int64_t>(0, y0);
+            x1 = std::min(last, x1);
+            y1 = std::min(last, y1);
+            for (int64_t tx = x0; tx <= x1; ++tx) {
+                for (int64_t ty = y0; ty <= y1; ++ty) {
+                    uint64_t key = (static_cast<uint64_t>(tx) << 32) | static_cast<uint64_t>(ty);
+                    auto it = slot.find(key);
+                    if (it == slot.end()) {
+                        it = slot.emplace(key, jobs.size()).first;
+                        jobs.push_back({z, static_cast<int>(tx), static_cast<int>(ty), {}});
+                    }
+                    jobs[it->second].indices.push_back(i);
+                }
+            }
+        }
+    }
+    return jobs;
+}
+
+bool gzip(const std::string& in, std::string& out) {
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+    out.resize(deflateBound(&zs, in.size()) + 32);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END;
+}
+
+// Destination of the encoded tiles: a z/x/y.pbf directory or an MBTiles file
+class TileSink {
+public:
+    virtual ~TileSink() = default;
+    virtual bool put(int z, int x, int y, const std::string& data) = 0;
+    virtual bool close() { return true; }
+};
+
+class DirectorySink : public TileSink {
+public:
+    explicit DirectorySink(const std::string& dir) : dir(dir) {}
+
+    bool put(int z, int x, int y, const std::string& data) override {
+        std::filesystem::path path = std::filesystem::path(dir) / std::to_string(z) / std::to_string(x);
+        std::error_code ec;
+        std::filesystem::create_directories(path, ec);
+        path /= std::to_string(y) + ".pbf";
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "[ERROR] Cannot write tile: " << path.string() << std::endl;
+            return false;
+        }
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        return static_cast<bool>(file);
+    }
+
+private:
+    std::string dir;
+};
+
+class MbtilesSink : public TileSink {
+public:
+    ~MbtilesSink() override {
+        if (insert) sqlite3_finalize(insert);
+        if (db) sqlite3_close(db);
+    }
+
+    bool open(const std::string& path, const std::vector<VolumeRecord>& records, const MvtOptions& options) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+            std::cerr << "[ERROR] Cannot create MBTiles file: " << path << std::endl;
+            return false;
+        }
+        const char* schema =
+            "PRAGMA synchronous=OFF;"
+            "CREATE TABLE metadata (name TEXT, value TEXT);"
+            "CREATE TABLE tiles (zoom_level INTEGER, tile_column INTEGER, tile_row INTEGER, tile_data BLOB);"
+            "CREATE UNIQUE INDEX tile_index ON tiles (zoom_level, tile_column, tile_row);"
+            "BEGIN;";
+        if (!exec(schema)) return false;
+
+        double w = 180.0, s = 90.0, e = -180.0, n = -90.0;
+        for (const auto& r : records) {
+            w = std::min(w, r.min_lon);
+            s = std::min(s, r.min_lat);
+            e = std::max(e, r.max_lon);
+            n = std::max(n, r.max_lat);
+        }
+        nlohmann::json layers = {{"vector_layers", {{
+            {"id", options.layer},
+            {"minzoom", options.min_zoom},
+            {"maxzoom", options.max_zoom},
+            {"fields", {{"plan_id", "Number"}, {"ordinal", "Number"}, {"time_begin", "Number"},
+                        {"time_end", "Number"}, {"min_alt", "Number"}, {"max_alt", "Number"}}}
+        }}}};
+        const std::vector<std::pair<std::string, std::string>> metadata = {
+            {"name", options.layer},
+            {"format", "pbf"},
+            {"type", "overlay"},
+            {"minzoom", std::to_string(options.min_zoom)},
+            {"maxzoom", std::to_string(options.max_zoom)},
+            {"bounds", std::to_string(w) + "," + std::to_string(s) + "," + std::to_string(e) + "," + std::to_string(n)},
+            {"center", std::to_string((w + e) / 2.0) + "," + std::to_string((s + n) / 2.0) + "," + std::to_string(options.min_zoom)},
+            {"json", layers.dump()}
+        };
+        sqlite3_stmt* meta = nullptr;
+        if (sqlite3_prepare_v2(db, "INSERT INTO metadata VALUES (?, ?)", -1, &meta, nullptr) != SQLITE_OK) return fail();
+        for (const auto& m : metadata) {
+            sqlite3_bind_text(meta, 1, m.first.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(meta, 2, m.second.c_str(), -1, SQLITE_TRANSIENT);
+            if (sqlite3_step(meta) != SQLITE_DONE) {
+                sqlite3_finalize(meta);
+                return fail();
+            }
+            sqlite3_reset(meta);
+        }
+        sqlite3_finalize(meta);
+
+        return sqlite3_prepare_v2(db, "INSERT INTO tiles VALUES (?, ?, ?, ?)", -1, &insert, nullptr) == SQLITE_OK || fail();
+    }
+
+    bool put(int z, int x, int y, const std::string& data) override {
+        std::string compressed;
+        if (!gzip(data, compressed)) return false;
+        sqlite3_bind_int(insert, 1, z);
+        sqlite3_bind_int(insert, 2, x);
+        sqlite3_bind_int(insert, 3, (1 << z) - 1 - y);   // MBTiles rows follow the TMS scheme
+        sqlite3_bind_blob(insert, 4, compressed.data(), static_cast<int>(compressed.size()), SQLITE_TRANSIENT);
+        bool ok = sqlite3_step(insert) == SQLITE_DONE;
+        sqlite3_reset(insert);
+        return ok || fail();
+    }
+
+    bool close() override {
+        return exec("COMMIT;");
+    }
+
+private:
+    sqlite3* db = nullptr;
+    sqlite3_stmt* insert = nullptr;
+
+    bool exec(const char* sql) {
+        char* message = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &message) != SQLITE_OK) {
+            std::cerr << "[ERROR] MBTiles: " << (message ? message : "unknown error") << std::endl;
+            sqlite3_free(message);
+            return false;
+        }
+        return true;
+    }
+
+    bool fail() {
+        std::cerr << "[ERROR] MBTiles: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+};
+
+} // namespace
+
+std::string encodeVolumeTile(const std::vector<VolumeRecord>& records, const std::vector<uint32_t>& indices,
+                             int z, int x, int y, const MvtOptions& options) {
+    const double scale = std::ldexp(1.0, z) * options.extent;
+    const double ox = static_cast<double>(x) * options.extent;
+    const double oy = static_cast<double>(y) * options.extent;
+    const double lo = -static_cast<double>(options.buffer);
+    const double hi = static_cast<double>(options.extent) + options.buffer;
+
+    static const char* const keys[] = {"plan_id", "ordinal", "time_begin", "time_end", "min_alt", "max_alt"};
+    std::vector<std::string> values;
+    std::unordered_map<std::string, uint32_t> value_index;
+    auto valueId = [&](std::string value) {
+        auto it = value_index.find(value);
+        if (it != value_index.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(values.size());
+        value_index.emplace(value, id);
+        values.push_back(std::move(value));
+        return id;
+    };
+
+    std::string features;
+    for (uint32_t i : indices) {
+        const VolumeRecord& r = records[i];
+        std::vector<Pt> ring(4);
+        for (int k = 0; k < 4; ++k) {
+            ring[k] = {mercatorX(r.corner_lon[k]) * scale - ox, mercatorY(r.corner_lat[k]) * scale - oy};
+        }
+        std::vector<uint32_t> geometry = encodeRing(clipToBox(std::move(ring), lo, hi));
+        if (geometry.empty()) continue;
+
+        const std::vector<uint32_t> tags = {
+            0, valueId(intValue(r.plan_id)),
+            1, valueId(intValue(r.ordinal)),
+            2, valueId(intValue(r.time_begin)),
+            3, valueId(intValue(r.time_end)),
+            4, valueId(doubleValue(r.min_alt)),
+            5, valueId(doubleValue(r.max_alt))
+        };
+
+        std::string feature;
+        putTag(feature, 1, 0);
+        putVarint(feature, static_cast<uint64_t>(i) + 1);   // id: position in the exported set
+        putPacked(feature, 2, tags);
+        putTag(feature, 3, 0);
+        putVarint(feature, 3);                               // POLYGON
+        putPacked(feature, 4, geometry);
+        putBytes(features, 2, feature);
+    }
+    if (features.empty()) return "";
+
+    std::string layer;
+    putTag(layer, 15, 0);
+    putVarint(layer, 2);
+    putBytes(layer, 1, options.layer);
+    layer += features;
+    for (const char* key : keys) putBytes(layer, 3, key);
+    for (const auto& value : values) putBytes(layer, 4, value);
+    putTag(layer, 5, 0);
+    putVarint(layer, options.extent);
+
+    std::string tile;
+    putBytes(tile, 3, layer);
+    return tile;
+}
+
+long writeVolumeTiles(const std::vector<VolumeRecord>& records, const std::string& output, const MvtOptions& options) {
+    if (options.min_zoom < 0 || options.max_zoom > 24 || options.min_zoom > options.max_zoom || options.extent == 0) {
+        std::cerr << "[ERROR] Invalid MVT zoom range or extent" << std::endl;
+        return -1;
+    }
+
+    std::unique_ptr<TileSink> sink;
+    const std::string suffix = ".mbtiles";
+    if (output.size() > suffix.size() && output.compare(output.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        auto mbtiles = std::make_unique<MbtilesSink>();
+        if (!mbtiles->open(output, records, options)) return -1;
+        sink = std::move(mbtiles);
+    } else {
+        sink = std::make_unique<DirectorySink>(output);
+    }
+
+    std::vector<TileJob> jobs = planTiles(records, options);
+    unsigned workers = options.workers ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "[INFO] Encoding " << jobs.size() << " candidate tiles (z" << options.min_zoom << "-z"
+              << options.max_zoom << ") with " << workers << " workers" << std::endl;
+
+    long written = 0;
+    std::vector<std::string> encoded;
+    for (size_t begin = 0; begin < jobs.size(); begin += TILES_PER_BATCH) {
+        const size_t end = std::min(jobs.size(), begin + TILES_PER_BATCH);
+        encoded.assign(end - begin, std::string());
+
+        std::atomic<size_t> next(begin);
+        std::vector<std::thread> threads;
+        for (unsigned w = 0; w < workers; ++w) {
+            threads.emplace_back([&] {
+                for (size_t j = next++; j < end; j = next++) {
+                    encoded[j - begin] = encodeVolumeTile(records, jobs[j].indices, jobs[j].z, jobs[j].x, jobs[j].y, options);
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+
+        // Tiles are written from this thread: MBTiles has a single writer
+        for (size_t j = begin; j < end; ++j) {
+            if (encoded[j - begin].empty()) continue;
+            if (!sink->put(jobs[j].z, jobs[j].x, jobs[j].y, encoded[j - begin])) return -1;
+            ++written;
+        }
+    }
+
+    if (!sink->close()) return -1;
+    std::cout << "[INFO] Saved " << written << " vector tiles: " << output << std::endl;
+    return written;
+}
+
+} // namespace UPlanGeneration
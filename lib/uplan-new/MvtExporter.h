@@ -0,0 +1,34 @@
+#ifndef MVT_EXPORTER_H
+#define MVT_EXPORTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "VolumeRecord.h"
+
+namespace UPlanGeneration {
+
+struct MvtOptions {
+    int min_zoom = 8;
+    int max_zoom = 16;
+    uint32_t extent = 4096;           // resolución de la tesela (unidades MVT)
+    uint32_t buffer = 64;             // margen de recorte fuera de la tesela
+    std::string layer = "volumes";
+    unsigned workers = 0;             // 0 -> std::thread::hardware_concurrency()
+};
+
+// Codifica una tesela z/x/y (Mapbox Vector Tile v2) con las huellas de los volúmenes
+// indicados (índices en records), recortadas y cuantizadas. Cada feature lleva las
+// propiedades plan_id, ordinal, time_begin, time_end, min_alt y max_alt.
+// Retorna "" si ninguna huella cae en la tesela.
+std::string encodeVolumeTile(const std::vector<VolumeRecord>& records, const std::vector<uint32_t>& indices,
+                             int z, int x, int y, const MvtOptions& options);
+
+// Genera todas las teselas de [min_zoom, max_zoom] en paralelo. Si output termina en
+// ".mbtiles" se escriben en un fichero MBTiles (SQLite, teselas gzip); en otro caso en
+// un directorio output/z/x/y.pbf. Retorna el número de teselas escritas (-1 si error).
+long writeVolumeTiles(const std::vector<VolumeRecord>& records, const std::string& output, const MvtOptions& options = MvtOptions());
+
+} // namespace UPlanGeneration
+
+#endif // MVT_EXPORTER_H
@@ -0,0 +1,91 @@
+#include "NumaTopology.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <pthread.h>
+#include <sched.h>
+
+namespace fs = std::filesystem;
+
+namespace UPlanGeneration {
+
+namespace {
+
+// Kernel cpulist format: "0-3,8-11,16"
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        try {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int c = first; c <= last; ++c) cpus.push_back(c);
+        } catch (const std::exception&) {
+            continue;
+        }
+    }
+    return cpus;
+}
+
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        }
+    }
+    return cpus;
+}
+
+} // namespace
+
+std::vector<NumaNode> detectNumaTopology() {
+    std::vector<int> allowed = allowedCpus();
+    std::vector<NumaNode> nodes;
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            continue;
+        }
+        std::ifstream file(entry.path() / "cpulist");
+        std::string list;
+        if (!std::getline(file, list)) continue;
+
+        NumaNode node;
+        node.id = std::stoi(name.substr(4));
+        for (int cpu : parseCpuList(list)) {
+            if (allowed.empty() || std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                node.cpus.push_back(cpu);
+            }
+        }
+        if (!node.cpus.empty()) nodes.push_back(std::move(node));
+    }
+
+    if (nodes.empty()) {
+        NumaNode node;
+        node.cpus = allowed;
+        if (node.cpus.empty()) node.cpus.push_back(0);
+        nodes.push_back(std::move(node));
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+    return nodes;
+}
+
+bool pinCurrentThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+} // namespace UPlanGeneration
@@ -0,0 +1,24 @@
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include <vector>
+
+namespace UPlanGeneration {
+
+// Nodo NUMA (socket) con las CPUs que el proceso puede usar en él
+struct NumaNode {
+    int id = 0;
+    std::vector<int> cpus;
+};
+
+// Topología leída de /sys/devices/system/node, restringida a la afinidad del proceso
+// (cpuset del contenedor). Sin información NUMA retorna un único nodo con todas las
+// CPUs permitidas. Nunca retorna nodos sin CPUs.
+std::vector<NumaNode> detectNumaTopology();
+
+// Fija el hilo actual a una CPU; retorna false si el sistema lo rechaza
+bool pinCurrentThread(int cpu);
+
+} // namespace UPlanGeneration
+
+#endif // NUMA_TOPOLOGY_H
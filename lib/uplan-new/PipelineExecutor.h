@@ -0,0 +1,288 @@
+#ifndef PIPELINE_EXECUTOR_H
+#define PIPELINE_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace UPlanGeneration {
+
+// Cola acotada MPMC sin bloqueos (D. Vyukov): cada celda lleva un número de secuencia
+// que indica si está libre para el productor de esa vuelta o lista para el consumidor.
+// La capacidad se redondea a potencia de 2. T debe ser movible y construible por defecto.
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    bool tryPush(T& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.data);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // empty
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+// Métricas de una etapa. occupancy = tiempo trabajando / (tiempo total * hilos):
+// una etapa con ocupación cercana a 1 es el cuello de botella; una con mucha espera
+// de entrada tiene hilos de sobra.
+struct PipelineStageStats {
+    std::string name;
+    unsigned threads = 0;
+    size_t items = 0;
+    size_t dropped = 0;
+    double busy_seconds = 0.0;       // ejecutando la función de la etapa
+    double wait_in_seconds = 0.0;    // esperando entrada (cola anterior vacía)
+    double wait_out_seconds = 0.0;   // esperando salida (cola siguiente llena)
+    double wall_seconds = 0.0;
+
+    double occupancy() const {
+        return wall_seconds > 0.0 && threads > 0 ? busy_seconds / (wall_seconds * threads) : 0.0;
+    }
+};
+
+// Ejecutor de un pipeline de etapas con hilos propios, unidas por colas acotadas sin
+// bloqueos. Cada elemento recorre las etapas en orden; una etapa puede descartarlo
+// retornando false. Las colas llenas frenan a la etapa anterior (back-pressure), así
+// que la memoria en vuelo está acotada por la capacidad de las colas.
+//
+//   PipelineExecutor<Plan> pipeline;
+//   pipeline.addStage("load", 2, [&](Plan& plan, unsigned thread) { ... return true; });
+//   pipeline.addStage("generate", 6, ...);
+//   pipeline.start();
+//   for (...) pipeline.submit(std::move(plan));
+//   pipeline.finish();
+//   auto stats = pipeline.stats();
+template <typename Item>
+class PipelineExecutor {
+public:
+    // La función recibe el índice del hilo dentro de la etapa (para estado por hilo)
+    using StageFunction = std::function<bool(Item& item, unsigned thread)>;
+
+    explicit PipelineExecutor(size_t queue_capacity = 64) : queue_capacity(queue_capacity) {}
+    ~PipelineExecutor() { finish(); }
+
+    PipelineExecutor(const PipelineExecutor&) = delete;
+    PipelineExecutor& operator=(const PipelineExecutor&) = delete;
+
+    // Añade una etapa (antes de start)
+    void addStage(const std::string& name, unsigned threads, StageFunction function) {
+        auto stage = std::make_unique<Stage>();
+        stage->name = name;
+        stage->threads = std::max(1u, threads);
+        stage->function = std::move(function);
+        stage->input = std::make_unique<MpmcQueue<Item>>(queue_capacity);
+        stages.push_back(std::move(stage));
+    }
+
+    void start() {
+        started_at = std::chrono::steady_clock::now();
+        for (size_t s = 0; s < stages.size(); ++s) {
+            // Producers of stage s input: the submitter, or the threads of stage s - 1
+            stages[s]->producers.store(s == 0 ? 1u : stages[s - 1]->threads);
+            for (unsigned t = 0; t < stages[s]->threads; ++t) {
+                threads.emplace_back(&PipelineExecutor::stageLoop, this, s, t);
+            }
+        }
+    }
+
+    // Entrega un elemento a la primera etapa (espera si su cola está llena)
+    void submit(Item item) {
+        Backoff backoff;
+        while (!stages.front()->input->tryPush(item)) backoff.pause();
+    }
+
+    // Espera a que todos los elementos recorran el pipeline y detiene los hilos
+    void finish() {
+        if (threads.empty()) return;
+        stages.front()->producers.fetch_sub(1);
+        for (auto& t : threads) t.join();
+        threads.clear();
+        wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at).count();
+    }
+
+    std::vector<PipelineStageStats> stats() const {
+        std::vector<PipelineStageStats> result;
+        for (const auto& stage : stages) {
+            PipelineStageStats s;
+            s.name = stage->name;
+            s.threads = stage->threads;
+            s.items = stage->items.load();
+            s.dropped = stage->dropped.load();
+            s.busy_seconds = stage->busy_ns.load() * 1e-9;
+            s.wait_in_seconds = stage->wait_in_ns.load() * 1e-9;
+            s.wait_out_seconds = stage->wait_out_ns.load() * 1e-9;
+            s.wall_seconds = wall_seconds;
+            result.push_back(s);
+        }
+        return result;
+    }
+
+    // Reparto de total_threads entre etapas proporcional al tiempo de trabajo medido
+    // (al menos un hilo por etapa), para la siguiente ejecución
+    std::vector<unsigned> rebalance(unsigned total_threads) const {
+        std::vector<unsigned> threads_per_stage(stages.size(), 1);
+        double total_busy = 0.0;
+        for (const auto& stage : stages) total_busy += static_cast<double>(stage->busy_ns.load());
+        if (stages.empty() || total_busy <= 0.0 || total_threads <= stages.size()) return threads_per_stage;
+
+        // Largest remainder over the threads left after the one-per-stage minimum
+        const unsigned spare = total_threads - static_cast<unsigned>(stages.size());
+        std::vector<std::pair<double, size_t>> remainders;
+        unsigned assigned = 0;
+        for (size_t s = 0; s < stages.size(); ++s) {
+            double share = spare * static_cast<double>(stages[s]->busy_ns.load()) / total_busy;
+            unsigned whole = static_cast<unsigned>(share);
+            threads_per_stage[s] += whole;
+            assigned += whole;
+            remainders.push_back({share - whole, s});
+        }
+        std::sort(remainders.rbegin(), remainders.rend());
+        for (size_t i = 0; assigned < spare && i < remainders.size(); ++i, ++assigned) {
+            ++threads_per_stage[remainders[i].second];
+        }
+        return threads_per_stage;
+    }
+
+private:
+    struct Stage {
+        std::string name;
+        unsigned threads = 1;
+        StageFunction function;
+        std::unique_ptr<MpmcQueue<Item>> input;
+        std::atomic<unsigned> producers{0};   // threads still able to push into input
+        std::atomic<size_t> items{0};
+        std::atomic<size_t> dropped{0};
+        std::atomic<long long> busy_ns{0};
+        std::atomic<long long> wait_in_ns{0};
+        std::atomic<long long> wait_out_ns{0};
+    };
+
+    // Spin briefly, then yield, then sleep: idle stages must not burn a core
+    struct Backoff {
+        unsigned count = 0;
+        void pause() {
+            if (count < 64) {
+                ++count;
+            } else if (count < 128) {
+                ++count;
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    };
+
+    size_t queue_capacity;
+    std::vector<std::unique_ptr<Stage>> stages;
+    std::vector<std::thread> threads;
+    std::chrono::steady_clock::time_point started_at;
+    double wall_seconds = 0.0;
+
+    static long long elapsedNs(std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    void stageLoop(size_t index, unsigned thread) {
+        Stage& stage = *stages[index];
+        Stage* next = index + 1 < stages.size() ? stages[index + 1].get() : nullptr;
+        Item item;
+
+        while (true) {
+            auto wait_start = std::chrono::steady_clock::now();
+            Backoff backoff;
+            bool got = false;
+            while (!(got = stage.input->tryPop(item))) {
+                // Upstream done: one last pop decides (a push may have landed meanwhile)
+                if (stage.producers.load(std::memory_order_acquire) == 0) {
+                    got = stage.input->tryPop(item);
+                    break;
+                }
+                backoff.pause();
+            }
+            stage.wait_in_ns += elapsedNs(wait_start);
+            if (!got) break;
+
+            auto busy_start = std::chrono::steady_clock::now();
+            bool keep = stage.function(item, thread);
+            stage.busy_ns += elapsedNs(busy_start);
+            ++stage.items;
+            if (!keep) {
+                ++stage.dropped;
+                continue;
+            }
+
+            if (next) {
+                auto push_start = std::chrono::steady_clock::now();
+                Backoff push_backoff;
+                while (!next->input->tryPush(item)) push_backoff.pause();
+                stage.wait_out_ns += elapsedNs(push_start);
+            }
+            item = Item();
+        }
+
+        if (next) next->producers.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+} // namespace UPlanGeneration
+
+#endif // PIPELINE_EXECUTOR_H
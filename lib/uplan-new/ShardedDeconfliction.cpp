@@ -0,0 +1,457 @@
+#include "ShardedDeconfliction.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_set>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace UPlanGeneration {
+
+namespace {
+
+const uint32_t FRAME_MAGIC = 0x48535055;  // "UPSH"
+const uint64_t MAX_FRAME_RECORDS = 1u << 24;
+
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t code;       // ShardOp in requests, status (0 = OK) in responses
+    uint64_t count;      // number of VolumeRecord that follow
+};
+
+bool sendAll(int fd, const void* data, size_t length) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t n = ::send(fd, p, length, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool recvAll(int fd, void* data, size_t length) {
+    char* p = static_cast<char*>(data);
+    while (length > 0) {
+        ssize_t n = ::recv(fd, p, length, 0);
+        if (n == 0) return false;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool sendFrame(int fd, uint32_t code, const std::vector<VolumeRecord>& records) {
+    FrameHeader header{FRAME_MAGIC, code, records.size()};
+    return sendAll(fd, &header, sizeof(header)) &&
+           (records.empty() || sendAll(fd, records.data(), records.size() * sizeof(VolumeRecord)));
+}
+
+bool recvFrame(int fd, uint32_t& code, std::vector<VolumeRecord>& records) {
+    FrameHeader header;
+    if (!recvAll(fd, &header, sizeof(header))) return false;
+    if (header.magic != FRAME_MAGIC || header.count > MAX_FRAME_RECORDS) {
+        std::cerr << "[ERROR] Invalid shard frame" << std::endl;
+        return false;
+    }
+    code = header.code;
+    records.resize(header.count);
+    return records.empty() || recvAll(fd, records.data(), records.size() * sizeof(VolumeRecord));
+}
+
+// Client of a shard server: frames are assembled from non-blocking reads and responses
+// queued until the socket is writable, so a slow client never stalls the others
+struct ClientConnection {
+    int fd;
+    std::string input;
+    std::string output;
+    size_t output_offset = 0;
+    bool peer_closed = false;   // FIN received: answer what was sent, then close
+};
+
+bool setNonBlocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Reads what is available; false when the socket failed. A FIN only sets peer_closed,
+// so frames that arrived before it are still processed and answered
+bool readAvailable(ClientConnection& client) {
+    char buffer[64 * 1024];
+    while (true) {
+        ssize_t n = ::recv(client.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            client.input.append(buffer, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0) {
+            client.peer_closed = true;
+            return true;
+        }
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+// Writes as much of the pending output as the socket takes
+bool writePending(ClientConnection& client) {
+    while (client.output_offset < client.output.size()) {
+        ssize_t n = ::send(client.fd, client.output.data() + client.output_offset,
+                           client.output.size() - client.output_offset, MSG_NOSIGNAL);
+        if (n > 0) {
+            client.output_offset += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        return false;
+    }
+    client.output.clear();
+    client.output_offset = 0;
+    return true;
+}
+
+void appendFrame(std::string& out, uint32_t code, const std::vector<VolumeRecord>& records) {
+    FrameHeader header{FRAME_MAGIC, code, records.size()};
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(VolumeRecord));
+}
+
+bool fillAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[ERROR] Socket path too long: " << path << std::endl;
+        return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return true;
+}
+
+bool sameVolume(const VolumeRecord& a, const VolumeRecord& b) {
+    return a.plan_id == b.plan_id && a.ordinal == b.ordinal;
+}
+
+bool volumeLess(const VolumeRecord& a, const VolumeRecord& b) {
+    return a.plan_id != b.plan_id ? a.plan_id < b.plan_id : a.ordinal < b.ordinal;
+}
+
+uint64_t mixCell(int64_t ix, int64_t iy) {
+    // splitmix64 finalizer: spreads neighbouring cells over the shards
+    uint64_t x = (static_cast<uint64_t>(static_cast<uint32_t>(ix)) << 32) | static_cast<uint32_t>(iy);
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// ShardServer
+
+ShardServer::ShardServer(const std::string& socket_path, const std::string& store_directory)
+    : socket_path(socket_path), store(store_directory) {}
+
+ShardServer::~ShardServer() {
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        ::unlink(socket_path.c_str());
+    }
+}
+
+bool ShardServer::run() {
+    if (!store.open()) {
+        return false;
+    }
+
+    sockaddr_un addr;
+    if (!fillAddress(socket_path, addr)) return false;
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "[ERROR] Cannot create shard socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    ::unlink(socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd, 64) != 0) {
+        std::cerr << "[ERROR] Cannot listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::cout << "[INFO] Shard listening on " << socket_path << " (" << store.size() << " volumes)" << std::endl;
+
+    std::vector<ClientConnection> clients;
+    std::vector<pollfd> fds;
+    running = true;
+
+    // Runs every complete frame in the input buffer; false on a malformed frame
+    auto processInput = [this](ClientConnection& client) {
+        size_t consumed = 0;
+        while (client.input.size() - consumed >= sizeof(FrameHeader)) {
+            FrameHeader header;
+            std::memcpy(&header, client.input.data() + consumed, sizeof(header));
+            if (header.magic != FRAME_MAGIC || header.count > MAX_FRAME_RECORDS) {
+                std::cerr << "[ERROR] Invalid shard frame" << std::endl;
+                return false;
+            }
+            size_t payload = static_cast<size_t>(header.count) * sizeof(VolumeRecord);
+            if (client.input.size() - consumed - sizeof(header) < payload) break;   // wait for the rest
+
+            std::vector<VolumeRecord> request(header.count), response;
+            if (payload > 0) std::memcpy(request.data(), client.input.data() + consumed + sizeof(header), payload);
+            consumed += sizeof(header) + payload;
+            uint32_t status = handleRequest(header.code, request, response);
+            appendFrame(client.output, status, response);
+        }
+        client.input.erase(0, consumed);
+        return true;
+    };
+
+    while (running) {
+        fds.clear();
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (const auto& client : clients) {
+            // A closed peer would report POLLIN forever; only its pending answers remain
+            short events = client.peer_closed ? 0 : POLLIN;
+            if (!client.output.empty()) events |= POLLOUT;
+            fds.push_back({client.fd, events, 0});
+        }
+
+        int ready = ::poll(fds.data(), fds.size(), 200);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[ERROR] poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (ready == 0) continue;
+
+        // fds[i + 1] belongs to clients[i]; closed clients are compacted afterwards
+        for (size_t i = 0; i < clients.size(); ++i) {
+            ClientConnection& client = clients[i];
+            short revents = fds[i + 1].revents;
+            bool alive = true;
+            if (!client.peer_closed && (revents & (POLLIN | POLLHUP | POLLERR))) {
+                alive = readAvailable(client) && processInput(client);
+            }
+            if (alive && !client.output.empty()) {
+                alive = writePending(client);
+            }
+            if (alive && client.peer_closed && client.output.empty()) {
+                alive = false;
+            }
+            if (!alive) {
+                ::close(client.fd);
+                client.fd = -1;
+            }
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [](const ClientConnection& client) { return client.fd < 0; }),
+                      clients.end());
+
+        if (fds[0].revents & POLLIN) {
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd >= 0) {
+                if (setNonBlocking(fd)) {
+                    clients.push_back({fd, {}, {}, 0});
+                } else {
+                    ::close(fd);
+                }
+            }
+        }
+    }
+
+    for (const auto& client : clients) {
+        ::close(client.fd);
+    }
+    store.checkpoint();
+    std::cout << "[INFO] Shard stopped: " << socket_path << std::endl;
+    return true;
+}
+
+uint32_t ShardServer::handleRequest(uint32_t op, const std::vector<VolumeRecord>& request,
+                                   std::vector<VolumeRecord>& response) {
+    uint32_t status = 0;
+
+    switch (static_cast<ShardOp>(op)) {
+    case ShardOp::Insert: {
+        // Idempotent: a router resending after a partial failure or a lost response must
+        // not store the same (plan_id, ordinal) twice
+        std::vector<VolumeRecord> fresh;
+        std::unordered_set<uint64_t> seen;
+        fresh.reserve(request.size());
+        for (const auto& volume : request) {
+            uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(volume.plan_id)) << 32) |
+                           static_cast<uint32_t>(volume.ordinal);
+            if (seen.insert(key).second && !store.contains(volume)) fresh.push_back(volume);
+        }
+        if (!store.append(fresh)) status = 1;
+        break;
+    }
+    case ShardOp::Query:
+        for (const auto& volume : request) {
+            std::vector<VolumeRecord> conflicts = store.findConflicts(volume);
+            response.insert(response.end(), conflicts.begin(), conflicts.end());
+        }
+        std::sort(response.begin(), response.end(), volumeLess);
+        response.erase(std::unique(response.begin(), response.end(), sameVolume), response.end());
+        break;
+    default:
+        std::cerr << "[WARNING] Unknown shard op: " << op << std::endl;
+        status = 2;
+        break;
+    }
+
+    return status;
+}
+
+// ---------------------------------------------------------------------------
+// ShardRouter
+
+ShardRouter::ShardRouter(const std::vector<std::string>& shard_sockets, double shard_cell_deg)
+    : shard_sockets(shard_sockets), shard_fds(shard_sockets.size(), -1), shard_cell(shard_cell_deg) {}
+
+ShardRouter::~ShardRouter() {
+    for (size_t i = 0; i < shard_fds.size(); ++i) {
+        disconnect(i);
+    }
+}
+
+std::vector<size_t> ShardRouter::shardsFor(const VolumeRecord& volume) const {
+    std::vector<size_t> shards;
+    if (shard_sockets.empty()) return shards;
+
+    int64_t ix0 = static_cast<int64_t>(std::floor(volume.min_lon / shard_cell));
+    int64_t ix1 = static_cast<int64_t>(std::floor(volume.max_lon / shard_cell));
+    int64_t iy0 = static_cast<int64_t>(std::floor(volume.min_lat / shard_cell));
+    int64_t iy1 = static_cast<int64_t>(std::floor(volume.max_lat / shard_cell));
+    for (int64_t ix = ix0; ix <= ix1; ++ix) {
+        for (int64_t iy = iy0; iy <= iy1; ++iy) {
+            shards.push_back(mixCell(ix, iy) % shard_sockets.size());
+        }
+    }
+    std::sort(shards.begin(), shards.end());
+    shards.erase(std::unique(shards.begin(), shards.end()), shards.end());
+    return shards;
+}
+
+int ShardRouter::connection(size_t shard) {
+    if (shard_fds[shard] >= 0) return shard_fds[shard];
+
+    sockaddr_un addr;
+    if (!fillAddress(shard_sockets[shard], addr)) return -1;
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    // A hung shard must fail the request instead of blocking the gather forever
+    if (timeout_ms > 0) {
+        timeval tv;
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "[ERROR] Cannot connect to shard " << shard_sockets[shard]
+                  << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    shard_fds[shard] = fd;
+    return fd;
+}
+
+void ShardRouter::disconnect(size_t shard) {
+    if (shard_fds[shard] >= 0) {
+        ::close(shard_fds[shard]);
+        shard_fds[shard] = -1;
+    }
+}
+
+bool ShardRouter::scatterGather(ShardOp op, const std::vector<VolumeRecord>& volumes,
+                                std::vector<VolumeRecord>& results) {
+    std::vector<std::vector<VolumeRecord>> per_shard(shard_sockets.size());
+    for (const auto& volume : volumes) {
+        for (size_t shard : shardsFor(volume)) {
+            per_shard[shard].push_back(volume);
+        }
+    }
+
+    bool ok = true;
+    std::vector<bool> pending(shard_sockets.size(), false);
+
+    // Scatter: all requests go out before any answer is awaited
+    for (size_t shard = 0; shard < per_shard.size(); ++shard) {
+        if (per_shard[shard].empty()) continue;
+        int fd = connection(shard);
+        if (fd >= 0 && !sendFrame(fd, static_cast<uint32_t>(op), per_shard[shard])) {
+            // Stale connection (shard restarted): reconnect once
+            disconnect(shard);
+            fd = connection(shard);
+            if (fd >= 0 && !sendFrame(fd, static_cast<uint32_t>(op), per_shard[shard])) fd = -1;
+        }
+        if (fd < 0) {
+            std::cerr << "[ERROR] Shard unavailable: " << shard_sockets[shard] << std::endl;
+            disconnect(shard);
+            ok = false;
+            continue;
+        }
+        pending[shard] = true;
+    }
+
+    // Gather
+    for (size_t shard = 0; shard < pending.size(); ++shard) {
+        if (!pending[shard]) continue;
+        uint32_t status;
+        std::vector<VolumeRecord> response;
+        errno = 0;
+        if (!recvFrame(shard_fds[shard], status, response)) {
+            bool timed_out = errno == EAGAIN || errno == EWOULDBLOCK;
+            std::cerr << "[ERROR] " << (timed_out ? "Timed out waiting for shard: " : "No response from shard: ")
+                      << shard_sockets[shard] << std::endl;
+            // A late answer must not be read as the reply to the next request
+            disconnect(shard);
+            ok = false;
+            continue;
+        }
+        if (status != 0) {
+            std::cerr << "[ERROR] Shard " << shard_sockets[shard] << " returned status " << status << std::endl;
+            ok = false;
+        }
+        results.insert(results.end(), response.begin(), response.end());
+    }
+    return ok;
+}
+
+bool ShardRouter::insert(const std::vector<VolumeRecord>& volumes) {
+    std::vector<VolumeRecord> unused;
+    return scatterGather(ShardOp::Insert, volumes, unused);
+}
+
+std::vector<VolumeRecord> ShardRouter::findConflicts(const std::vector<VolumeRecord>& volumes, bool* ok) {
+    std::vector<VolumeRecord> conflicts;
+    bool success = scatterGather(ShardOp::Query, volumes, conflicts);
+
+    // A volume stored in several shards (border crossing) is reported by each of them
+    std::sort(conflicts.begin(), conflicts.end(), volumeLess);
+    conflicts.erase(std::unique(conflicts.begin(), conflicts.end(), sameVolume), conflicts.end());
+
+    if (ok) *ok = success;
+    return conflicts;
+}
+
+} // namespace UPlanGeneration
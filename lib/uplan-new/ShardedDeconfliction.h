@@ -0,0 +1,84 @@
+#ifndef SHARDED_DECONFLICTION_H
+#define SHARDED_DECONFLICTION_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include "VolumeRecord.h"
+#include "VolumeStore.h"
+
+namespace UPlanGeneration {
+
+// Deconflicción repartida por regiones entre varios procesos/nodos.
+//
+// El espacio se divide en celdas de rejilla de shard_cell_deg grados y cada celda
+// se asigna a un shard (hash de la celda). Un volumen se guarda en todos los shards
+// cuyas celdas toca, y una consulta se envía a esos mismos shards: dos volúmenes
+// que solapan comparten al menos una celda, así que los planes que cruzan una
+// frontera entre shards se detectan igual. La comunicación es por sockets locales
+// (AF_UNIX), de modo que se puede probar en una sola máquina con varios procesos.
+
+enum class ShardOp : uint32_t {
+    Insert = 1,
+    Query = 2
+};
+
+// Proceso shard: sirve inserciones/consultas sobre su VolumeStore local
+class ShardServer {
+public:
+    ShardServer(const std::string& socket_path, const std::string& store_directory);
+    ~ShardServer();
+
+    // Bucle de servicio; retorna cuando se llama a stop() o hay un error fatal
+    bool run();
+    void stop() { running = false; }
+
+private:
+    std::string socket_path;
+    VolumeStore store;
+    int listen_fd = -1;
+    std::atomic<bool> running{false};
+
+    // Ejecuta una petición ya recibida; retorna el estado de la respuesta (0 = OK)
+    uint32_t handleRequest(uint32_t op, const std::vector<VolumeRecord>& request, std::vector<VolumeRecord>& response);
+};
+
+// Cliente: enruta los volúmenes de cada plan a los shards afectados y reúne las respuestas
+class ShardRouter {
+public:
+    ShardRouter(const std::vector<std::string>& shard_sockets, double shard_cell_deg = 0.1);
+    ~ShardRouter();
+
+    ShardRouter(const ShardRouter&) = delete;
+    ShardRouter& operator=(const ShardRouter&) = delete;
+
+    // Registra los volúmenes de un plan aceptado en todos los shards que toca. Es
+    // idempotente por (plan_id, ordinal): tras un fallo parcial se puede reenviar el plan.
+    bool insert(const std::vector<VolumeRecord>& volumes);
+
+    // Volúmenes almacenados (de cualquier shard) en conflicto con los del plan
+    std::vector<VolumeRecord> findConflicts(const std::vector<VolumeRecord>& volumes, bool* ok = nullptr);
+
+    // Shards (índices) cuyas celdas toca el volumen
+    std::vector<size_t> shardsFor(const VolumeRecord& volume) const;
+
+    // Tiempo máximo de espera por la respuesta de un shard (0 = sin límite); al
+    // agotarse ese shard cuenta como fallido. Aplica a las conexiones nuevas.
+    void setTimeout(int milliseconds) { timeout_ms = milliseconds; }
+
+private:
+    std::vector<std::string> shard_sockets;
+    std::vector<int> shard_fds;
+    double shard_cell;
+    int timeout_ms = 10000;
+
+    int connection(size_t shard);
+    void disconnect(size_t shard);
+    // Envía a cada shard su subconjunto y recoge las respuestas
+    bool scatterGather(ShardOp op, const std::vector<VolumeRecord>& volumes, std::vector<VolumeRecord>& results);
+};
+
+} // namespace UPlanGeneration
+
+#endif // SHARDED_DECONFLICTION_H
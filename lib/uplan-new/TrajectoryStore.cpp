@@ -0,0 +1,170 @@
+#include "TrajectoryStore.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace UPlanGeneration {
+
+uint32_t TrajectoryStore::addFlight(const std::string& id, const std::vector<WaypointComplete>& waypoints,
+                                    double start_timestamp) {
+    // Samples must be time-sorted for the index; CSVs normally already are
+    std::vector<uint32_t> order(waypoints.size());
+    std::iota(order.begin(), order.end(), 0u);
+    if (!std::is_sorted(waypoints.begin(), waypoints.end(),
+                        [](const WaypointComplete& a, const WaypointComplete& b) { return a.time < b.time; })) {
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint32_t a, uint32_t b) { return waypoints[a].time < waypoints[b].time; });
+    }
+
+    const uint32_t flight = static_cast<uint32_t>(ids.size());
+    ids.push_back(id);
+    first.push_back(time.size());
+    count.push_back(static_cast<uint32_t>(waypoints.size()));
+    index_first.push_back(index_time.size());
+
+    double min_lon = std::numeric_limits<double>::max(), min_lat = std::numeric_limits<double>::max();
+    double max_lon = std::numeric_limits<double>::lowest(), max_lat = std::numeric_limits<double>::lowest();
+
+    time.reserve(time.size() + waypoints.size());
+    lat.reserve(lat.size() + waypoints.size());
+    lon.reserve(lon.size() + waypoints.size());
+    h.reserve(h.size() + waypoints.size());
+    for (size_t n = 0; n < order.size(); ++n) {
+        const WaypointComplete& w = waypoints[order[n]];
+        const double t = start_timestamp + w.time;
+        if (n % INDEX_STRIDE == 0) index_time.push_back(t);
+        time.push_back(t);
+        lat.push_back(w.lat);
+        lon.push_back(w.lon);
+        h.push_back(w.h);
+        min_lon = std::min(min_lon, w.lon);
+        max_lon = std::max(max_lon, w.lon);
+        min_lat = std::min(min_lat, w.lat);
+        max_lat = std::max(max_lat, w.lat);
+    }
+
+    // Empty flights are kept (stable indices) but never active
+    t_begin.push_back(waypoints.empty() ? std::numeric_limits<double>::max() : time[first[flight]]);
+    t_end.push_back(waypoints.empty() ? std::numeric_limits<double>::lowest() : time.back());
+    box_min_lon.push_back(min_lon);
+    box_min_lat.push_back(min_lat);
+    box_max_lon.push_back(max_lon);
+    box_max_lat.push_back(max_lat);
+    return flight;
+}
+
+uint32_t TrajectoryStore::segmentAt(uint32_t flight, double t) const {
+    const uint32_t n = count[flight];
+    if (n < 2) return 0;
+
+    // Sparse index -> block of at most INDEX_STRIDE samples
+    const double* idx = index_time.data() + index_first[flight];
+    const uint32_t blocks = (n + INDEX_STRIDE - 1) / INDEX_STRIDE;
+    uint32_t block = static_cast<uint32_t>(std::upper_bound(idx, idx + blocks, t) - idx);
+    block = block > 0 ? block - 1 : 0;
+
+    const double* samples = time.data() + first[flight];
+    const uint32_t lo = block * INDEX_STRIDE;
+    const uint32_t hi = std::min(n, lo + INDEX_STRIDE + 1);
+    uint32_t i = static_cast<uint32_t>(std::upper_bound(samples + lo, samples + hi, t) - samples);
+    i = i > 0 ? i - 1 : 0;
+    return std::min(i, n - 2);   // t == end time interpolates on the last segment
+}
+
+bool TrajectoryStore::positionOf(uint32_t flight, double t, double& out_lat, double& out_lon, double& out_h) const {
+    if (flight >= ids.size() || t < t_begin[flight] || t > t_end[flight]) return false;
+    const uint64_t base = first[flight];
+    if (count[flight] == 1) {
+        out_lat = lat[base];
+        out_lon = lon[base];
+        out_h = h[base];
+        return true;
+    }
+    const uint64_t i = base + segmentAt(flight, t);
+    const double span = time[i + 1] - time[i];
+    const double f = span > 0.0 ? (t - time[i]) / span : 0.0;
+    out_lat = lat[i] + (lat[i + 1] - lat[i]) * f;
+    out_lon = lon[i] + (lon[i + 1] - lon[i]) * f;
+    out_h = h[i] + (h[i + 1] - h[i]) * f;
+    return true;
+}
+
+void TrajectoryStore::interpolate(double t, const std::vector<uint32_t>& candidates, PositionSnapshot& out) const {
+    // Pass 1: locate each flight's active segment (the only branchy part)
+    std::vector<uint64_t> segment;
+    segment.reserve(candidates.size());
+    const size_t base = out.size();
+    for (uint32_t f : candidates) {
+        if (count[f] == 1) {
+            // Single-sample flight: interpolate between the sample and itself
+            segment.push_back(first[f]);
+        } else {
+            segment.push_back(first[f] + segmentAt(f, t));
+        }
+        out.flight.push_back(f);
+    }
+
+    // Pass 2: interpolation over contiguous arrays, no branches (vectorizable)
+    const size_t n = segment.size();
+    out.lat.resize(base + n);
+    out.lon.resize(base + n);
+    out.h.resize(base + n);
+    double* olat = out.lat.data() + base;
+    double* olon = out.lon.data() + base;
+    double* oh = out.h.data() + base;
+    const uint64_t* seg = segment.data();
+    const uint32_t* fl = out.flight.data() + base;
+    for (size_t k = 0; k < n; ++k) {
+        const uint64_t i = seg[k];
+        const uint64_t j = i + (count[fl[k]] > 1 ? 1 : 0);
+        const double span = time[j] - time[i];
+        const double w = span > 0.0 ? (t - time[i]) / span : 0.0;
+        olat[k] = lat[i] + (lat[j] - lat[i]) * w;
+        olon[k] = lon[i] + (lon[j] - lon[i]) * w;
+        oh[k] = h[i] + (h[j] - h[i]) * w;
+    }
+}
+
+void TrajectoryStore::positionsAt(double t, PositionSnapshot& out) const {
+    out.clear();
+    std::vector<uint32_t> active;
+    const size_t flights = ids.size();
+    for (size_t f = 0; f < flights; ++f) {
+        if (t_begin[f] <= t && t <= t_end[f]) active.push_back(static_cast<uint32_t>(f));
+    }
+    interpolate(t, active, out);
+}
+
+void TrajectoryStore::positionsInBox(double t, double min_lon, double min_lat, double max_lon, double max_lat,
+                                     PositionSnapshot& out) const {
+    out.clear();
+    // Time window and whole-flight bbox prune before any interpolation
+    std::vector<uint32_t> candidates;
+    const size_t flights = ids.size();
+    for (size_t f = 0; f < flights; ++f) {
+        if (t_begin[f] <= t && t <= t_end[f] &&
+            box_min_lon[f] <= max_lon && min_lon <= box_max_lon[f] &&
+            box_min_lat[f] <= max_lat && min_lat <= box_max_lat[f]) {
+            candidates.push_back(static_cast<uint32_t>(f));
+        }
+    }
+    interpolate(t, candidates, out);
+
+    // Keep only the positions inside the box (compaction in place)
+    size_t kept = 0;
+    for (size_t k = 0; k < out.size(); ++k) {
+        if (out.lon[k] >= min_lon && out.lon[k] <= max_lon && out.lat[k] >= min_lat && out.lat[k] <= max_lat) {
+            out.flight[kept] = out.flight[k];
+            out.lat[kept] = out.lat[k];
+            out.lon[kept] = out.lon[k];
+            out.h[kept] = out.h[k];
+            ++kept;
+        }
+    }
+    out.flight.resize(kept);
+    out.lat.resize(kept);
+    out.lon.resize(kept);
+    out.h.resize(kept);
+}
+
+} // namespace UPlanGeneration
@@ -0,0 +1,84 @@
+#ifndef TRAJECTORY_STORE_H
+#define TRAJECTORY_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "UplanGeneratorComplete.h"
+
+namespace UPlanGeneration {
+
+// Posiciones de varios vuelos en un instante (estructura de arrays)
+struct PositionSnapshot {
+    std::vector<uint32_t> flight;   // índice del vuelo en el TrajectoryStore
+    std::vector<double> lat;
+    std::vector<double> lon;
+    std::vector<double> h;
+
+    size_t size() const { return flight.size(); }
+    void clear() {
+        flight.clear();
+        lat.clear();
+        lon.clear();
+        h.clear();
+    }
+};
+
+// Almacén en memoria de trayectorias para reproducción y monitorización de conformidad.
+// Las muestras de todos los vuelos se guardan ordenadas por tiempo en columnas contiguas
+// (tiempo, lat, lon, h) con un índice temporal disperso por vuelo (una entrada cada
+// INDEX_STRIDE muestras), de modo que localizar el segmento activo cuesta una búsqueda
+// binaria sobre el índice y otra dentro de un bloque pequeño.
+class TrajectoryStore {
+public:
+    static const uint32_t INDEX_STRIDE = 32;
+
+    // Añade un vuelo; los tiempos de los waypoints son relativos a start_timestamp.
+    // Retorna el índice del vuelo.
+    uint32_t addFlight(const std::string& id, const std::vector<WaypointComplete>& waypoints, double start_timestamp);
+
+    size_t flightCount() const { return ids.size(); }
+    size_t sampleCount() const { return time.size(); }
+    const std::string& flightId(uint32_t flight) const { return ids[flight]; }
+    double beginTime(uint32_t flight) const { return t_begin[flight]; }
+    double endTime(uint32_t flight) const { return t_end[flight]; }
+
+    // Posición interpolada de un vuelo en t (unix timestamp); false si no está en vuelo
+    bool positionOf(uint32_t flight, double t, double& lat, double& lon, double& h) const;
+
+    // Posiciones de todos los vuelos activos en t
+    void positionsAt(double t, PositionSnapshot& out) const;
+
+    // Posiciones de los vuelos activos en t que están dentro del bbox
+    void positionsInBox(double t, double min_lon, double min_lat, double max_lon, double max_lat,
+                        PositionSnapshot& out) const;
+
+private:
+    // Columnas de muestras (todas los vuelos, concatenadas)
+    std::vector<double> time;
+    std::vector<double> lat;
+    std::vector<double> lon;
+    std::vector<double> h;
+
+    // Por vuelo
+    std::vector<std::string> ids;
+    std::vector<uint64_t> first;        // primera muestra
+    std::vector<uint32_t> count;        // número de muestras
+    std::vector<double> t_begin;
+    std::vector<double> t_end;
+    std::vector<double> box_min_lon, box_min_lat, box_max_lon, box_max_lat;
+    std::vector<uint64_t> index_first;  // primera entrada del índice disperso
+
+    // Índice disperso: tiempo de las muestras 0, INDEX_STRIDE, 2*INDEX_STRIDE, ... de cada vuelo
+    std::vector<double> index_time;
+
+    // Muestra i tal que time[i] <= t < time[i + 1] (relativa al vuelo)
+    uint32_t segmentAt(uint32_t flight, double t) const;
+
+    // Interpola las posiciones de los vuelos candidatos activos en t
+    void interpolate(double t, const std::vector<uint32_t>& candidates, PositionSnapshot& out) const;
+};
+
+} // namespace UPlanGeneration
+
+#endif // TRAJECTORY_STORE_H
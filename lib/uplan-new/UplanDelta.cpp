@@ -0,0 +1,340 @@
+#include "UplanDelta.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <map>
+
+namespace UPlanGeneration {
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 1469598103934665603ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+constexpr char DELTA_MAGIC[4] = {'U', 'V', 'D', '1'};
+
+enum DeltaOp : uint8_t {
+    DELTA_RETIME = 1,
+    DELTA_REPLACE = 2
+};
+
+void hashBytes(uint64_t& hash, const void* data, size_t length) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+}
+
+void hashValue(uint64_t& hash, const nlohmann::json& value) {
+    // The type tag keeps 1, 1.0, "1" and [1] apart
+    uint8_t type = static_cast<uint8_t>(value.type());
+    hashBytes(hash, &type, 1);
+    switch (value.type()) {
+        case nlohmann::json::value_t::object:
+            // Keys are stored sorted, so equal objects hash equally
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                hashBytes(hash, it.key().data(), it.key().size() + 1);
+                hashValue(hash, it.value());
+            }
+            break;
+        case nlohmann::json::value_t::array:
+            for (const auto& item : value) hashValue(hash, item);
+            break;
+        case nlohmann::json::value_t::string: {
+            const auto& text = value.get_ref<const std::string&>();
+            hashBytes(hash, text.data(), text.size());
+            break;
+        }
+        case nlohmann::json::value_t::number_float: {
+            double number = value.get<double>();
+            hashBytes(hash, &number, sizeof(number));
+            break;
+        }
+        case nlohmann::json::value_t::number_integer:
+        case nlohmann::json::value_t::number_unsigned: {
+            // 10 and 10u compare equal in nlohmann::json
+            int64_t number = value.get<int64_t>();
+            hashBytes(hash, &number, sizeof(number));
+            break;
+        }
+        case nlohmann::json::value_t::boolean: {
+            uint8_t flag = value.get<bool>() ? 1 : 0;
+            hashBytes(hash, &flag, 1);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// RFC 6901: '~' -> "~0", '/' -> "~1"
+std::string pointerToken(const std::string& key) {
+    std::string token;
+    token.reserve(key.size());
+    for (char c : key) {
+        if (c == '~') token += "~0";
+        else if (c == '/') token += "~1";
+        else token += c;
+    }
+    return token;
+}
+
+void addOperation(nlohmann::json& patch, const char* op, const std::string& path, const nlohmann::json* value = nullptr) {
+    nlohmann::json operation = {{"op", op}, {"path", path}};
+    if (value) operation["value"] = *value;
+    patch.push_back(std::move(operation));
+}
+
+bool isTimeField(const std::string& key) {
+    return key == "timeBegin" || key == "timeEnd";
+}
+
+// Field-by-field diff of two volumes at the same position
+void diffVolume(const nlohmann::json& old_volume, const nlohmann::json& new_volume, const std::string& path,
+                nlohmann::json& patch, UplanDeltaStats& stats) {
+    bool reshaped = false;
+    bool retimed = false;
+
+    for (auto it = new_volume.begin(); it != new_volume.end(); ++it) {
+        const std::string field = path + "/" + pointerToken(it.key());
+        auto previous = old_volume.find(it.key());
+        if (previous == old_volume.end()) {
+            addOperation(patch, "add", field, &it.value());
+        } else if (it.key() == "geometry" ? jsonContentHash(*previous) == jsonContentHash(it.value())
+                                          : *previous == it.value()) {
+            continue;
+        } else {
+            addOperation(patch, "replace", field, &it.value());
+        }
+        (isTimeField(it.key()) ? retimed : reshaped) = true;
+    }
+    for (auto it = old_volume.begin(); it != old_volume.end(); ++it) {
+        if (!new_volume.contains(it.key())) {
+            addOperation(patch, "remove", path + "/" + pointerToken(it.key()));
+            reshaped = true;
+        }
+    }
+
+    if (reshaped) ++stats.volumes_reshaped;
+    else if (retimed) ++stats.volumes_retimed;
+    else ++stats.volumes_kept;
+}
+
+bool sameOrdinal(const nlohmann::json& a, const nlohmann::json& b) {
+    auto ordinal_a = a.find("ordinal");
+    auto ordinal_b = b.find("ordinal");
+    return ordinal_a != a.end() && ordinal_b != b.end() && *ordinal_a == *ordinal_b;
+}
+
+void diffVolumes(const nlohmann::json& old_volumes, const nlohmann::json& new_volumes, nlohmann::json& patch,
+                 UplanDeltaStats& stats) {
+    const std::string base = "/operationVolumes/";
+    const size_t common = std::min(old_volumes.size(), new_volumes.size());
+
+    for (size_t i = 0; i < common; ++i) {
+        const auto& old_volume = old_volumes[i];
+        const auto& new_volume = new_volumes[i];
+        if (old_volume.is_object() && new_volume.is_object() && sameOrdinal(old_volume, new_volume)) {
+            diffVolume(old_volume, new_volume, base + std::to_string(i), patch, stats);
+        } else if (old_volume != new_volume) {
+            // Patch paths are positional: a different volume in this slot is replaced whole
+            addOperation(patch, "replace", base + std::to_string(i), &new_volume);
+            ++stats.volumes_reshaped;
+        } else {
+            ++stats.volumes_kept;
+        }
+    }
+    // Remove from the end so that the remaining indices stay valid
+    for (size_t i = old_volumes.size(); i > common; --i) {
+        addOperation(patch, "remove", base + std::to_string(i - 1));
+        ++stats.volumes_removed;
+    }
+    for (size_t i = common; i < new_volumes.size(); ++i) {
+        addOperation(patch, "add", base + "-", &new_volumes[i]);
+        ++stats.volumes_added;
+    }
+}
+
+bool sameShape(const VolumeRecord& a, const VolumeRecord& b) {
+    // Ordinal, corners, bbox and altitudes: everything between plan_id and the time window
+    constexpr size_t begin = offsetof(VolumeRecord, ordinal);
+    constexpr size_t end = offsetof(VolumeRecord, time_begin);
+    return std::memcmp(reinterpret_cast<const char*>(&a) + begin, reinterpret_cast<const char*>(&b) + begin,
+                       end - begin) == 0;
+}
+
+template <typename T>
+void appendRaw(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+struct DeltaReader {
+    const std::string& data;
+    size_t offset = 0;
+
+    template <typename T>
+    bool read(T& value) {
+        if (data.size() - offset < sizeof(T)) return false;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+};
+
+} // namespace
+
+uint64_t jsonContentHash(const nlohmann::json& value) {
+    uint64_t hash = FNV_OFFSET;
+    hashValue(hash, value);
+    return hash;
+}
+
+nlohmann::json diffUplan(const nlohmann::json& old_uplan, const nlohmann::json& new_uplan, UplanDeltaStats* stats) {
+    UplanDeltaStats local;
+    UplanDeltaStats& s = stats ? *stats : local;
+    s = UplanDeltaStats();
+    nlohmann::json patch = nlohmann::json::array();
+
+    if (!old_uplan.is_object() || !new_uplan.is_object()) {
+        if (old_uplan != new_uplan) {
+            addOperation(patch, "replace", "", &new_uplan);
+            ++s.fields_changed;
+        }
+        return patch;
+    }
+
+    for (auto it = new_uplan.begin(); it != new_uplan.end(); ++it) {
+        const std::string path = "/" + pointerToken(it.key());
+        auto previous = old_uplan.find(it.key());
+        if (previous == old_uplan.end()) {
+            addOperation(patch, "add", path, &it.value());
+            ++s.fields_changed;
+        } else if (it.key() == "operationVolumes" && previous->is_array() && it.value().is_array()) {
+            diffVolumes(*previous, it.value(), patch, s);
+        } else if (*previous != it.value()) {
+            addOperation(patch, "replace", path, &it.value());
+            ++s.fields_changed;
+        }
+    }
+    for (auto it = old_uplan.begin(); it != old_uplan.end(); ++it) {
+        if (!new_uplan.contains(it.key())) {
+            addOperation(patch, "remove", "/" + pointerToken(it.key()));
+            ++s.fields_changed;
+        }
+    }
+    return patch;
+}
+
+std::string encodeVolumeDelta(const std::vector<VolumeRecord>& old_volumes,
+                              const std::vector<VolumeRecord>& new_volumes, UplanDeltaStats* stats) {
+    UplanDeltaStats local;
+    UplanDeltaStats& s = stats ? *stats : local;
+    s = UplanDeltaStats();
+    const size_t common = std::min(old_volumes.size(), new_volumes.size());
+
+    // Most frequent shift among unchanged shapes with unchanged duration: a re-timed
+    // plan then costs one header field instead of one operation per volume
+    std::map<int64_t, size_t> votes;
+    for (size_t i = 0; i < common; ++i) {
+        const VolumeRecord& a = old_volumes[i];
+        const VolumeRecord& b = new_volumes[i];
+        if (sameShape(a, b) && b.time_end - b.time_begin == a.time_end - a.time_begin) {
+            ++votes[b.time_begin - a.time_begin];
+        }
+    }
+    int64_t shift = 0;
+    size_t best = 0;
+    for (const auto& [candidate, count] : votes) {
+        if (count > best) {
+            best = count;
+            shift = candidate;
+        }
+    }
+
+    std::string ops;
+    uint32_t op_count = 0;
+    for (size_t i = 0; i < new_volumes.size(); ++i) {
+        const VolumeRecord& b = new_volumes[i];
+        uint32_t position = static_cast<uint32_t>(i);
+        if (i >= common || !sameShape(old_volumes[i], b)) {
+            appendRaw(ops, DELTA_REPLACE);
+            appendRaw(ops, position);
+            appendRaw(ops, b);
+            ++op_count;
+            ++(i >= common ? s.volumes_added : s.volumes_reshaped);
+        } else if (b.time_begin != old_volumes[i].time_begin + shift || b.time_end != old_volumes[i].time_end + shift) {
+            appendRaw(ops, DELTA_RETIME);
+            appendRaw(ops, position);
+            appendRaw(ops, b.time_begin);
+            appendRaw(ops, b.time_end);
+            ++op_count;
+            ++s.volumes_retimed;
+        } else {
+            ++(shift != 0 ? s.volumes_retimed : s.volumes_kept);
+        }
+    }
+    s.volumes_removed = old_volumes.size() - common;
+
+    std::string delta;
+    delta.reserve(4 + sizeof(int32_t) + sizeof(uint32_t) + sizeof(int64_t) + sizeof(uint32_t) + ops.size());
+    delta.append(DELTA_MAGIC, sizeof(DELTA_MAGIC));
+    appendRaw(delta, new_volumes.empty() ? (old_volumes.empty() ? int32_t{0} : old_volumes.front().plan_id)
+                                         : new_volumes.front().plan_id);
+    appendRaw(delta, static_cast<uint32_t>(new_volumes.size()));
+    appendRaw(delta, shift);
+    appendRaw(delta, op_count);
+    delta += ops;
+    return delta;
+}
+
+bool applyVolumeDelta(const std::vector<VolumeRecord>& old_volumes, const std::string& delta,
+                      std::vector<VolumeRecord>& new_volumes) {
+    if (delta.size() < sizeof(DELTA_MAGIC) || std::memcmp(delta.data(), DELTA_MAGIC, sizeof(DELTA_MAGIC)) != 0) {
+        return false;
+    }
+    DeltaReader reader{delta, sizeof(DELTA_MAGIC)};
+    int32_t plan_id;
+    uint32_t count;
+    int64_t shift;
+    uint32_t op_count;
+    if (!reader.read(plan_id) || !reader.read(count) || !reader.read(shift) || !reader.read(op_count)) return false;
+    // Every operation takes at least a type and a position
+    if (op_count > (delta.size() - reader.offset) / (sizeof(uint8_t) + sizeof(uint32_t))) return false;
+    // Slots past the old set only exist through REPLACE, so a larger count cannot be
+    // valid: reject it before it sizes the result from an untrusted header
+    if (count > old_volumes.size() + op_count) return false;
+
+    std::vector<VolumeRecord> result(count);
+    std::vector<bool> replaced(count, false);
+    for (uint32_t i = 0; i < count && i < old_volumes.size(); ++i) {
+        result[i] = old_volumes[i];
+        result[i].time_begin += shift;
+        result[i].time_end += shift;
+    }
+
+    for (uint32_t op = 0; op < op_count; ++op) {
+        uint8_t type;
+        uint32_t position;
+        if (!reader.read(type) || !reader.read(position) || position >= count) return false;
+        if (type == DELTA_REPLACE) {
+            if (!reader.read(result[position])) return false;
+            replaced[position] = true;
+        } else if (type == DELTA_RETIME) {
+            if (position >= old_volumes.size()) return false;
+            if (!reader.read(result[position].time_begin) || !reader.read(result[position].time_end)) return false;
+        } else {
+            return false;
+        }
+    }
+    if (reader.offset != delta.size()) return false;
+    // Slots past the old set only exist through REPLACE
+    for (uint32_t i = static_cast<uint32_t>(std::min<size_t>(count, old_volumes.size())); i < count; ++i) {
+        if (!replaced[i]) return false;
+    }
+
+    for (auto& volume : result) volume.plan_id = plan_id;
+    new_volumes = std::move(result);
+    return true;
+}
+
+} // namespace UPlanGeneration
@@ -0,0 +1,54 @@
+#ifndef UPLAN_DELTA_H
+#define UPLAN_DELTA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "VolumeRecord.h"
+
+namespace UPlanGeneration {
+
+// Resumen de una comparación entre dos versiones de un plan
+struct UplanDeltaStats {
+    size_t volumes_kept = 0;       // iguales
+    size_t volumes_retimed = 0;    // misma geometría y altitudes, otra ventana temporal
+    size_t volumes_reshaped = 0;   // geometría o altitudes distintas
+    size_t volumes_added = 0;
+    size_t volumes_removed = 0;
+    size_t fields_changed = 0;     // campos del plan fuera de operationVolumes
+};
+
+// Diferencia entre dos Uplans como JSON Patch (RFC 6902), aplicable con
+// nlohmann::json::patch o con cualquier implementación estándar. Los volúmenes se
+// emparejan por ordinal; la geometría se compara por hash (un polígono distinto se
+// reemplaza entero, no coordenada a coordenada) y la ventana temporal campo a campo,
+// de modo que un plan re-programado sólo envía timeBegin/timeEnd de cada volumen.
+nlohmann::json diffUplan(const nlohmann::json& old_uplan, const nlohmann::json& new_uplan,
+                         UplanDeltaStats* stats = nullptr);
+
+// Hash (FNV-1a 64) del contenido de un valor JSON, sin serializarlo
+uint64_t jsonContentHash(const nlohmann::json& value);
+
+// Delta binario entre dos conjuntos de VolumeRecord del mismo plan (ordinal = posición,
+// como los genera generateVolumeRecords). Si todos los volúmenes conservados se han
+// desplazado el mismo tiempo, el desplazamiento va una sola vez en la cabecera.
+//
+// Formato (little-endian, nativo como VolumeRecord):
+//   "UVD1" | int32 plan_id | uint32 volúmenes | int64 desplazamiento (s) | uint32 operaciones
+//   operaciones: uint8 tipo | uint32 posición | datos
+//     RETIME  (1): int64 time_begin, int64 time_end
+//     REPLACE (2): VolumeRecord completo
+std::string encodeVolumeDelta(const std::vector<VolumeRecord>& old_volumes,
+                              const std::vector<VolumeRecord>& new_volumes,
+                              UplanDeltaStats* stats = nullptr);
+
+// Reconstruye los volúmenes nuevos a partir de los anteriores y el delta; false si el
+// delta está corrupto o no corresponde a esos volúmenes
+bool applyVolumeDelta(const std::vector<VolumeRecord>& old_volumes, const std::string& delta,
+                      std::vector<VolumeRecord>& new_volumes);
+
+} // namespace UPlanGeneration
+
+#endif // UPLAN_DELTA_H
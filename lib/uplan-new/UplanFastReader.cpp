@@ -0,0 +1,370 @@
+#include "UplanFastReader.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace UPlanGeneration {
+
+namespace {
+
+// Forward-only cursor over the JSON bytes
+struct Cursor {
+    const char* p;
+    const char* end;
+    const char* begin;
+    std::string* error;
+    bool failed = false;
+
+    bool fail(const char* what) {
+        if (!failed && error) {
+            *error = std::string(what) + " at byte " + std::to_string(p - begin);
+        }
+        failed = true;
+        p = end;
+        return false;
+    }
+
+    void ws() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+    }
+
+    bool consume(char c) {
+        ws();
+        if (p < end && *p == c) {
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    bool expect(char c) {
+        if (consume(c)) return true;
+        return fail("unexpected character");
+    }
+
+    // Positions p after the closing quote; [s, s + n) is the raw (still escaped) content
+    bool string(const char*& s, size_t& n) {
+        ws();
+        if (p >= end || *p != '"') return fail("expected string");
+        s = ++p;
+        while (true) {
+#if defined(__SSE2__)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i slash = _mm_set1_epi8('\\');
+            while (p + 16 <= end) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                          _mm_cmpeq_epi8(chunk, slash)));
+                if (mask != 0) {
+                    p += __builtin_ctz(static_cast<unsigned>(mask));
+                    break;
+                }
+                p += 16;
+            }
+#endif
+            while (p < end && *p != '"' && *p != '\\') ++p;
+            if (p >= end) return fail("unterminated string");
+            if (*p == '\\') {
+                p += 2;   // skip the escaped character
+                continue;
+            }
+            n = static_cast<size_t>(p - s);
+            ++p;
+            return true;
+        }
+    }
+
+    bool number(double& value) {
+        ws();
+        auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc()) return fail("expected number");
+        p = result.ptr;
+        return true;
+    }
+
+    // Integral value within int32 (ids and ordinals); 3.0 is accepted as 3
+    bool integer(int32_t& value) {
+        double d;
+        if (!number(d)) return false;
+        if (!(d >= std::numeric_limits<int32_t>::min() && d <= std::numeric_limits<int32_t>::max()) ||
+            std::trunc(d) != d) {
+            return fail("expected 32-bit integer");
+        }
+        value = static_cast<int32_t>(d);
+        return true;
+    }
+
+    bool skipValue() {
+        ws();
+        if (p >= end) return fail("unexpected end of input");
+        const char* s = nullptr;
+        size_t n = 0;
+        switch (*p) {
+        case '"':
+            return string(s, n);
+        case '{':
+        case '[': {
+            int depth = 0;
+            while (p < end) {
+                char c = *p;
+                if (c == '"') {
+                    if (!string(s, n)) return false;
+                    continue;
+                }
+                if (c == '{' || c == '[') ++depth;
+                else if (c == '}' || c == ']') {
+                    if (--depth == 0) {
+                        ++p;
+                        return true;
+                    }
+                }
+                ++p;
+            }
+            return fail("unterminated container");
+        }
+        default:
+            // number, true, false, null
+            while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+                   *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') ++p;
+            return true;
+        }
+    }
+
+    // fn(key, key_length) must consume the member value
+    template <typename Fn>
+    bool object(Fn fn) {
+        if (!expect('{')) return false;
+        if (consume('}')) return true;
+        do {
+            const char* key = nullptr;
+            size_t key_length = 0;
+            if (!string(key, key_length) || !expect(':')) return false;
+            if (!fn(key, key_length)) return false;
+        } while (consume(','));
+        return expect('}');
+    }
+
+    // fn(index) must consume the element
+    template <typename Fn>
+    bool array(Fn fn) {
+        if (!expect('[')) return false;
+        if (consume(']')) return true;
+        size_t index = 0;
+        do {
+            if (!fn(index++)) return false;
+        } while (consume(','));
+        return expect(']');
+    }
+};
+
+bool keyIs(const char* key, size_t length, const char* literal) {
+    size_t n = std::strlen(literal);
+    return n == length && std::memcmp(key, literal, n) == 0;
+}
+
+int parseDigits(const char* s, int count) {
+    int v = 0;
+    for (int i = 0; i < count; ++i) v = v * 10 + (s[i] - '0');
+    return v;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+long long daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    const long long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+bool parseAltitude(Cursor& c, double& value) {
+    return c.object([&](const char* key, size_t length) {
+        if (keyIs(key, length, "value")) return c.number(value);
+        return c.skipValue();
+    });
+}
+
+bool parseGeometry(Cursor& c, VolumeRecord& rec, int& corners, bool& has_bbox) {
+    return c.object([&](const char* key, size_t length) {
+        if (keyIs(key, length, "coordinates")) {
+            return c.array([&](size_t ring) {
+                if (ring > 0) return c.skipValue();   // holes are not generated
+                return c.array([&](size_t point) {
+                    if (point >= 4) return c.skipValue();   // closing point repeats corner 0
+                    ++corners;
+                    return c.array([&](size_t axis) {
+                        if (axis == 0) return c.number(rec.corner_lon[point]);
+                        if (axis == 1) return c.number(rec.corner_lat[point]);
+                        return c.skipValue();
+                    });
+                });
+            });
+        }
+        if (keyIs(key, length, "bbox")) {
+            has_bbox = true;
+            return c.array([&](size_t i) {
+                switch (i) {
+                case 0: return c.number(rec.min_lon);
+                case 1: return c.number(rec.min_lat);
+                case 2: return c.number(rec.max_lon);
+                case 3: return c.number(rec.max_lat);
+                default: return c.skipValue();
+                }
+            });
+        }
+        return c.skipValue();
+    });
+}
+
+bool parseTime(Cursor& c, int64_t& out) {
+    const char* s = nullptr;
+    size_t n = 0;
+    if (!c.string(s, n)) return false;
+    long long t;
+    if (!parseIsoTimestamp(s, n, t)) return c.fail("invalid timestamp");
+    out = t;
+    return true;
+}
+
+bool parseVolume(Cursor& c, VolumeRecord& rec) {
+    rec = VolumeRecord{};
+    int corners = 0;
+    bool has_bbox = false;
+
+    bool ok = c.object([&](const char* key, size_t length) {
+        if (keyIs(key, length, "geometry")) return parseGeometry(c, rec, corners, has_bbox);
+        if (keyIs(key, length, "timeBegin")) return parseTime(c, rec.time_begin);
+        if (keyIs(key, length, "timeEnd")) return parseTime(c, rec.time_end);
+        if (keyIs(key, length, "minAltitude")) return parseAltitude(c, rec.min_alt);
+        if (keyIs(key, length, "maxAltitude")) return parseAltitude(c, rec.max_alt);
+        if (keyIs(key, length, "ordinal")) {
+            return c.integer(rec.ordinal);
+        }
+        return c.skipValue();
+    });
+    if (!ok) return false;
+
+    for (int j = corners; j < 4 && corners > 0; ++j) {
+        rec.corner_lon[j] = rec.corner_lon[corners - 1];
+        rec.corner_lat[j] = rec.corner_lat[corners - 1];
+    }
+    if (!has_bbox && corners > 0) {
+        rec.min_lon = *std::min_element(rec.corner_lon, rec.corner_lon + 4);
+        rec.max_lon = *std::max_element(rec.corner_lon, rec.corner_lon + 4);
+        rec.min_lat = *std::min_element(rec.corner_lat, rec.corner_lat + 4);
+        rec.max_lat = *std::max_element(rec.corner_lat, rec.corner_lat + 4);
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseIsoTimestamp(const char* s, size_t n, long long& timestamp) {
+    auto isDigits = [&](size_t pos, size_t count) {
+        if (pos + count > n) return false;
+        for (size_t i = pos; i < pos + count; ++i) {
+            if (s[i] < '0' || s[i] > '9') return false;
+        }
+        return true;
+    };
+    if (n < 19 || !isDigits(0, 4) || s[4] != '-' || !isDigits(5, 2) || s[7] != '-' || !isDigits(8, 2) ||
+        (s[10] != 'T' && s[10] != ' ') || !isDigits(11, 2) || s[13] != ':' || !isDigits(14, 2) ||
+        s[16] != ':' || !isDigits(17, 2)) {
+        return false;
+    }
+
+    long long days = daysFromCivil(parseDigits(s, 4), parseDigits(s + 5, 2), parseDigits(s + 8, 2));
+    timestamp = days * 86400 + parseDigits(s + 11, 2) * 3600 + parseDigits(s + 14, 2) * 60 + parseDigits(s + 17, 2);
+
+    size_t pos = 19;
+    if (pos < n && s[pos] == '.') {
+        ++pos;
+        while (pos < n && s[pos] >= '0' && s[pos] <= '9') ++pos;   // whole seconds only
+    }
+    if (pos < n && (s[pos] == '+' || s[pos] == '-')) {
+        if (!isDigits(pos + 1, 2) || pos + 6 > n || s[pos + 3] != ':' || !isDigits(pos + 4, 2)) return false;
+        long long offset = parseDigits(s + pos + 1, 2) * 3600 + parseDigits(s + pos + 4, 2) * 60;
+        timestamp -= (s[pos] == '+') ? offset : -offset;
+    }
+    return true;
+}
+
+UplanFastReader::UplanFastReader(const std::string& volumes_key) : volumes_key(volumes_key) {}
+
+bool UplanFastReader::read(const char* data, size_t length, std::vector<VolumeRecord>& out, int* plan_id) {
+    error.clear();
+    Cursor c{data, data + length, data, &error};
+    size_t first = out.size();
+    int32_t id = 0;
+
+    bool ok = c.object([&](const char* key, size_t key_length) {
+        if (keyIs(key, key_length, "idplan")) return c.integer(id);
+        if (key_length == volumes_key.size() && std::memcmp(key, volumes_key.data(), key_length) == 0) {
+            c.ws();
+            if (c.p < c.end && *c.p == 'n') return c.skipValue();   // null
+            return c.array([&](size_t) {
+                VolumeRecord rec;
+                if (!parseVolume(c, rec)) return false;
+                out.push_back(rec);
+                return true;
+            });
+        }
+        return c.skipValue();
+    });
+
+    if (!ok) {
+        out.resize(first);
+        std::cerr << "[ERROR] Failed to read Uplan: " << error << std::endl;
+        return false;
+    }
+
+    // idplan may appear after the volumes
+    for (size_t i = first; i < out.size(); ++i) {
+        out[i].plan_id = id;
+    }
+    if (plan_id) *plan_id = id;
+    return true;
+}
+
+bool UplanFastReader::readFile(const std::string& path, std::vector<VolumeRecord>& out, int* plan_id) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        std::cerr << "[ERROR] Cannot open Uplan file: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        error = "empty file " + path;
+        std::cerr << "[ERROR] Empty Uplan file: " << path << std::endl;
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        error = "cannot mmap " + path;
+        std::cerr << "[ERROR] Cannot mmap Uplan file: " << path << std::endl;
+        return false;
+    }
+    madvise(base, size, MADV_SEQUENTIAL);
+
+    bool ok = read(static_cast<const char*>(base), size, out, plan_id);
+    munmap(base, size);
+    return ok;
+}
+
+} // namespace UPlanGeneration
@@ -0,0 +1,47 @@
+#ifndef UPLAN_FAST_READER_H
+#define UPLAN_FAST_READER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "VolumeRecord.h"
+
+namespace UPlanGeneration {
+
+// Lector "on-demand" de Uplans/OperationalIntents que rellena VolumeRecord
+// directamente desde los bytes del JSON, sin construir el DOM de nlohmann.
+//
+// Recorre el documento una sola vez: sólo decodifica idplan y los campos de los
+// volúmenes (geometry.coordinates, geometry.bbox, timeBegin/timeEnd,
+// minAltitude/maxAltitude.value, ordinal); el resto de valores se saltan sin
+// materializarlos (búsqueda de comillas con SSE2 cuando está disponible).
+// Pensado para cargar en bloque planes almacenados o respuestas FAS en un índice
+// de conflictos (VolumeStore, ShardRouter).
+class UplanFastReader {
+public:
+    // volumes_key: clave del array de volúmenes ("operationVolumes" en los Uplans;
+    // usar la del OperationalIntent correspondiente para leer OIs)
+    explicit UplanFastReader(const std::string& volumes_key = "operationVolumes");
+
+    // Añade a out los volúmenes del documento; plan_id recibe idplan (0 si no existe)
+    bool read(const char* data, size_t length, std::vector<VolumeRecord>& out, int* plan_id = nullptr);
+    bool read(const std::string& text, std::vector<VolumeRecord>& out, int* plan_id = nullptr) {
+        return read(text.data(), text.size(), out, plan_id);
+    }
+
+    // Lee un fichero (mapeado con mmap)
+    bool readFile(const std::string& path, std::vector<VolumeRecord>& out, int* plan_id = nullptr);
+
+    const std::string& lastError() const { return error; }
+
+private:
+    std::string volumes_key;
+    std::string error;
+};
+
+// Convierte "YYYY-MM-DDTHH:MM:SS[.fff][Z|+hh:mm]" a unix timestamp (s)
+bool parseIsoTimestamp(const char* text, size_t length, long long& timestamp);
+
+} // namespace UPlanGeneration
+
+#endif // UPLAN_FAST_READER_H
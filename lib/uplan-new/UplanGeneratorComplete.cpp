@@ -6,6 +6,8 @@
 #include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <algorithm>
 #include <GeographicLib/Geodesic.hpp>
 #include "Functions.h"
 
@@ -18,14 +20,18 @@ UplanGeneratorComplete::UplanGeneratorComplete() : config() {}
 UplanGeneratorComplete::UplanGeneratorComplete(const UplanConfigComplete& config) : config(config) {}
 
 std::vector<WaypointComplete> UplanGeneratorComplete::loadWaypointsFromCSV(const std::string& csv_path) {
-    std::vector<WaypointComplete> waypoints;
     std::ifstream file(csv_path);
     
     if (!file.is_open()) {
         std::cerr << "[ERROR] Cannot open trajectory file: " << csv_path << std::endl;
-        return waypoints;
+        return {};
     }
 
+    return loadWaypointsFromStream(file, csv_path);
+}
+
+std::vector<WaypointComplete> UplanGeneratorComplete::loadWaypointsFromStream(std::istream& file, const std::string& source) {
+    std::vector<WaypointComplete> waypoints;
     std::string line;
     bool headerSkipped = false;
 
@@ -74,7 +80,7 @@ std::vector<WaypointComplete> UplanGeneratorComplete::loadWaypointsFromCSV(const
     }
 
     if (!waypoints.empty()) {
-        std::cout << "[INFO] Loaded " << waypoints.size() << " waypoints from: " << csv_path << std::endl;
+        std::cout << "[INFO] Loaded " << waypoints.size() << " waypoints from: " << source << std::endl;
         std::cout << "[INFO] First waypoint: lat=" << waypoints.front().lat 
                   << ", lon=" << waypoints.front().lon 
                   << ", alt=" << waypoints.front().h 
@@ -88,6 +94,111 @@ std::vector<WaypointComplete> UplanGeneratorComplete::loadWaypointsFromCSV(const
     return waypoints;
 }
 
+size_t UplanGeneratorComplete::loadMultiFlightCSV(
+    const std::string& csv_path,
+    const std::function<void(const std::string& flight_id, std::vector<WaypointComplete>& waypoints)>& onFlight,
+    bool grouped) {
+
+    std::ifstream file(csv_path);
+    if (!file.is_open()) {
+        std::cerr << "[ERROR] Cannot open trajectory file: " << csv_path << std::endl;
+        return 0;
+    }
+
+    // Default layout: FlightId,SimTime,Lat,Lon,Alt,... (overridden by the header)
+    int col_id = 0, col_time = 1, col_lat = 2, col_lon = 3, col_alt = 4;
+    bool headerChecked = false;
+
+    std::map<std::string, std::vector<WaypointComplete>> buffers;
+    std::map<std::string, bool> delivered;
+    std::string current_id;
+    size_t flights = 0;
+
+    auto deliver = [&](std::string id) {
+        auto it = buffers.find(id);
+        if (it == buffers.end()) return;
+        if (!it->second.empty()) {
+            onFlight(id, it->second);
+            ++flights;
+        }
+        buffers.erase(it);
+        delivered[id] = true;
+    };
+
+    std::string line;
+    std::vector<std::string> fields;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        if (line.size() >= 2 && line[0] == '/' && line[1] == '/') continue;
+
+        fields.clear();
+        size_t start = 0;
+        while (true) {
+            size_t comma = line.find(',', start);
+            fields.push_back(line.substr(start, comma == std::string::npos ? std::string::npos : comma - start));
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+
+        if (!headerChecked) {
+            headerChecked = true;
+            if (line.find("SimTime") != std::string::npos || line.find("Lat") != std::string::npos) {
+                for (size_t c = 0; c < fields.size(); ++c) {
+                    const std::string& name = fields[c];
+                    if (name == "FlightId" || name == "FlightID" || name == "flight_id" || name == "Flight") col_id = static_cast<int>(c);
+                    else if (name == "SimTime" || name == "Time") col_time = static_cast<int>(c);
+                    else if (name == "Lat") col_lat = static_cast<int>(c);
+                    else if (name == "Lon") col_lon = static_cast<int>(c);
+                    else if (name == "Alt") col_alt = static_cast<int>(c);
+                }
+                continue;
+            }
+        }
+
+        int max_col = std::max({col_id, col_time, col_lat, col_lon, col_alt});
+        if (static_cast<int>(fields.size()) <= max_col) {
+            std::cerr << "[WARNING] Failed to parse line: " << line << " - missing columns" << std::endl;
+            continue;
+        }
+
+        WaypointComplete wp;
+        try {
+            wp.time = std::stod(fields[col_time]);
+            wp.lat = std::stod(fields[col_lat]);
+            wp.lon = std::stod(fields[col_lon]);
+            wp.h = std::stod(fields[col_alt]);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[WARNING] Failed to parse line: " << line << " - " << e.what() << std::endl;
+            continue;
+        }
+
+        const std::string& id = fields[col_id];
+        if (grouped && id != current_id) {
+            if (delivered.count(id)) {
+                // The flight was already handed off: its late rows can neither be merged
+                // nor delivered again (a second delivery would overwrite the first plan)
+                std::cerr << "[ERROR] Rows of flight " << id << " are not contiguous in " << csv_path
+                          << "; sort the file by flight or load it with grouped = false" << std::endl;
+                return 0;
+            }
+            // Rows of the previous flight are over: hand it off right away
+            if (!current_id.empty()) deliver(current_id);
+            current_id = id;
+        }
+        buffers[id].push_back(wp);
+    }
+
+    // Remaining flights (last one, or all of them when not grouped)
+    while (!buffers.empty()) {
+        deliver(buffers.begin()->first);
+    }
+
+    std::cout << "[INFO] Loaded " << flights << " flights from: " << csv_path << std::endl;
+    return flights;
+}
+
 std::vector<WaypointComplete> UplanGeneratorComplete::reduceWaypoints(
     const std::vector<WaypointComplete>& waypoints, int compression_factor) {
     
@@ -158,110 +269,294 @@ std::vector<Point> UplanGeneratorComplete::generateOrientedRectangleCorners(
     return corners;
 }
 
-std::vector<Volume> UplanGeneratorComplete::generateVolumes(
-    const std::vector<WaypointComplete>& wp_reduced, double start_timestamp) {
-    
-    std::vector<Volume> volumes;
-    volumes.reserve(wp_reduced.size() - 1);
+std::vector<SegmentGeometry> UplanGeneratorComplete::prepareSegments(
+    const std::vector<WaypointComplete>& wp_reduced) {
 
-    const double minimum_ground_clearance = 10.0;  // Minimum buffer above ground (meters)
+    std::vector<SegmentGeometry> segments;
+    if (wp_reduced.size() < 2) return segments;
+    segments.reserve(wp_reduced.size() - 1);
+
+    const Geodesic& geod = Geodesic::WGS84();
 
     for (size_t i = 0; i < wp_reduced.size() - 1; ++i) {
         const WaypointComplete& wp1 = wp_reduced[i];
         const WaypointComplete& wp2 = wp_reduced[i + 1];
 
-        double distance = calculateDistance(wp1.lat, wp1.lon, wp2.lat, wp2.lon);
-        double azimuth = calculateAzimuth(wp1.lat, wp1.lon, wp2.lat, wp2.lon);
+        SegmentGeometry seg;
+        // Distance and azimuth from a single inverse geodesic solution
+        double azi2;
+        geod.Inverse(wp1.lat, wp1.lon, wp2.lat, wp2.lon, seg.distance, seg.azimuth, azi2);
+
+        seg.mid_lat = (wp1.lat + wp2.lat) / 2.0;
+        seg.mid_lon = (wp1.lon + wp2.lon) / 2.0;
 
-        double mid_lat = (wp1.lat + wp2.lat) / 2.0;
-        double mid_lon = (wp1.lon + wp2.lon) / 2.0;
-        
         // For altitude, use min and max to cover the entire segment
-        double min_alt = std::min(wp1.h, wp2.h);
-        double max_alt = std::max(wp1.h, wp2.h);
-        double mid_alt = (min_alt + max_alt) / 2.0;
+        seg.min_h = std::min(wp1.h, wp2.h);
+        seg.max_h = std::max(wp1.h, wp2.h);
+
+        seg.time_start = wp1.time;
+        seg.time_end = wp2.time;
+
+        segments.push_back(seg);
+    }
+
+    return segments;
+}
+
+std::vector<VolumeRecord> UplanGeneratorComplete::buildVolumeRecords(
+    const std::vector<SegmentGeometry>& segments, const UplanConfigComplete& cfg,
+    double start_timestamp, int plan_id, GeozoneScreening* screening) {
+    
+    std::vector<VolumeRecord> records;
+
+    const bool amsl = cfg.altitude_reference == "AMSL";
+    if (amsl && !terrain) {
+        std::cerr << "[ERROR] AMSL altitude reference requires a DEM (setTerrain)" << std::endl;
+        return records;
+    }
+    records.reserve(segments.size());
+
+    const double minimum_ground_clearance = 10.0;  // Minimum buffer above ground (meters)
+    std::vector<size_t> zones;
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const SegmentGeometry& seg = segments[i];
+
+        double distance = seg.distance;
+        double mid_alt = (seg.min_h + seg.max_h) / 2.0;
 
         double horizontal_distance = distance;
-        double vertical_distance = std::abs(wp2.h - wp1.h);
+        double vertical_distance = seg.max_h - seg.min_h;
 
-        bool is_horizontal = horizontal_distance > config.Alpha_H * vertical_distance;
-        bool is_vertical = vertical_distance > config.Alpha_V * horizontal_distance;
+        bool is_horizontal = horizontal_distance > cfg.Alpha_H * vertical_distance;
+        bool is_vertical = vertical_distance > cfg.Alpha_V * horizontal_distance;
 
         double along_track, cross_track, vertical_buffer;
         
         if (is_horizontal) {
             // Horizontal segment: extend along track, standard cross track
-            along_track = distance / 2.0 + config.TSE_H;
-            cross_track = config.TSE_H;
-            vertical_buffer = config.TSE_V;
+            along_track = distance / 2.0 + cfg.TSE_H;
+            cross_track = cfg.TSE_H;
+            vertical_buffer = cfg.TSE_V;
         } else if (is_vertical) {
             // Vertical segment (takeoff/landing): minimal horizontal extent
-            along_track = config.TSE_H;
-            cross_track = config.TSE_H;
-            vertical_buffer = vertical_distance / 2.0 + config.TSE_V;
+            along_track = cfg.TSE_H;
+            cross_track = cfg.TSE_H;
+            vertical_buffer = vertical_distance / 2.0 + cfg.TSE_V;
         } else {
             // Mixed segment: cover both
-            along_track = distance / 2.0 + config.TSE_H;
-            cross_track = config.TSE_H;
-            vertical_buffer = vertical_distance / 2.0 + config.TSE_V;
+            along_track = distance / 2.0 + cfg.TSE_H;
+            cross_track = cfg.TSE_H;
+            vertical_buffer = vertical_distance / 2.0 + cfg.TSE_V;
         }
 
         std::vector<Point> corners = generateOrientedRectangleCorners(
-            mid_lat, mid_lon, azimuth, along_track, cross_track);
+            seg.mid_lat, seg.mid_lon, seg.azimuth, along_track, cross_track);
+
+        VolumeRecord rec;
+        rec.plan_id = plan_id;
+        rec.ordinal = static_cast<int32_t>(i);
 
         // Calculate bounding box
-        double minLon = std::numeric_limits<double>::max();
-        double maxLon = std::numeric_limits<double>::lowest();
-        double minLat = std::numeric_limits<double>::max();
-        double maxLat = std::numeric_limits<double>::lowest();
+        rec.min_lon = std::numeric_limits<double>::max();
+        rec.max_lon = std::numeric_limits<double>::lowest();
+        rec.min_lat = std::numeric_limits<double>::max();
+        rec.max_lat = std::numeric_limits<double>::lowest();
 
-        for (size_t j = 0; j < corners.size() - 1; ++j) {
+        for (size_t j = 0; j < 4; ++j) {
             double lon = corners[j].getLon();
             double lat = corners[j].getLat();
-            minLon = std::min(minLon, lon);
-            maxLon = std::max(maxLon, lon);
-            minLat = std::min(minLat, lat);
-            maxLat = std::max(maxLat, lat);
+            rec.corner_lon[j] = lon;
+            rec.corner_lat[j] = lat;
+            rec.min_lon = std::min(rec.min_lon, lon);
+            rec.max_lon = std::max(rec.max_lon, lon);
+            rec.min_lat = std::min(rec.min_lat, lat);
+            rec.max_lat = std::max(rec.max_lat, lat);
         }
 
-        std::vector<double> bbox = {minLon, minLat, maxLon, maxLat};
-        std::vector<std::vector<Point>> coordinates = {corners};
-        Geometry geometry("Polygon", coordinates, bbox);
-
         // Calculate altitude limits
         double minAltValue = mid_alt - vertical_buffer;
         if (minAltValue < minimum_ground_clearance) {
             minAltValue = minimum_ground_clearance;
         }
+        rec.min_alt = minAltValue;
+        rec.max_alt = mid_alt + vertical_buffer;
+
+        if (amsl) {
+            // Conservative AGL -> AMSL: lowest terrain under the rectangle for the
+            // floor, highest terrain for the ceiling
+            double ground_min, ground_max;
+            if (!terrain->heightRange(rec.min_lon, rec.min_lat, rec.max_lon, rec.max_lat, ground_min, ground_max)) {
+                std::cerr << "[ERROR] No terrain data for volume " << i << std::endl;
+                return {};
+            }
+            rec.min_alt += ground_min;
+            rec.max_alt += ground_max;
+        }
+
+        // Calculate time window
+        double segment_start_time = start_timestamp + seg.time_start;
+        double segment_end_time = start_timestamp + seg.time_end;
+
+        rec.time_begin = static_cast<long long>(segment_start_time - cfg.tbuf);
+        rec.time_end = static_cast<long long>(segment_end_time + cfg.tbuf);
+
+        if (screening && screening->index) {
+            screening->index->conflicts(rec, cfg.altitude_reference, zones);
+            for (size_t zone : zones) {
+                bool hard = screening->index->zone(zone).hard();
+                screening->conflicts.push_back({i, zone, hard, rec});
+                // Hard zones come first: stop before generating the rest of the plan
+                if (hard && screening->early_abort) {
+                    screening->aborted = true;
+                    return {};
+                }
+            }
+        }
 
-        Altitude minAltitude;
-        minAltitude.setValue(minAltValue);
-        minAltitude.setUom("M");
-        minAltitude.setReference("AGL");
+        records.push_back(rec);
+    }
 
-        Altitude maxAltitude;
-        maxAltitude.setValue(mid_alt + vertical_buffer);
-        maxAltitude.setUom("M");
-        maxAltitude.setReference("AGL");
+    return records;
+}
 
-        // Calculate time window
-        double segment_start_time = start_timestamp + wp1.time;
-        double segment_end_time = start_timestamp + wp2.time;
+std::vector<VolumeRecord> UplanGeneratorComplete::generateVolumeRecords(
+    const std::vector<WaypointComplete>& wp_reduced, double start_timestamp, int plan_id, GeozoneScreening* screening) {
+    return buildVolumeRecords(prepareSegments(wp_reduced), config, start_timestamp, plan_id, screening);
+}
+
+Volume UplanGeneratorComplete::toVolume(const VolumeRecord& rec) {
+    return buildVolume(rec, config.altitude_reference);
+}
+
+Volume UplanGeneratorComplete::buildVolume(const VolumeRecord& rec, const std::string& reference) {
+    std::vector<Point> corners;
+    corners.reserve(5);
+    for (size_t j = 0; j < 4; ++j) {
+        corners.push_back(Point(rec.corner_lon[j], rec.corner_lat[j]));
+    }
+    corners.push_back(Point(rec.corner_lon[0], rec.corner_lat[0])); // Close polygon
+
+    std::vector<double> bbox = {rec.min_lon, rec.min_lat, rec.max_lon, rec.max_lat};
+    std::vector<std::vector<Point>> coordinates = {corners};
+    Geometry geometry("Polygon", coordinates, bbox);
 
-        long long timeBeginSeconds = static_cast<long long>(segment_start_time - config.tbuf);
-        long long timeEndSeconds = static_cast<long long>(segment_end_time + config.tbuf);
+    Altitude minAltitude;
+    minAltitude.setValue(rec.min_alt);
+    minAltitude.setUom("M");
+    minAltitude.setReference(reference);
 
-        auto timeBegin = Functions::from_unix_timestamp(timeBeginSeconds);
-        auto timeEnd = Functions::from_unix_timestamp(timeEndSeconds);
+    Altitude maxAltitude;
+    maxAltitude.setValue(rec.max_alt);
+    maxAltitude.setUom("M");
+    maxAltitude.setReference(reference);
 
-        Volume volume(geometry, timeBegin, timeEnd, minAltitude, maxAltitude, static_cast<int>(i));
-        volumes.push_back(volume);
+    auto timeBegin = Functions::from_unix_timestamp(rec.time_begin);
+    auto timeEnd = Functions::from_unix_timestamp(rec.time_end);
+
+    return Volume(geometry, timeBegin, timeEnd, minAltitude, maxAltitude, rec.ordinal);
+}
+
+nlohmann::json UplanGeneratorComplete::pyramidToJson(const VolumePyramid& pyramid) {
+    nlohmann::json levels = nlohmann::json::array();
+    for (size_t l = 0; l < pyramid.levels.size(); ++l) {
+        const VolumeLevel& level = pyramid.levels[l];
+        nlohmann::json volumes = nlohmann::json::array();
+        for (size_t i = 0; i < level.records.size(); ++i) {
+            nlohmann::json vol = toVolume(level.records[i]).toJson();
+            vol["first"] = level.first[i];
+            vol["count"] = level.count[i];
+            volumes.push_back(std::move(vol));
+        }
+        levels.push_back({
+            {"level", l},
+            {"tolerance", level.tolerance},
+            {"maxZoom", level.max_zoom},
+            {"volumes", std::move(volumes)}
+        });
+    }
+
+    nlohmann::json envelope = nullptr;
+    if (!pyramid.levels.empty()) {
+        envelope = toVolume(pyramid.envelope).toJson();
+        envelope["first"] = 0;
+        envelope["count"] = pyramid.levels.front().records.size();
+    }
+
+    return {
+        {"idplan", pyramid.envelope.plan_id},
+        {"levels", std::move(levels)},
+        {"envelope", std::move(envelope)},
+        {"envelopeMaxZoom", pyramid.envelope_max_zoom}
+    };
+}
+
+std::vector<Volume> UplanGeneratorComplete::generateVolumes(
+    const std::vector<WaypointComplete>& wp_reduced, double start_timestamp, GeozoneScreening* screening) {
+    
+    std::vector<VolumeRecord> records = generateVolumeRecords(wp_reduced, start_timestamp, 0, screening);
+
+    std::vector<Volume> volumes;
+    volumes.reserve(records.size());
+    for (const auto& rec : records) {
+        volumes.push_back(toVolume(rec));
     }
 
     std::cout << "[INFO] Generated " << volumes.size() << " volumes" << std::endl;
     return volumes;
 }
 
+std::vector<std::vector<VolumeRecord>> UplanGeneratorComplete::generateVolumeRecordSweep(
+    const std::vector<WaypointComplete>& wp_reduced,
+    const std::vector<UplanConfigComplete>& configs,
+    double start_timestamp, int plan_id) {
+
+    // Geodesic distance/azimuth/midpoint are config-independent: compute once
+    std::vector<SegmentGeometry> segments = prepareSegments(wp_reduced);
+
+    std::vector<std::vector<VolumeRecord>> sweep;
+    sweep.reserve(configs.size());
+    for (const auto& cfg : configs) {
+        sweep.push_back(buildVolumeRecords(segments, cfg, start_timestamp, plan_id));
+    }
+    return sweep;
+}
+
+std::vector<std::vector<Volume>> UplanGeneratorComplete::generateVolumeSweep(
+    const std::string& trajectory_csv_path,
+    const std::vector<UplanConfigComplete>& configs,
+    double start_timestamp) {
+
+    std::vector<std::vector<Volume>> sweep;
+
+    auto waypoints = loadWaypointsFromCSV(trajectory_csv_path);
+    if (waypoints.empty()) {
+        std::cerr << "[ERROR] No waypoints loaded from: " << trajectory_csv_path << std::endl;
+        return sweep;
+    }
+
+    auto wp_reduced = reduceWaypoints(waypoints, WAYPOINT_COMPRESSION_FACTOR);
+    if (wp_reduced.size() < 2) {
+        std::cerr << "[ERROR] Not enough waypoints after reduction" << std::endl;
+        return sweep;
+    }
+
+    auto record_sets = generateVolumeRecordSweep(wp_reduced, configs, start_timestamp);
+    sweep.reserve(record_sets.size());
+    for (size_t c = 0; c < record_sets.size(); ++c) {
+        std::vector<Volume> volumes;
+        volumes.reserve(record_sets[c].size());
+        for (const auto& rec : record_sets[c]) {
+            volumes.push_back(buildVolume(rec, configs[c].altitude_reference));
+        }
+        sweep.push_back(std::move(volumes));
+    }
+
+    std::cout << "[INFO] Generated volume sweep: " << configs.size() << " configurations x "
+              << (wp_reduced.size() - 1) << " segments" << std::endl;
+    return sweep;
+}
+
 nlohmann::json UplanGeneratorComplete::generateDefaultDataIdentifier(
     const std::string& sac, const std::string& sic) {
     return {
@@ -316,12 +611,12 @@ nlohmann::json UplanGeneratorComplete::generateDefaultUAS(
     };
 }
 
-nlohmann::json UplanGeneratorComplete::generateDefaultLocation(double lat, double lon, double alt) {
+nlohmann::json UplanGeneratorComplete::generateDefaultLocation(
+    double lat, double lon, double alt, const std::string& reference) {
     return {
         {"type", "Point"},
         {"coordinates", nlohmann::json::array({lon, lat})},
-        {"reference", "AGL"},
-        {"altitude", alt}
+        {"properties", {{"altitude", alt}, {"reference", reference}}}   // GeoJSONPoint admits no other members
     };
 }
 
@@ -329,8 +624,7 @@ nlohmann::json UplanGeneratorComplete::generateTBDLocation() {
     return {
         {"type", "Point"},
         {"coordinates", nlohmann::json::array({0.0, 0.0})},
-        {"reference", "AGL"},
-        {"altitude", 0.0}
+        {"properties", {{"altitude", 0.0}, {"reference", "AGL"}}}
     };
 }
 
@@ -342,38 +636,117 @@ nlohmann::json UplanGeneratorComplete::generateCompleteUplan(
     const std::string& category,
     const std::string& uasType,
     double mtom,
-    double vMax) {
+    double vMax,
+    VolumePyramid* pyramid) {
 
-    // Load and reduce waypoints
+    // Load waypoints
     auto waypoints = loadWaypointsFromCSV(trajectory_csv_path);
     if (waypoints.empty()) {
         std::cerr << "[ERROR] No waypoints loaded from: " << trajectory_csv_path << std::endl;
         return {};
     }
 
-    auto wp_reduced = reduceWaypoints(waypoints,20);
+    return generateCompleteUplan(uplan_id, uplan_name, waypoints, start_timestamp,
+                                 category, uasType, mtom, vMax, pyramid);
+}
+
+bool UplanGeneratorComplete::planVolumeRecords(const std::string& uplan_name, const std::vector<WaypointComplete>& waypoints,
+                                               double start_timestamp, int uplan_id, std::vector<VolumeRecord>& records) {
+    if (waypoints.empty()) {
+        std::cerr << "[ERROR] No waypoints for: " << uplan_name << std::endl;
+        return false;
+    }
+
+    // Reduce waypoints
+    auto wp_reduced = reduceWaypoints(waypoints, WAYPOINT_COMPRESSION_FACTOR);
     if (wp_reduced.size() < 2) {
         std::cerr << "[ERROR] Not enough waypoints after reduction" << std::endl;
-        return {};
+        return false;
     }
 
-    auto volumes = generateVolumes(wp_reduced, start_timestamp);
+    // Single generation pass: the same records feed the Uplan volumes and the LOD pyramid
+    GeozoneScreening screening;
+    screening.index = geozones;
+    screening.early_abort = geozone_early_abort;
+    records = generateVolumeRecords(wp_reduced, start_timestamp, uplan_id, &screening);
+    if (!reportGeozoneConflicts(uplan_name, screening)) {
+        records.clear();
+        return false;
+    }
+    std::cout << "[INFO] Generated " << records.size() << " volumes" << std::endl;
+
+    if (records.empty()) {
+        std::cerr << "[ERROR] No volumes generated for: " << uplan_name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UplanGeneratorComplete::reportGeozoneConflicts(const std::string& uplan_name, const GeozoneScreening& screening) {
+    if (screening.conflicts.empty()) return true;
+
+    if (screening.aborted) {
+        const GeozoneConflict& conflict = screening.conflicts.back();
+        const Geozone& zone = geozones->zone(conflict.zone);
+        std::cerr << "[ERROR] Uplan " << uplan_name << " enters " << geozoneTypeName(zone.type) << " geozone "
+                  << zone.identifier << " at segment " << conflict.segment << " (t=" << conflict.volume.time_begin
+                  << ".." << conflict.volume.time_end << ", " << conflict.volume.min_alt << "-"
+                  << conflict.volume.max_alt << " m)" << std::endl;
+        return false;
+    }
+
+    // One line per zone: first segment and number of volumes inside
+    std::map<size_t, std::pair<size_t, size_t>> per_zone;
+    bool hard = false;
+    for (const auto& conflict : screening.conflicts) {
+        auto inserted = per_zone.insert({conflict.zone, {conflict.segment, 0}});
+        ++inserted.first->second.second;
+        hard = hard || conflict.hard;
+    }
+    for (const auto& [index, info] : per_zone) {
+        const Geozone& zone = geozones->zone(index);
+        std::cerr << (zone.hard() ? "[ERROR] " : "[WARNING] ") << "Uplan " << uplan_name << " crosses "
+                  << geozoneTypeName(zone.type) << " geozone " << zone.identifier << " in " << info.second
+                  << " volumes (first at segment " << info.first << ")" << std::endl;
+    }
+    return !hard;
+}
+
+nlohmann::json UplanGeneratorComplete::buildUplanDocument(
+    int uplan_id,
+    const std::string& uplan_name,
+    const std::vector<WaypointComplete>& waypoints,
+    const std::vector<VolumeRecord>& records,
+    const std::string& category,
+    const std::string& uasType,
+    double mtom,
+    double vMax) {
 
     // Get takeoff and landing positions
     const auto& takeoff = waypoints.front();
     const auto& landing = waypoints.back();
 
+    double takeoff_alt = takeoff.h;
+    double landing_alt = landing.h;
+    if (config.altitude_reference == "AMSL") {
+        double ground;
+        if (terrain->elevationAt(takeoff.lat, takeoff.lon, ground)) takeoff_alt += ground;
+        else std::cerr << "[WARNING] No terrain data at takeoff location" << std::endl;
+        if (terrain->elevationAt(landing.lat, landing.lon, ground)) landing_alt += ground;
+        else std::cerr << "[WARNING] No terrain data at landing location" << std::endl;
+    }
+
     // Generate ISO 8601 timestamp
     std::string iso_time = Functions::now_iso_string() + "Z";
 
     // Build volumes JSON array
     nlohmann::json volumesJson = nlohmann::json::array();
-    for (const auto& vol : volumes) {
-        volumesJson.push_back(vol.toJson());
+    for (const auto& rec : records) {
+        volumesJson.push_back(toVolume(rec).toJson());
     }
 
-    // Build complete Uplan according to schema
-    nlohmann::json uplanJson = {
+    // Build complete Uplan according to schema (rvalues are moved into the document, not copied)
+    return nlohmann::json{
         {"idplan", uplan_id},
         {"nameplan", uplan_name},
         {"dataOwnerIdentifier", generateDefaultDataIdentifier("TBD", "TBD")},
@@ -381,15 +754,50 @@ nlohmann::json UplanGeneratorComplete::generateCompleteUplan(
         {"contactDetails", generateDefaultContactDetails()},
         {"flightDetails", generateDefaultFlightDetails(category)},
         {"uas", generateDefaultUAS(uasType, mtom, vMax)},
-        {"takeoffLocation", generateDefaultLocation(takeoff.lat, takeoff.lon, takeoff.h)},
-        {"landingLocation", generateDefaultLocation(landing.lat, landing.lon, landing.h)},
+        {"takeoffLocation", generateDefaultLocation(takeoff.lat, takeoff.lon, takeoff_alt, config.altitude_reference)},
+        {"landingLocation", generateDefaultLocation(landing.lat, landing.lon, landing_alt, config.altitude_reference)},
         {"gcsLocation", generateTBDLocation()},
-        {"operationVolumes", volumesJson},
+        {"operationVolumes", std::move(volumesJson)},
         {"operatorId", "TBD"},
         {"state", "SENT"},
         {"creationTime", iso_time},
         {"updateTime", iso_time}
     };
+}
+
+nlohmann::json UplanGeneratorComplete::generateCompleteUplan(
+    int uplan_id,
+    const std::string& uplan_name,
+    const std::vector<WaypointComplete>& waypoints,
+    double start_timestamp,
+    const std::string& category,
+    const std::string& uasType,
+    double mtom,
+    double vMax,
+    VolumePyramid* pyramid) {
+
+    std::vector<VolumeRecord> records;
+    if (!planVolumeRecords(uplan_name, waypoints, start_timestamp, uplan_id, records)) {
+        return {};
+    }
+
+    nlohmann::json uplanJson = buildUplanDocument(uplan_id, uplan_name, waypoints, records,
+                                                  category, uasType, mtom, vMax);
+
+    if (pyramid) {
+        *pyramid = buildVolumePyramid(records, config.lod_tolerances);
+    }
+
+    if (validator) {
+        std::vector<std::string> errors;
+        if (!validator->validate(uplanJson, &errors)) {
+            std::cerr << "[ERROR] Generated Uplan " << uplan_name << " does not match the schema:" << std::endl;
+            for (const auto& error : errors) {
+                std::cerr << "        " << error << std::endl;
+            }
+            return {};
+        }
+    }
 
     return uplanJson;
 }
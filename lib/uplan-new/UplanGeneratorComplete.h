@@ -3,11 +3,18 @@
 
 #include <string>
 #include <vector>
+#include <functional>
+#include <istream>
 #include <nlohmann/json.hpp>
 #include "Volume.h"
 #include "Point.h"
 #include "Geometry.h"
 #include "Altitude.h"
+#include "VolumeRecord.h"
+#include "GeozoneIndex.h"
+#include "VolumePyramid.h"
+#include "DemTileCache.h"
+#include "UplanSchemaValidator.h"
 
 namespace UPlanGeneration {
 
@@ -18,12 +25,27 @@ struct WaypointComplete {
     double time;
 };
 
+// Geometría de un segmento independiente de la configuración (TSE/Alpha/tbuf).
+// Se calcula una vez por trayectoria y se reutiliza en los barridos de parámetros.
+struct SegmentGeometry {
+    double distance;    // distancia geodésica (m)
+    double azimuth;     // azimut inicial (grados)
+    double mid_lat;
+    double mid_lon;
+    double min_h;
+    double max_h;
+    double time_start;  // tiempo relativo de los waypoints (s)
+    double time_end;
+};
+
 struct UplanConfigComplete {
     double TSE_H = 15.0;
     double TSE_V = 10.0;
     double Alpha_H = 7.0;
     double Alpha_V = 1.0;
     double tbuf = 5.0;
+    std::string altitude_reference = "AGL";  // "AGL" o "AMSL" (AMSL requiere DEM, ver setTerrain)
+    std::vector<double> lod_tolerances = {25.0, 100.0, 500.0};  // niveles de la pirámide LOD (m)
 };
 
 class UplanGeneratorComplete {
@@ -31,7 +53,23 @@ public:
     UplanGeneratorComplete();
     UplanGeneratorComplete(const UplanConfigComplete& config);
 
-    // Genera un Uplan completo a partir de un CSV de trayectoria
+    // DEM para convertir AGL -> AMSL (no se toma posesión; debe vivir más que el generador)
+    void setTerrain(DemTileCache* dem) { terrain = dem; }
+
+    // Validador del esquema Uplan: si se configura, los Uplans inválidos se rechazan al generarlos
+    void setValidator(const UplanSchemaValidator* schema_validator) { validator = schema_validator; }
+
+    // Geozonas: cada volumen de generateCompleteUplan se prueba al crearlo. Con early_abort
+    // un plan que entra en una zona prohibida se rechaza en ese segmento, sin generar el
+    // resto; las zonas condicionales o con autorización sólo se avisan.
+    void setGeozones(const GeozoneIndex* index, bool early_abort = true) {
+        geozones = index;
+        geozone_early_abort = early_abort;
+    }
+
+    // Genera un Uplan completo a partir de un CSV de trayectoria.
+    // Si se pasa pyramid, se rellena con la pirámide LOD de los mismos volúmenes
+    // (config.lod_tolerances) sin volver a generarlos.
     nlohmann::json generateCompleteUplan(
         int uplan_id,
         const std::string& uplan_name,
@@ -40,32 +78,117 @@ public:
         const std::string& category,
         const std::string& uasType,
         double mtom,
-        double vMax
+        double vMax,
+        VolumePyramid* pyramid = nullptr
+    );
+
+    // Igual que el anterior, a partir de waypoints ya cargados (sin reducir)
+    nlohmann::json generateCompleteUplan(
+        int uplan_id,
+        const std::string& uplan_name,
+        const std::vector<WaypointComplete>& waypoints,
+        double start_timestamp,
+        const std::string& category,
+        const std::string& uasType,
+        double mtom,
+        double vMax,
+        VolumePyramid* pyramid = nullptr
     );
 
     // Carga waypoints desde un CSV
     std::vector<WaypointComplete> loadWaypointsFromCSV(const std::string& csv_path);
 
+    // Carga waypoints desde un stream con formato CSV (p.ej. un fichero extraído en memoria)
+    std::vector<WaypointComplete> loadWaypointsFromStream(std::istream& input, const std::string& source);
+
+    // Carga un CSV combinado de varios vuelos (columna FlightId) en una sola pasada.
+    // Las filas de cada vuelo se acumulan en su propio buffer y se entregan a onFlight
+    // en cuanto terminan (cambio de FlightId), de modo que la generación de ese vuelo
+    // puede empezar mientras se sigue leyendo el resto. Con grouped = false las filas
+    // pueden venir intercaladas y todos los vuelos se entregan al final del fichero.
+    // Retorna el número de vuelos entregados, o 0 si hay un error: con grouped = true,
+    // un vuelo cuyas filas reaparecen después de entregarlo detiene la carga (cada vuelo
+    // se entrega una sola vez).
+    size_t loadMultiFlightCSV(
+        const std::string& csv_path,
+        const std::function<void(const std::string& flight_id, std::vector<WaypointComplete>& waypoints)>& onFlight,
+        bool grouped = true
+    );
+
+    // Factor de reducción de los waypoints al generar: un volumen por cada N filas del CSV
+    static constexpr int WAYPOINT_COMPRESSION_FACTOR = 20;
+
     // Reduce waypoints tomando cada N puntos (como en MATLAB: wp(2:compression_factor:end, :))
-    std::vector<WaypointComplete> reduceWaypoints(const std::vector<WaypointComplete>& waypoints, int compression_factor = 20);
+    std::vector<WaypointComplete> reduceWaypoints(const std::vector<WaypointComplete>& waypoints,
+                                                  int compression_factor = WAYPOINT_COMPRESSION_FACTOR);
 
     // Genera los volúmenes a partir de los waypoints
-    std::vector<Volume> generateVolumes(const std::vector<WaypointComplete>& waypoints, double start_timestamp);
+    // Con screening cada volumen se prueba contra sus geozonas al crearlo (ver GeozoneScreening)
+    std::vector<Volume> generateVolumes(const std::vector<WaypointComplete>& waypoints, double start_timestamp,
+                                        GeozoneScreening* screening = nullptr);
+
+    // Genera los volúmenes en formato binario compacto (misma geometría que generateVolumes)
+    std::vector<VolumeRecord> generateVolumeRecords(const std::vector<WaypointComplete>& waypoints, double start_timestamp, int plan_id = 0,
+                                                    GeozoneScreening* screening = nullptr);
+
+    // Convierte un VolumeRecord al objeto Volume del modelo de datos
+    Volume toVolume(const VolumeRecord& record);
+
+    // Pirámide LOD en JSON: un array de volúmenes por nivel (mismo formato que
+    // operationVolumes) con su rango de volúmenes completos y su zoom máximo
+    nlohmann::json pyramidToJson(const VolumePyramid& pyramid);
+
+    // Distancia, azimut y punto medio de cada segmento (independiente de la configuración)
+    std::vector<SegmentGeometry> prepareSegments(const std::vector<WaypointComplete>& waypoints);
+
+    // Barrido de parámetros: parsea y reduce una vez y genera un conjunto de volúmenes
+    // por configuración reutilizando la geometría de los segmentos
+    std::vector<std::vector<Volume>> generateVolumeSweep(
+        const std::string& trajectory_csv_path,
+        const std::vector<UplanConfigComplete>& configs,
+        double start_timestamp
+    );
+    std::vector<std::vector<VolumeRecord>> generateVolumeRecordSweep(
+        const std::vector<WaypointComplete>& waypoints,
+        const std::vector<UplanConfigComplete>& configs,
+        double start_timestamp,
+        int plan_id = 0
+    );
 
 private:
     UplanConfigComplete config;
+    DemTileCache* terrain = nullptr;
+    const UplanSchemaValidator* validator = nullptr;
+    const GeozoneIndex* geozones = nullptr;
+    bool geozone_early_abort = true;
 
     // Funciones auxiliares
     double calculateDistance(double lat1, double lon1, double lat2, double lon2);
     double calculateAzimuth(double lat1, double lon1, double lat2, double lon2);
     std::vector<Point> generateOrientedRectangleCorners(double mid_lat, double mid_lon, double azimuth, double along_track, double cross_track);
+    std::vector<VolumeRecord> buildVolumeRecords(const std::vector<SegmentGeometry>& segments, const UplanConfigComplete& cfg, double start_timestamp, int plan_id,
+                                                 GeozoneScreening* screening = nullptr);
+    Volume buildVolume(const VolumeRecord& record, const std::string& reference);
+
+    // Reduce los waypoints y genera los volúmenes del Uplan; false (con el error ya
+    // registrado) si no hay volúmenes
+    bool planVolumeRecords(const std::string& uplan_name, const std::vector<WaypointComplete>& waypoints,
+                           double start_timestamp, int uplan_id, std::vector<VolumeRecord>& records);
+
+    // Registra los conflictos con geozonas; false si el plan entra en una zona prohibida
+    bool reportGeozoneConflicts(const std::string& uplan_name, const GeozoneScreening& screening);
+
+    // Documento Uplan a partir de los volúmenes del plan
+    nlohmann::json buildUplanDocument(int uplan_id, const std::string& uplan_name, const std::vector<WaypointComplete>& waypoints,
+                            const std::vector<VolumeRecord>& records, const std::string& category,
+                            const std::string& uasType, double mtom, double vMax);
 
     // Genera datos por defecto para campos del Uplan
     nlohmann::json generateDefaultDataIdentifier(const std::string& sac, const std::string& sic);
     nlohmann::json generateDefaultContactDetails();  // Sin parámetros
     nlohmann::json generateDefaultFlightDetails(const std::string& category);
     nlohmann::json generateDefaultUAS(const std::string& uasType, double mtom, double vMax);
-    nlohmann::json generateDefaultLocation(double lat, double lon, double alt);
+    nlohmann::json generateDefaultLocation(double lat, double lon, double alt, const std::string& reference = "AGL");
     nlohmann::json generateTBDLocation(); 
 };
 
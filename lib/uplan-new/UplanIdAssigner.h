@@ -0,0 +1,50 @@
+#ifndef UPLAN_ID_ASSIGNER_H
+#define UPLAN_ID_ASSIGNER_H
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+
+namespace UPlanGeneration {
+
+// Ids de los planes de una ejecución, que dan nombre a sus salidas (Uplan_<id>.json,
+// OI_<id>.json) y a sus entradas en el diario. Cada fuente (ruta del CSV, entrada del
+// archivo o FlightId) conserva el id de su nombre si nadie lo ha reservado antes; los
+// nombres sin id (0) o con un id repetido reciben el siguiente libre. Una misma fuente
+// recibe siempre el mismo id (p. ej. si el watcher la entrega dos veces).
+class UplanIdAssigner {
+public:
+    // Reserva el id del nombre si está libre (primera pasada cuando se conocen todas las
+    // fuentes, para que los ids nuevos no quiten el suyo a un nombre posterior)
+    void claim(const std::string& source, int preferred) {
+        if (preferred > 0 && !by_source.count(source) && used.insert(preferred).second) {
+            by_source[source] = preferred;
+        }
+    }
+
+    int assign(const std::string& source, int preferred) {
+        auto known = by_source.find(source);
+        if (known != by_source.end()) return known->second;
+        int id = preferred;
+        if (id <= 0 || used.count(id)) {
+            while (used.count(next_free)) ++next_free;
+            id = next_free;
+            std::cout << "[WARNING] Plan " << source
+                      << (preferred > 0 ? " repeats id " + std::to_string(preferred) : std::string(" has no id in its name"))
+                      << ", using id " << id << std::endl;
+        }
+        used.insert(id);
+        by_source[source] = id;
+        return id;
+    }
+
+private:
+    std::set<int> used;
+    std::map<std::string, int> by_source;
+    int next_free = 1;
+};
+
+} // namespace UPlanGeneration
+
+#endif // UPLAN_ID_ASSIGNER_H
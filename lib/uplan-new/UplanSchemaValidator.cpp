@@ -0,0 +1,577 @@
+#include "UplanSchemaValidator.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace UPlanGeneration {
+
+namespace {
+
+using json = nlohmann::json;
+
+uint32_t typeBit(const std::string& name) {
+    if (name == "null") return UplanSchemaValidator::T_NULL;
+    if (name == "boolean") return UplanSchemaValidator::T_BOOLEAN;
+    if (name == "integer") return UplanSchemaValidator::T_INTEGER;
+    if (name == "number") return UplanSchemaValidator::T_NUMBER | UplanSchemaValidator::T_INTEGER;
+    if (name == "string") return UplanSchemaValidator::T_STRING;
+    if (name == "array") return UplanSchemaValidator::T_ARRAY;
+    if (name == "object") return UplanSchemaValidator::T_OBJECT;
+    return 0;
+}
+
+uint32_t valueType(const json& value) {
+    switch (value.type()) {
+    case json::value_t::null: return UplanSchemaValidator::T_NULL;
+    case json::value_t::boolean: return UplanSchemaValidator::T_BOOLEAN;
+    case json::value_t::number_integer:
+    case json::value_t::number_unsigned: return UplanSchemaValidator::T_INTEGER;
+    case json::value_t::number_float: {
+        // As in JSON Schema (and UplanFastReader), 3.0 is an integer: only the value counts
+        double v = value.get<double>();
+        return std::floor(v) == v ? UplanSchemaValidator::T_INTEGER : UplanSchemaValidator::T_NUMBER;
+    }
+    case json::value_t::string: return UplanSchemaValidator::T_STRING;
+    case json::value_t::array: return UplanSchemaValidator::T_ARRAY;
+    case json::value_t::object: return UplanSchemaValidator::T_OBJECT;
+    default: return 0;
+    }
+}
+
+bool digits(const std::string& s, size_t pos, size_t count) {
+    if (pos + count > s.size()) return false;
+    for (size_t i = pos; i < pos + count; ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(s[i]))) return false;
+    }
+    return true;
+}
+
+// YYYY-MM-DDTHH:MM:SS[.fff][Z|+hh:mm] (the zone is optional, as in the generated Uplans)
+bool isDateTime(const std::string& s) {
+    if (!(digits(s, 0, 4) && s.size() >= 19 && s[4] == '-' && digits(s, 5, 2) && s[7] == '-' &&
+          digits(s, 8, 2) && (s[10] == 'T' || s[10] == 't') && digits(s, 11, 2) && s[13] == ':' &&
+          digits(s, 14, 2) && s[16] == ':' && digits(s, 17, 2))) {
+        return false;
+    }
+    size_t pos = 19;
+    if (pos < s.size() && s[pos] == '.') {
+        ++pos;
+        size_t start = pos;
+        while (pos < s.size() && std::isdigit(static_cast<unsigned char>(s[pos]))) ++pos;
+        if (pos == start) return false;
+    }
+    if (pos == s.size()) return true;
+    if ((s[pos] == 'Z' || s[pos] == 'z') && pos + 1 == s.size()) return true;
+    return (s[pos] == '+' || s[pos] == '-') && pos + 6 == s.size() &&
+           digits(s, pos + 1, 2) && s[pos + 3] == ':' && digits(s, pos + 4, 2);
+}
+
+bool isEmail(const std::string& s) {
+    size_t at = s.find('@');
+    if (at == std::string::npos || at == 0 || s.find('@', at + 1) != std::string::npos) return false;
+    size_t dot = s.find('.', at + 2);
+    return dot != std::string::npos && dot + 1 < s.size();
+}
+
+std::string describePath(const std::string& path) {
+    return path.empty() ? "/" : path;
+}
+
+void addError(std::vector<std::string>* errors, const std::string& path, const std::string& message) {
+    if (errors) errors->push_back(describePath(path) + ": " + message);
+}
+
+} // namespace
+
+int UplanSchemaValidator::Node::property(const std::string& key) const {
+    auto it = std::lower_bound(properties.begin(), properties.end(), key,
+        [](const std::pair<std::string, int>& p, const std::string& k) { return p.first < k; });
+    return (it != properties.end() && it->first == key) ? it->second : -1;
+}
+
+bool UplanSchemaValidator::loadSchema(const std::string& schema_path) {
+    std::ifstream file(schema_path);
+    if (!file.is_open()) {
+        std::cerr << "[ERROR] Cannot open Uplan schema: " << schema_path << std::endl;
+        return false;
+    }
+    try {
+        json schema = json::parse(file);
+        if (!compile(schema)) return false;
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Failed to parse Uplan schema " << schema_path << ": " << e.what() << std::endl;
+        return false;
+    }
+    std::cout << "[INFO] Compiled Uplan schema: " << schema_path << " (" << nodes.size() << " nodes)" << std::endl;
+    return true;
+}
+
+bool UplanSchemaValidator::compile(const nlohmann::json& schema) {
+    nodes.clear();
+    ref_cache.clear();
+    root = -1;
+    schema_doc = schema;
+    try {
+        root = compileNode(schema_doc);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Failed to compile Uplan schema: " << e.what() << std::endl;
+        nodes.clear();
+        root = -1;
+        return false;
+    }
+    // The $defs are only needed while compiling
+    schema_doc = nullptr;
+    return true;
+}
+
+int UplanSchemaValidator::resolveRef(const std::string& ref) {
+    auto it = ref_cache.find(ref);
+    if (it != ref_cache.end()) return it->second;
+    if (ref.empty() || ref[0] != '#') {
+        throw std::runtime_error("unsupported $ref: " + ref);
+    }
+    int idx = compileNode(schema_doc.at(json::json_pointer(ref.substr(1))));
+    ref_cache[ref] = idx;
+    return idx;
+}
+
+bool UplanSchemaValidator::mergeInto(Node& target, const Node& source) const {
+    bool target_object = !target.properties.empty() || !target.additional_properties || !target.required.empty();
+    bool source_object = !source.properties.empty() || !source.additional_properties || !source.required.empty();
+    if ((target_object && source_object) ||
+        (target.items >= 0 && source.items >= 0) ||
+        (target.has_enum && source.has_enum) ||
+        (!target.one_of.empty() && !source.one_of.empty()) ||
+        (target.format != Format::None && source.format != Format::None) ||
+        (target.min_length >= 0 && source.min_length >= 0) ||
+        (target.max_length >= 0 && source.max_length >= 0) ||
+        (target.min_items >= 0 && source.min_items >= 0) ||
+        (target.max_items >= 0 && source.max_items >= 0) ||
+        (target.has_minimum && source.has_minimum)) {
+        return false;
+    }
+
+    target.types &= source.types;
+    if (source_object) {
+        target.properties = source.properties;
+        target.required = source.required;
+        target.additional_properties = source.additional_properties;
+    }
+    if (source.items >= 0) target.items = source.items;
+    if (source.has_enum) {
+        target.has_enum = true;
+        target.enum_values = source.enum_values;
+    }
+    if (source.min_length >= 0) target.min_length = source.min_length;
+    if (source.max_length >= 0) target.max_length = source.max_length;
+    if (source.min_items >= 0) target.min_items = source.min_items;
+    if (source.max_items >= 0) target.max_items = source.max_items;
+    if (source.has_minimum) {
+        target.has_minimum = true;
+        target.minimum = source.minimum;
+    }
+    if (source.format != Format::None) target.format = source.format;
+    if (!source.one_of.empty()) target.one_of = source.one_of;
+    target.all_of.insert(target.all_of.end(), source.all_of.begin(), source.all_of.end());
+    return true;
+}
+
+int UplanSchemaValidator::compileNode(const nlohmann::json& schema) {
+    Node node;
+
+    if (!schema.is_object()) {
+        // true / {} : anything goes
+        nodes.push_back(node);
+        return static_cast<int>(nodes.size() - 1);
+    }
+
+    if (schema.contains("$ref")) {
+        int target = resolveRef(schema["$ref"].get<std::string>());
+        bool only_ref = true;
+        for (auto it = schema.begin(); it != schema.end(); ++it) {
+            if (it.key() != "$ref" && it.key() != "description" && it.key() != "title") only_ref = false;
+        }
+        if (only_ref) return target;
+        node.all_of.push_back(target);
+    }
+
+    if (schema.contains("type")) {
+        const json& type = schema["type"];
+        node.types = 0;
+        if (type.is_array()) {
+            for (const auto& t : type) node.types |= typeBit(t.get<std::string>());
+        } else {
+            node.types = typeBit(type.get<std::string>());
+        }
+    }
+
+    if (schema.contains("properties")) {
+        for (auto it = schema["properties"].begin(); it != schema["properties"].end(); ++it) {
+            int child = compileNode(it.value());
+            node.properties.emplace_back(it.key(), child);
+        }
+        std::sort(node.properties.begin(), node.properties.end());
+    }
+    if (schema.contains("required")) {
+        node.required = schema["required"].get<std::vector<std::string>>();
+    }
+    if (schema.contains("additionalProperties") && schema["additionalProperties"].is_boolean()) {
+        node.additional_properties = schema["additionalProperties"].get<bool>();
+    }
+    if (schema.contains("items")) {
+        node.items = compileNode(schema["items"]);
+    }
+    if (schema.contains("enum")) {
+        node.has_enum = true;
+        for (const auto& v : schema["enum"]) node.enum_values.push_back(v);
+    }
+    if (schema.contains("const")) {
+        node.has_enum = true;
+        node.enum_values = {schema["const"]};
+    }
+    if (schema.contains("minLength")) node.min_length = schema["minLength"].get<int64_t>();
+    if (schema.contains("maxLength")) node.max_length = schema["maxLength"].get<int64_t>();
+    if (schema.contains("minItems")) node.min_items = schema["minItems"].get<int64_t>();
+    if (schema.contains("maxItems")) node.max_items = schema["maxItems"].get<int64_t>();
+    if (schema.contains("minimum")) {
+        node.has_minimum = true;
+        node.minimum = schema["minimum"].get<double>();
+    }
+    if (schema.contains("format")) {
+        std::string format = schema["format"].get<std::string>();
+        if (format == "date-time") node.format = Format::DateTime;
+        else if (format == "email") node.format = Format::Email;
+    }
+    if (schema.contains("oneOf")) {
+        for (const auto& alt : schema["oneOf"]) node.one_of.push_back(compileNode(alt));
+    }
+    if (schema.contains("allOf")) {
+        for (const auto& part : schema["allOf"]) node.all_of.push_back(compileNode(part));
+    }
+
+    // Fold allOf members into this node when their constraints do not overlap,
+    // so the common {"allOf": [{"$ref": ...}]} costs nothing at validation time
+    std::vector<int> parts;
+    parts.swap(node.all_of);
+    for (int idx : parts) {
+        Node copy = nodes[idx];
+        if (!mergeInto(node, copy)) node.all_of.push_back(idx);
+    }
+
+    nodes.push_back(node);
+    return static_cast<int>(nodes.size() - 1);
+}
+
+bool UplanSchemaValidator::checkScalar(const Node& node, const nlohmann::json& value, const std::string& path,
+                                       std::vector<std::string>* errors) const {
+    bool ok = true;
+
+    if (node.has_enum &&
+        std::find(node.enum_values.begin(), node.enum_values.end(), value) == node.enum_values.end()) {
+        addError(errors, path, "value " + value.dump() + " is not allowed");
+        ok = false;
+    }
+
+    if (value.is_string()) {
+        const std::string& s = value.get_ref<const std::string&>();
+        if (node.min_length >= 0 && static_cast<int64_t>(s.size()) < node.min_length) {
+            addError(errors, path, "string shorter than " + std::to_string(node.min_length));
+            ok = false;
+        }
+        if (node.max_length >= 0 && static_cast<int64_t>(s.size()) > node.max_length) {
+            addError(errors, path, "string longer than " + std::to_string(node.max_length));
+            ok = false;
+        }
+        if (node.format == Format::DateTime && !isDateTime(s)) {
+            addError(errors, path, "invalid date-time \"" + s + "\"");
+            ok = false;
+        }
+        if (node.format == Format::Email && !isEmail(s)) {
+            addError(errors, path, "invalid email \"" + s + "\"");
+            ok = false;
+        }
+    } else if (value.is_number() && node.has_minimum && value.get<double>() < node.minimum) {
+        addError(errors, path, "value below minimum " + json(node.minimum).dump());
+        ok = false;
+    }
+
+    return ok;
+}
+
+bool UplanSchemaValidator::validateNode(int index, const nlohmann::json& value, const std::string& path,
+                                        std::vector<std::string>* errors) const {
+    if (index < 0) return true;
+    const Node& node = nodes[index];
+
+    if (!(valueType(value) & node.types)) {
+        addError(errors, path, "unexpected type " + std::string(value.type_name()));
+        return false;
+    }
+
+    bool ok = checkScalar(node, value, path, errors);
+
+    if (value.is_object()) {
+        for (const auto& name : node.required) {
+            if (!value.contains(name)) {
+                addError(errors, path, "missing required property \"" + name + "\"");
+                ok = false;
+            }
+        }
+        for (auto it = value.begin(); it != value.end(); ++it) {
+            int child = node.property(it.key());
+            if (child < 0 && !node.additional_properties) {
+                addError(errors, path, "unexpected property \"" + it.key() + "\"");
+                ok = false;
+                continue;
+            }
+            ok = validateNode(child, it.value(), path + "/" + it.key(), errors) && ok;
+        }
+    } else if (value.is_array()) {
+        int64_t count = static_cast<int64_t>(value.size());
+        if (node.min_items >= 0 && count < node.min_items) {
+            addError(errors, path, "fewer than " + std::to_string(node.min_items) + " items");
+            ok = false;
+        }
+        if (node.max_items >= 0 && count > node.max_items) {
+            addError(errors, path, "more than " + std::to_string(node.max_items) + " items");
+            ok = false;
+        }
+        if (node.items >= 0) {
+            for (size_t i = 0; i < value.size(); ++i) {
+                ok = validateNode(node.items, value[i], path + "/" + std::to_string(i), errors) && ok;
+            }
+        }
+    }
+
+    if (!node.one_of.empty()) {
+        int matches = 0;
+        for (int alt : node.one_of) {
+            if (validateNode(alt, value, path, nullptr)) ++matches;
+        }
+        if (matches != 1) {
+            addError(errors, path, "must match exactly one oneOf alternative (matched " + std::to_string(matches) + ")");
+            ok = false;
+        }
+    }
+    for (int part : node.all_of) {
+        ok = validateNode(part, value, path, errors) && ok;
+    }
+
+    return ok;
+}
+
+bool UplanSchemaValidator::validate(const nlohmann::json& uplan, std::vector<std::string>* errors) const {
+    if (root < 0) {
+        addError(errors, "", "schema not loaded");
+        return false;
+    }
+    return validateNode(root, uplan, "", errors);
+}
+
+// ---------------------------------------------------------------------------
+// SAX validation: walks the token stream keeping one frame per open container
+
+class UplanSchemaSax : public nlohmann::json_sax<nlohmann::json> {
+public:
+    UplanSchemaSax(const UplanSchemaValidator& validator, std::vector<std::string>* errors)
+        : v(validator), errors(errors) {}
+
+    bool ok = true;
+
+    bool null() override { return scalar(json(nullptr)); }
+    bool boolean(bool val) override { return scalar(json(val)); }
+    bool number_integer(number_integer_t val) override { return scalar(json(val)); }
+    bool number_unsigned(number_unsigned_t val) override { return scalar(json(val)); }
+    bool number_float(number_float_t val, const string_t&) override { return scalar(json(val)); }
+    bool string(string_t& val) override { return scalar(json(std::move(val))); }
+    bool binary(binary_t&) override { return true; }
+
+    bool start_object(std::size_t) override { return startContainer(true); }
+    bool start_array(std::size_t) override { return startContainer(false); }
+    bool end_object() override { return endContainer(); }
+    bool end_array() override { return endContainer(); }
+
+    bool key(string_t& val) override {
+        if (!buffer_stack.empty()) {
+            buffer_keys.back() = val;
+            return true;
+        }
+        Frame& frame = frames.back();
+        frame.key = val;
+        if (frame.node >= 0) {
+            const auto& required = v.nodes[frame.node].required;
+            for (size_t i = 0; i < required.size(); ++i) {
+                if (required[i] == val) frame.seen[i] = true;
+            }
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        addError(errors, "", "parse error at byte " + std::to_string(position) + ": " + ex.what());
+        ok = false;
+        return false;
+    }
+
+private:
+    struct Frame {
+        int node;
+        bool object;
+        std::string path;
+        std::string key;
+        size_t count = 0;
+        std::vector<bool> seen;   // required properties already found
+    };
+
+    const UplanSchemaValidator& v;
+    std::vector<std::string>* errors;
+    std::vector<Frame> frames;
+
+    // Local DOM for oneOf/allOf subtrees
+    json buffer;
+    std::vector<json*> buffer_stack;
+    std::vector<std::string> buffer_keys;
+    int buffer_node = -1;
+    std::string buffer_path;
+
+    std::string childPath() const {
+        if (frames.empty()) return "";
+        const Frame& frame = frames.back();
+        return frame.path + "/" + (frame.object ? frame.key : std::to_string(frame.count));
+    }
+
+    // Schema node for the value that starts now
+    int expectedNode() {
+        if (frames.empty()) return v.root;
+        const Frame& frame = frames.back();
+        if (frame.node < 0) return -1;
+        const UplanSchemaValidator::Node& parent = v.nodes[frame.node];
+        if (!frame.object) return parent.items;
+        int child = parent.property(frame.key);
+        if (child < 0 && !parent.additional_properties) {
+            addError(errors, frame.path, "unexpected property \"" + frame.key + "\"");
+            ok = false;
+        }
+        return child;
+    }
+
+    void valueDone() {
+        if (!frames.empty()) frames.back().count++;
+    }
+
+    void appendToBuffer(json value) {
+        json* top = buffer_stack.back();
+        if (top->is_object()) (*top)[buffer_keys.back()] = std::move(value);
+        else top->push_back(std::move(value));
+    }
+
+    bool scalar(json value) {
+        if (!buffer_stack.empty()) {
+            appendToBuffer(std::move(value));
+            return true;
+        }
+        std::string path = childPath();
+        int node = expectedNode();
+        if (node >= 0) {
+            ok = v.validateNode(node, value, path, errors) && ok;
+        }
+        valueDone();
+        return true;
+    }
+
+    bool startContainer(bool object) {
+        if (!buffer_stack.empty()) {
+            json child = object ? json::object() : json::array();
+            json* top = buffer_stack.back();
+            json* slot;
+            if (top->is_object()) {
+                slot = &((*top)[buffer_keys.back()] = std::move(child));
+            } else {
+                top->push_back(std::move(child));
+                slot = &top->back();
+            }
+            buffer_stack.push_back(slot);
+            buffer_keys.emplace_back();
+            return true;
+        }
+
+        std::string path = childPath();
+        int node = expectedNode();
+
+        if (node >= 0 && v.nodes[node].needsBuffering()) {
+            buffer = object ? json::object() : json::array();
+            buffer_stack.push_back(&buffer);
+            buffer_keys.emplace_back();
+            buffer_node = node;
+            buffer_path = path;
+            return true;
+        }
+
+        if (node >= 0 && !(v.nodes[node].types & (object ? UplanSchemaValidator::T_OBJECT : UplanSchemaValidator::T_ARRAY))) {
+            addError(errors, path, std::string("unexpected type ") + (object ? "object" : "array"));
+            ok = false;
+            node = -1;   // do not validate inside a mistyped container
+        }
+
+        Frame frame;
+        frame.node = node;
+        frame.object = object;
+        frame.path = path;
+        if (node >= 0) frame.seen.assign(v.nodes[node].required.size(), false);
+        frames.push_back(std::move(frame));
+        return true;
+    }
+
+    bool endContainer() {
+        if (!buffer_stack.empty()) {
+            buffer_stack.pop_back();
+            buffer_keys.pop_back();
+            if (buffer_stack.empty()) {
+                ok = v.validateNode(buffer_node, buffer, buffer_path, errors) && ok;
+                buffer = nullptr;
+                valueDone();
+            }
+            return true;
+        }
+
+        Frame frame = std::move(frames.back());
+        frames.pop_back();
+        if (frame.node >= 0) {
+            const UplanSchemaValidator::Node& node = v.nodes[frame.node];
+            if (frame.object) {
+                for (size_t i = 0; i < frame.seen.size(); ++i) {
+                    if (!frame.seen[i]) {
+                        addError(errors, frame.path, "missing required property \"" + node.required[i] + "\"");
+                        ok = false;
+                    }
+                }
+            } else {
+                int64_t count = static_cast<int64_t>(frame.count);
+                if (node.min_items >= 0 && count < node.min_items) {
+                    addError(errors, frame.path, "fewer than " + std::to_string(node.min_items) + " items");
+                    ok = false;
+                }
+                if (node.max_items >= 0 && count > node.max_items) {
+                    addError(errors, frame.path, "more than " + std::to_string(node.max_items) + " items");
+                    ok = false;
+                }
+            }
+        }
+        valueDone();
+        return true;
+    }
+};
+
+bool UplanSchemaValidator::validateText(const std::string& text, std::vector<std::string>* errors) const {
+    if (root < 0) {
+        addError(errors, "", "schema not loaded");
+        return false;
+    }
+    UplanSchemaSax sax(*this, errors);
+    bool parsed = json::sax_parse(text, &sax);
+    return parsed && sax.ok;
+}
+
+} // namespace UPlanGeneration
@@ -0,0 +1,89 @@
+#ifndef UPLAN_SCHEMA_VALIDATOR_H
+#define UPLAN_SCHEMA_VALIDATOR_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace UPlanGeneration {
+
+// Validador nativo de Uplans a partir de uplan_schema_UPV.json.
+//
+// El esquema se compila una sola vez a una tabla de nodos ($ref resueltos a índices,
+// allOf fusionados cuando es posible, propiedades ordenadas para búsqueda binaria).
+// Se puede validar:
+//  - el JSON que construye el generador, antes de serializarlo (sin reparsear)
+//  - un texto JSON en una pasada SAX sobre los bytes, sin construir el DOM
+//    (sólo los pequeños subárboles con oneOf/allOf se bufferizan localmente)
+//
+// Palabras clave soportadas: type, $ref, properties, required, additionalProperties
+// (booleano), items, enum, const, minLength, maxLength, minItems, maxItems, minimum,
+// format (date-time, email), oneOf, allOf.
+class UplanSchemaValidator {
+public:
+    UplanSchemaValidator() = default;
+
+    // Compila el esquema; retorna false si no se puede leer o compilar
+    bool loadSchema(const std::string& schema_path);
+    bool compile(const nlohmann::json& schema);
+    bool isLoaded() const { return root >= 0; }
+
+    // Valida un Uplan ya construido
+    bool validate(const nlohmann::json& uplan, std::vector<std::string>* errors = nullptr) const;
+
+    // Valida un Uplan serializado en una pasada SAX (sin DOM)
+    bool validateText(const std::string& text, std::vector<std::string>* errors = nullptr) const;
+
+    enum TypeBits : uint32_t {
+        T_NULL = 1, T_BOOLEAN = 2, T_INTEGER = 4, T_NUMBER = 8,
+        T_STRING = 16, T_ARRAY = 32, T_OBJECT = 64,
+        T_ANY = 127
+    };
+
+    enum class Format { None, DateTime, Email };
+
+    struct Node {
+        uint32_t types = T_ANY;
+        std::vector<std::pair<std::string, int>> properties;  // ordenadas por clave
+        std::vector<std::string> required;
+        bool additional_properties = true;
+        int items = -1;
+        std::vector<nlohmann::json> enum_values;
+        bool has_enum = false;
+        int64_t min_length = -1;
+        int64_t max_length = -1;
+        int64_t min_items = -1;
+        int64_t max_items = -1;
+        bool has_minimum = false;
+        double minimum = 0.0;
+        Format format = Format::None;
+        std::vector<int> one_of;
+        std::vector<int> all_of;
+
+        int property(const std::string& key) const;
+        bool needsBuffering() const { return !one_of.empty() || !all_of.empty(); }
+    };
+
+private:
+    friend class UplanSchemaSax;
+
+    std::vector<Node> nodes;
+    int root = -1;
+    nlohmann::json schema_doc;
+    std::map<std::string, int> ref_cache;
+
+    int compileNode(const nlohmann::json& schema);
+    int resolveRef(const std::string& ref);
+    bool mergeInto(Node& target, const Node& source) const;
+
+    bool validateNode(int node, const nlohmann::json& value, const std::string& path,
+                      std::vector<std::string>* errors) const;
+    bool checkScalar(const Node& node, const nlohmann::json& value, const std::string& path,
+                     std::vector<std::string>* errors) const;
+};
+
+} // namespace UPlanGeneration
+
+#endif // UPLAN_SCHEMA_VALIDATOR_H
@@ -0,0 +1,270 @@
+#include "VolumePyramid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace UPlanGeneration {
+
+namespace {
+
+const double EARTH_RADIUS = 6371008.8;                   // mean radius (m)
+const double DEG_TO_RAD = M_PI / 180.0;
+const double MERCATOR_RESOLUTION_Z0 = 156543.03392804097; // m/px at zoom 0 on the equator
+const int MAX_ZOOM = 24;
+
+// Equirectangular projection around a reference point; accurate enough for
+// the few-kilometre extent of a corridor
+struct LocalFrame {
+    double lat0, lon0, kx, ky;
+
+    LocalFrame(double lat, double lon)
+        : lat0(lat), lon0(lon),
+          kx(EARTH_RADIUS * std::cos(lat * DEG_TO_RAD) * DEG_TO_RAD),
+          ky(EARTH_RADIUS * DEG_TO_RAD) {}
+
+    void toXY(double lat, double lon, double& x, double& y) const {
+        x = (lon - lon0) * kx;
+        y = (lat - lat0) * ky;
+    }
+
+    void toLatLon(double x, double y, double& lat, double& lon) const {
+        lon = lon0 + x / kx;
+        lat = lat0 + y / ky;
+    }
+};
+
+double centerLat(const VolumeRecord& r) { return (r.min_lat + r.max_lat) / 2.0; }
+double centerLon(const VolumeRecord& r) { return (r.min_lon + r.max_lon) / 2.0; }
+
+// Half of the cross-track width of a generated rectangle (corners 0-1 are the front edge)
+double halfWidth(const VolumeRecord& r, const LocalFrame& frame) {
+    double x0, y0, x1, y1;
+    frame.toXY(r.corner_lat[0], r.corner_lon[0], x0, y0);
+    frame.toXY(r.corner_lat[1], r.corner_lon[1], x1, y1);
+    return std::hypot(x1 - x0, y1 - y0) / 2.0;
+}
+
+// Oriented rectangle covering a run of volumes, in a frame whose along-track axis
+// is (ux, uy) and whose cross-track axis points left of it
+struct Corridor {
+    double ux, uy;
+    double along_min, along_max;
+    double cross_min, cross_max;
+    double min_alt, max_alt;
+    int64_t time_begin, time_end;
+    double max_half_width;   // widest single volume of the run
+    double max_alt_span;     // tallest single volume of the run
+};
+
+Corridor fitCorridor(const std::vector<VolumeRecord>& records, size_t first, size_t last, const LocalFrame& frame) {
+    Corridor c;
+    const VolumeRecord& a = records[first];
+    const VolumeRecord& b = records[last];
+
+    double ax, ay, bx, by;
+    frame.toXY(centerLat(a), centerLon(a), ax, ay);
+    frame.toXY(centerLat(b), centerLon(b), bx, by);
+    double length = std::hypot(bx - ax, by - ay);
+    if (length < 1.0) {
+        // Single volume or a run that comes back onto itself: use the first volume's own axis
+        double fx, fy, rx, ry, x, y;
+        frame.toXY(a.corner_lat[0], a.corner_lon[0], fx, fy);
+        frame.toXY(a.corner_lat[1], a.corner_lon[1], x, y);
+        fx = (fx + x) / 2.0;
+        fy = (fy + y) / 2.0;
+        frame.toXY(a.corner_lat[2], a.corner_lon[2], rx, ry);
+        frame.toXY(a.corner_lat[3], a.corner_lon[3], x, y);
+        rx = (rx + x) / 2.0;
+        ry = (ry + y) / 2.0;
+        bx = fx;
+        by = fy;
+        ax = rx;
+        ay = ry;
+        length = std::hypot(bx - ax, by - ay);
+    }
+    c.ux = length > 0.0 ? (bx - ax) / length : 0.0;
+    c.uy = length > 0.0 ? (by - ay) / length : 1.0;
+
+    c.along_min = c.cross_min = std::numeric_limits<double>::max();
+    c.along_max = c.cross_max = std::numeric_limits<double>::lowest();
+    c.min_alt = std::numeric_limits<double>::max();
+    c.max_alt = std::numeric_limits<double>::lowest();
+    c.time_begin = std::numeric_limits<int64_t>::max();
+    c.time_end = std::numeric_limits<int64_t>::lowest();
+    c.max_half_width = 0.0;
+    c.max_alt_span = 0.0;
+
+    for (size_t i = first; i <= last; ++i) {
+        const VolumeRecord& r = records[i];
+        for (int j = 0; j < 4; ++j) {
+            double x, y;
+            frame.toXY(r.corner_lat[j], r.corner_lon[j], x, y);
+            double along = x * c.ux + y * c.uy;
+            double cross = -x * c.uy + y * c.ux;
+            c.along_min = std::min(c.along_min, along);
+            c.along_max = std::max(c.along_max, along);
+            c.cross_min = std::min(c.cross_min, cross);
+            c.cross_max = std::max(c.cross_max, cross);
+        }
+        c.min_alt = std::min(c.min_alt, r.min_alt);
+        c.max_alt = std::max(c.max_alt, r.max_alt);
+        c.time_begin = std::min(c.time_begin, r.time_begin);
+        c.time_end = std::max(c.time_end, r.time_end);
+        c.max_half_width = std::max(c.max_half_width, halfWidth(r, frame));
+        c.max_alt_span = std::max(c.max_alt_span, r.max_alt - r.min_alt);
+    }
+    return c;
+}
+
+bool withinTolerance(const Corridor& c, double tolerance) {
+    return (c.cross_max - c.cross_min) / 2.0 <= c.max_half_width + tolerance &&
+           (c.max_alt - c.min_alt) <= c.max_alt_span + 2.0 * tolerance;
+}
+
+VolumeRecord toRecord(const Corridor& c, const LocalFrame& frame, int32_t plan_id, int32_t ordinal) {
+    VolumeRecord rec;
+    rec.plan_id = plan_id;
+    rec.ordinal = ordinal;
+
+    // Same corner order as generateOrientedRectangleCorners:
+    // front-left, front-right, back-right, back-left
+    const double along[4] = {c.along_max, c.along_max, c.along_min, c.along_min};
+    const double cross[4] = {c.cross_max, c.cross_min, c.cross_min, c.cross_max};
+
+    rec.min_lon = rec.min_lat = std::numeric_limits<double>::max();
+    rec.max_lon = rec.max_lat = std::numeric_limits<double>::lowest();
+    for (int j = 0; j < 4; ++j) {
+        double x = along[j] * c.ux - cross[j] * c.uy;
+        double y = along[j] * c.uy + cross[j] * c.ux;
+        frame.toLatLon(x, y, rec.corner_lat[j], rec.corner_lon[j]);
+        rec.min_lon = std::min(rec.min_lon, rec.corner_lon[j]);
+        rec.max_lon = std::max(rec.max_lon, rec.corner_lon[j]);
+        rec.min_lat = std::min(rec.min_lat, rec.corner_lat[j]);
+        rec.max_lat = std::max(rec.max_lat, rec.corner_lat[j]);
+    }
+
+    rec.min_alt = c.min_alt;
+    rec.max_alt = c.max_alt;
+    rec.time_begin = c.time_begin;
+    rec.time_end = c.time_end;
+    return rec;
+}
+
+// Deepest zoom at which a deviation of 'metres' still renders within ~2 px
+int maxZoomFor(double metres, double lat) {
+    if (metres <= 0.0) return MAX_ZOOM;
+    double zoom = std::floor(std::log2(MERCATOR_RESOLUTION_Z0 * std::cos(lat * DEG_TO_RAD) * 2.0 / metres));
+    return static_cast<int>(std::max(0.0, std::min(static_cast<double>(MAX_ZOOM), zoom)));
+}
+
+} // namespace
+
+VolumePyramid buildVolumePyramid(const std::vector<VolumeRecord>& records, const std::vector<double>& tolerances) {
+    VolumePyramid pyramid;
+    pyramid.envelope = VolumeRecord{};
+    if (records.empty()) return pyramid;
+
+    // Level 0: the full volumes, each covering itself
+    VolumeLevel full;
+    full.tolerance = 0.0;
+    full.max_zoom = MAX_ZOOM;
+    full.records = records;
+    full.first.resize(records.size());
+    full.count.assign(records.size(), 1);
+    for (size_t i = 0; i < records.size(); ++i) {
+        full.first[i] = static_cast<int32_t>(i);
+        full.records[i].ordinal = static_cast<int32_t>(i);
+    }
+    pyramid.levels.push_back(std::move(full));
+
+    // Envelope over the whole plan
+    VolumeRecord& env = pyramid.envelope;
+    env.plan_id = records.front().plan_id;
+    env.ordinal = 0;
+    env.min_lon = env.min_lat = env.min_alt = std::numeric_limits<double>::max();
+    env.max_lon = env.max_lat = env.max_alt = std::numeric_limits<double>::lowest();
+    env.time_begin = std::numeric_limits<int64_t>::max();
+    env.time_end = std::numeric_limits<int64_t>::lowest();
+    for (const auto& r : records) {
+        env.min_lon = std::min(env.min_lon, r.min_lon);
+        env.max_lon = std::max(env.max_lon, r.max_lon);
+        env.min_lat = std::min(env.min_lat, r.min_lat);
+        env.max_lat = std::max(env.max_lat, r.max_lat);
+        env.min_alt = std::min(env.min_alt, r.min_alt);
+        env.max_alt = std::max(env.max_alt, r.max_alt);
+        env.time_begin = std::min(env.time_begin, r.time_begin);
+        env.time_end = std::max(env.time_end, r.time_end);
+    }
+    // North-up rectangle in the usual corner order
+    const double env_lon[4] = {env.min_lon, env.max_lon, env.max_lon, env.min_lon};
+    const double env_lat[4] = {env.max_lat, env.max_lat, env.min_lat, env.min_lat};
+    std::copy(env_lon, env_lon + 4, env.corner_lon);
+    std::copy(env_lat, env_lat + 4, env.corner_lat);
+
+    const double lat = (env.min_lat + env.max_lat) / 2.0;
+    const LocalFrame frame(lat, (env.min_lon + env.max_lon) / 2.0);
+    double x0, y0, x1, y1;
+    frame.toXY(env.min_lat, env.min_lon, x0, y0);
+    frame.toXY(env.max_lat, env.max_lon, x1, y1);
+    pyramid.envelope_max_zoom = maxZoomFor(std::hypot(x1 - x0, y1 - y0), lat);
+
+    std::vector<double> levels(tolerances);
+    levels.erase(std::remove_if(levels.begin(), levels.end(), [](double t) { return !(t > 0.0); }), levels.end());
+    std::sort(levels.begin(), levels.end());
+    levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+
+    // Coarse levels are always merged from the full volumes so each tolerance is
+    // measured against the real geometry, not against an already simplified level
+    for (double tolerance : levels) {
+        VolumeLevel level;
+        level.tolerance = tolerance;
+        level.max_zoom = maxZoomFor(tolerance, lat);
+
+        size_t first = 0;
+        while (first < records.size()) {
+            // The corridor axis follows the run's end points, so it has to be re-fitted
+            // for each candidate length. Gallop (1, 2, 4, ... volumes) until a run no
+            // longer fits and binary-search the bracket: O(k log k) fits' worth of work
+            // for a run of k volumes instead of extending one volume at a time (O(k^2)).
+            Corridor best = fitCorridor(records, first, first, frame);
+            size_t last = first;                // longest run known to fit
+            size_t too_long = records.size();   // shortest run known not to fit
+            for (size_t step = 1; last + step < records.size(); step *= 2) {
+                Corridor candidate = fitCorridor(records, first, last + step, frame);
+                if (!withinTolerance(candidate, tolerance)) {
+                    too_long = last + step;
+                    break;
+                }
+                best = candidate;
+                last += step;
+            }
+            while (too_long - last > 1) {
+                size_t middle = last + (too_long - last) / 2;
+                Corridor candidate = fitCorridor(records, first, middle, frame);
+                if (withinTolerance(candidate, tolerance)) {
+                    best = candidate;
+                    last = middle;
+                } else {
+                    too_long = middle;
+                }
+            }
+            level.records.push_back(toRecord(best, frame, env.plan_id, static_cast<int32_t>(level.records.size())));
+            level.first.push_back(static_cast<int32_t>(first));
+            level.count.push_back(static_cast<int32_t>(last - first + 1));
+            first = last + 1;
+        }
+        pyramid.levels.push_back(std::move(level));
+    }
+
+    return pyramid;
+}
+
+int pyramidLevelForZoom(const VolumePyramid& pyramid, int zoom) {
+    if (pyramid.levels.empty() || zoom <= pyramid.envelope_max_zoom) return -1;
+    for (size_t i = pyramid.levels.size(); i-- > 0;) {
+        if (pyramid.levels[i].max_zoom >= zoom) return static_cast<int>(i);
+    }
+    return 0;
+}
+
+} // namespace UPlanGeneration
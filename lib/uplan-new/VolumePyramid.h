@@ -0,0 +1,38 @@
+#ifndef VOLUME_PYRAMID_H
+#define VOLUME_PYRAMID_H
+
+#include <vector>
+#include "VolumeRecord.h"
+
+namespace UPlanGeneration {
+
+// Nivel de detalle de los volúmenes de un plan.
+// En los niveles agregados cada volumen es un corredor que cubre (en planta, altitud
+// y tiempo) los volúmenes completos [first, first + count) del nivel 0.
+struct VolumeLevel {
+    double tolerance;                    // desviación lateral/vertical admitida (m); 0 = volúmenes completos
+    int max_zoom;                        // zoom web-mercator máximo en el que el nivel es adecuado
+    std::vector<VolumeRecord> records;   // ordinal = índice dentro del nivel
+    std::vector<int32_t> first;          // primer volumen del nivel 0 cubierto
+    std::vector<int32_t> count;          // número de volúmenes del nivel 0 cubiertos
+};
+
+// Pirámide multirresolución: nivel 0 completo, corredores cada vez más gruesos
+// (tolerancias crecientes) y una envolvente única del plan
+struct VolumePyramid {
+    std::vector<VolumeLevel> levels;
+    VolumeRecord envelope;
+    int envelope_max_zoom = 0;
+};
+
+// Construye la pirámide a partir de los volúmenes completos de un plan (en orden de
+// trayectoria). Los corredores agrupan volúmenes consecutivos mientras el rectángulo
+// orientado que los contiene no se separa más de la tolerancia del más ancho de ellos.
+VolumePyramid buildVolumePyramid(const std::vector<VolumeRecord>& records, const std::vector<double>& tolerances);
+
+// Nivel más grueso adecuado para un zoom dado (índice en levels; -1 = usar la envolvente)
+int pyramidLevelForZoom(const VolumePyramid& pyramid, int zoom);
+
+} // namespace UPlanGeneration
+
+#endif // VOLUME_PYRAMID_H
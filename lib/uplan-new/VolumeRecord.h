@@ -0,0 +1,47 @@
+#ifndef VOLUME_RECORD_H
+#define VOLUME_RECORD_H
+
+#include <cstdint>
+#include <type_traits>
+
+namespace UPlanGeneration {
+
+// Representación binaria compacta de un volumen de operación.
+// Layout fijo (trivially copyable) para poder escribirse tal cual a disco,
+// enviarse por socket o mapearse con mmap sin serializar a JSON.
+// Las esquinas siguen el mismo orden que generateOrientedRectangleCorners
+// (el polígono se cierra implícitamente repitiendo la esquina 0).
+struct VolumeRecord {
+    int32_t plan_id;
+    int32_t ordinal;
+    double corner_lon[4];
+    double corner_lat[4];
+    double min_lon;
+    double min_lat;
+    double max_lon;
+    double max_lat;
+    double min_alt;         // metros (referencia según el generador: AGL por defecto)
+    double max_alt;
+    int64_t time_begin;     // unix timestamp (s), ya incluye tbuf
+    int64_t time_end;
+};
+
+static_assert(std::is_trivially_copyable<VolumeRecord>::value, "VolumeRecord must be trivially copyable");
+static_assert(sizeof(VolumeRecord) == 136, "VolumeRecord binary layout changed");
+
+// Solape en bbox horizontal, altitud y ventana temporal
+inline bool volumesOverlap(const VolumeRecord& a, const VolumeRecord& b) {
+    return a.min_lon <= b.max_lon && b.min_lon <= a.max_lon &&
+           a.min_lat <= b.max_lat && b.min_lat <= a.max_lat &&
+           a.min_alt <= b.max_alt && b.min_alt <= a.max_alt &&
+           a.time_begin <= b.time_end && b.time_begin <= a.time_end;
+}
+
+// Dos volúmenes están en conflicto si solapan y pertenecen a planes distintos
+inline bool volumesConflict(const VolumeRecord& a, const VolumeRecord& b) {
+    return a.plan_id != b.plan_id && volumesOverlap(a, b);
+}
+
+} // namespace UPlanGeneration
+
+#endif // VOLUME_RECORD_H
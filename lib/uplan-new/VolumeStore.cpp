@@ -0,0 +1,540 @@
+#include "VolumeStore.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace UPlanGeneration {
+
+namespace {
+
+const char LOG_MAGIC[8] = {'U', 'P', 'V', 'L', 'O', 'G', '0', '1'};
+const char INDEX_MAGIC[8] = {'U', 'P', 'V', 'I', 'D', 'X', '0', '1'};
+const uint32_t STORE_VERSION = 1;
+
+struct LogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+
+struct LogFrame {
+    VolumeRecord record;
+    uint32_t crc;
+    uint32_t reserved;
+};
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t log_offset;     // bytes of the log already contained in this checkpoint
+    uint64_t record_count;
+    uint64_t cell_count;
+    uint64_t ref_count;
+    double cell_size;
+};
+
+struct CellEntry {
+    int64_t key;
+    uint64_t first;          // first position in the refs array
+    uint64_t count;
+};
+
+// Volumes covering more cells than this per axis, or with non-finite bounds, are indexed
+// once under WIDE_CELL (checked by every query) instead of once per cell
+const int64_t MAX_CELL_SPAN = 1024;
+const int64_t WIDE_CELL = INT64_MIN;   // never produced by cellKey for clamped coordinates
+
+static_assert(sizeof(LogFrame) == sizeof(VolumeRecord) + 8, "unexpected LogFrame padding");
+static_assert(sizeof(IndexHeader) % 8 == 0, "IndexHeader must keep records 8-byte aligned");
+
+uint32_t crc32(const void* data, size_t length) {
+    // Built once, thread-safely, on first use (stores are shared by worker and shard threads)
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+int64_t cellKey(int64_t ix, int64_t iy) {
+    return static_cast<int64_t>((static_cast<uint64_t>(static_cast<uint32_t>(ix)) << 32) |
+                                static_cast<uint32_t>(iy));
+}
+
+bool writeAll(int fd, const void* data, size_t length) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t n = ::write(fd, p, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+VolumeStore::VolumeStore(const std::string& directory, double cell_size_deg)
+    : directory(directory), cell_size(cell_size_deg) {}
+
+VolumeStore::~VolumeStore() {
+    close();
+}
+
+std::string VolumeStore::logPath() const {
+    return (std::filesystem::path(directory) / "volumes.log").string();
+}
+
+std::string VolumeStore::indexPath() const {
+    return (std::filesystem::path(directory) / "volumes.idx").string();
+}
+
+bool VolumeStore::cellRange(const VolumeRecord& volume, int64_t& ix0, int64_t& ix1,
+                            int64_t& iy0, int64_t& iy1) const {
+    if (!std::isfinite(volume.min_lon) || !std::isfinite(volume.max_lon) ||
+        !std::isfinite(volume.min_lat) || !std::isfinite(volume.max_lat)) {
+        return false;
+    }
+    // Clamped to the WGS84 range so a corrupt bbox cannot overflow the cell loop
+    auto cell = [&](double deg, double limit) {
+        return static_cast<int64_t>(std::floor(std::clamp(deg, -limit, limit) / cell_size));
+    };
+    ix0 = cell(volume.min_lon, 180.0);
+    ix1 = cell(volume.max_lon, 180.0);
+    iy0 = cell(volume.min_lat, 90.0);
+    iy1 = cell(volume.max_lat, 90.0);
+    return ix1 - ix0 < MAX_CELL_SPAN && iy1 - iy0 < MAX_CELL_SPAN;
+}
+
+template <typename Fn>
+void VolumeStore::forEachCell(const VolumeRecord& volume, Fn fn) const {
+    int64_t ix0, ix1, iy0, iy1;
+    if (!cellRange(volume, ix0, ix1, iy0, iy1)) {
+        fn(WIDE_CELL);
+        return;
+    }
+    for (int64_t ix = ix0; ix <= ix1; ++ix) {
+        for (int64_t iy = iy0; iy <= iy1; ++iy) {
+            fn(cellKey(ix, iy));
+        }
+    }
+}
+
+bool VolumeStore::open() {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        std::cerr << "[ERROR] Cannot create volume store directory: " << directory << std::endl;
+        return false;
+    }
+
+    if (!mapCheckpoint(false)) {
+        return false;
+    }
+    if (!replayLog()) {
+        close();
+        return false;
+    }
+
+    std::cout << "[INFO] Volume store opened: " << mapped_count << " checkpointed + "
+              << tail.size() << " replayed volumes" << std::endl;
+    return true;
+}
+
+void VolumeStore::close() {
+    if (log_fd >= 0) {
+        ::close(log_fd);
+        log_fd = -1;
+    }
+    unmapCheckpoint();
+    tail.clear();
+    tail_cells.clear();
+}
+
+bool VolumeStore::mapCheckpoint(bool required) {
+    std::string path = indexPath();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (required) {
+            std::cerr << "[ERROR] Cannot open volume store checkpoint: " << path << " - "
+                      << std::strerror(errno) << std::endl;
+            return false;
+        }
+        // No checkpoint yet: everything comes from the log
+        checkpoint_log_offset = 0;
+        return true;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(IndexHeader)) {
+        std::cerr << "[ERROR] Invalid volume store checkpoint: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "[ERROR] Cannot mmap volume store checkpoint: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    const IndexHeader* header = static_cast<const IndexHeader*>(base);
+    // Each count is bounded by the file size before multiplying, so a corrupt header
+    // cannot wrap the expected size around to the real one
+    const size_t body = size - sizeof(IndexHeader);
+    bool valid = std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+                 header->version == STORE_VERSION &&
+                 header->record_size == sizeof(VolumeRecord) &&
+                 std::isfinite(header->cell_size) && header->cell_size > 0.0 &&
+                 header->record_count <= UINT32_MAX &&
+                 header->record_count <= body / sizeof(VolumeRecord) &&
+                 header->cell_count <= body / sizeof(CellEntry) &&
+                 header->ref_count <= body / sizeof(uint32_t) &&
+                 sizeof(IndexHeader) + header->record_count * sizeof(VolumeRecord) +
+                     header->cell_count * sizeof(CellEntry) +
+                     header->ref_count * sizeof(uint32_t) == size;
+
+    const char* p = static_cast<const char*>(base) + sizeof(IndexHeader);
+    const VolumeRecord* records = reinterpret_cast<const VolumeRecord*>(p);
+    const CellEntry* cells = reinterpret_cast<const CellEntry*>(p + (valid ? header->record_count * sizeof(VolumeRecord) : 0));
+    const uint32_t* refs = reinterpret_cast<const uint32_t*>(cells + (valid ? header->cell_count : 0));
+    // Lookups index refs and records straight from these ranges
+    for (uint64_t i = 0; valid && i < header->cell_count; ++i) {
+        valid = cells[i].first <= header->ref_count && cells[i].count <= header->ref_count - cells[i].first;
+    }
+    for (uint64_t i = 0; valid && i < header->ref_count; ++i) {
+        valid = refs[i] < header->record_count;
+    }
+    if (!valid) {
+        std::cerr << "[ERROR] Corrupt or incompatible volume store checkpoint: " << path << std::endl;
+        munmap(base, size);
+        return false;
+    }
+
+    // Only replace the current mapping once the new one is known to be good
+    unmapCheckpoint();
+    map_base = base;
+    map_size = size;
+    mapped_records = records;
+    mapped_count = header->record_count;
+    mapped_cells = cells;
+    mapped_cell_count = header->cell_count;
+    mapped_refs = refs;
+    checkpoint_log_offset = header->log_offset;
+    // The index was built with the checkpoint's cell size; keep using it
+    cell_size = header->cell_size;
+
+    madvise(map_base, map_size, MADV_WILLNEED);
+    return true;
+}
+
+void VolumeStore::unmapCheckpoint() {
+    if (map_base) {
+        munmap(map_base, map_size);
+    }
+    map_base = nullptr;
+    map_size = 0;
+    mapped_records = nullptr;
+    mapped_count = 0;
+    mapped_cells = nullptr;
+    mapped_cell_count = 0;
+    mapped_refs = nullptr;
+}
+
+bool VolumeStore::replayLog() {
+    std::string path = logPath();
+    log_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (log_fd < 0) {
+        std::cerr << "[ERROR] Cannot open volume log: " << path << " - " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    fstat(log_fd, &st);
+    uint64_t file_size = static_cast<uint64_t>(st.st_size);
+
+    if (file_size == 0) {
+        LogHeader header;
+        std::memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+        header.version = STORE_VERSION;
+        header.record_size = sizeof(VolumeRecord);
+        if (!writeAll(log_fd, &header, sizeof(header)) || fdatasync(log_fd) != 0) {
+            std::cerr << "[ERROR] Cannot initialize volume log: " << path << std::endl;
+            return false;
+        }
+        file_size = sizeof(header);
+    } else {
+        LogHeader header;
+        if (pread(log_fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+            std::memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 ||
+            header.version != STORE_VERSION ||
+            header.record_size != sizeof(VolumeRecord)) {
+            std::cerr << "[ERROR] Corrupt or incompatible volume log: " << path << std::endl;
+            return false;
+        }
+    }
+
+    uint64_t offset = std::max<uint64_t>(checkpoint_log_offset, sizeof(LogHeader));
+    if (offset > file_size) {
+        std::cerr << "[ERROR] Volume log is shorter than its checkpoint (" << file_size
+                  << " < " << offset << " bytes): " << path << std::endl;
+        return false;
+    }
+
+    // Replay only the tail written after the checkpoint
+    const size_t batch_frames = 4096;
+    std::vector<LogFrame> buffer(batch_frames);
+    while (offset + sizeof(LogFrame) <= file_size) {
+        size_t frames = std::min<uint64_t>(batch_frames, (file_size - offset) / sizeof(LogFrame));
+        ssize_t n = pread(log_fd, buffer.data(), frames * sizeof(LogFrame), static_cast<off_t>(offset));
+        if (n < static_cast<ssize_t>(frames * sizeof(LogFrame))) {
+            std::cerr << "[ERROR] Short read on volume log: " << path << std::endl;
+            return false;
+        }
+        size_t valid = 0;
+        while (valid < frames && crc32(&buffer[valid].record, sizeof(VolumeRecord)) == buffer[valid].crc) {
+            tail.push_back(buffer[valid].record);
+            indexTail(static_cast<uint32_t>(tail.size() - 1));
+            ++valid;
+        }
+        offset += valid * sizeof(LogFrame);
+        if (valid < frames) break;
+    }
+
+    if (offset != file_size) {
+        // Torn or corrupt write at the end (crash during append): drop it
+        std::cout << "[WARNING] Truncating " << (file_size - offset)
+                  << " trailing bytes from volume log" << std::endl;
+        if (ftruncate(log_fd, static_cast<off_t>(offset)) != 0) {
+            std::cerr << "[ERROR] Cannot truncate volume log: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    log_end = offset;
+    return true;
+}
+
+void VolumeStore::indexTail(uint32_t tail_index) {
+    forEachCell(tail[tail_index], [&](int64_t key) {
+        tail_cells[key].push_back(tail_index);
+    });
+}
+
+bool VolumeStore::append(const std::vector<VolumeRecord>& volumes) {
+    if (log_fd < 0) {
+        std::cerr << "[ERROR] Volume store is not open" << std::endl;
+        return false;
+    }
+    if (volumes.empty()) return true;
+
+    std::vector<LogFrame> frames(volumes.size());
+    for (size_t i = 0; i < volumes.size(); ++i) {
+        frames[i].record = volumes[i];
+        frames[i].crc = crc32(&volumes[i], sizeof(VolumeRecord));
+        frames[i].reserved = 0;
+    }
+
+    size_t bytes = frames.size() * sizeof(LogFrame);
+    if (lseek(log_fd, static_cast<off_t>(log_end), SEEK_SET) < 0 ||
+        !writeAll(log_fd, frames.data(), bytes) ||
+        fdatasync(log_fd) != 0) {
+        std::cerr << "[ERROR] Failed to append to volume log: " << std::strerror(errno) << std::endl;
+        // Leave the log as it was; a partial frame would be dropped on replay anyway
+        if (ftruncate(log_fd, static_cast<off_t>(log_end)) != 0) {
+            std::cerr << "[ERROR] Cannot roll back volume log: " << std::strerror(errno) << std::endl;
+        }
+        return false;
+    }
+    log_end += bytes;
+
+    for (const auto& volume : volumes) {
+        tail.push_back(volume);
+        indexTail(static_cast<uint32_t>(tail.size() - 1));
+    }
+
+    // The volumes are durable in the log at this point: a failed auto-checkpoint must not
+    // report the append as failed (a retry would insert them twice). The tail stays
+    // and the next append tries the checkpoint again.
+    if (checkpoint_interval > 0 && tail.size() >= checkpoint_interval && !checkpoint()) {
+        std::cerr << "[WARNING] Automatic volume store checkpoint failed; volumes remain in the log" << std::endl;
+    }
+    return true;
+}
+
+bool VolumeStore::checkpoint() {
+    if (log_fd < 0) {
+        std::cerr << "[ERROR] Volume store is not open" << std::endl;
+        return false;
+    }
+
+    size_t total = mapped_count + tail.size();
+    if (total > UINT32_MAX) {
+        std::cerr << "[ERROR] Volume store exceeds checkpoint capacity" << std::endl;
+        return false;
+    }
+
+    auto recordAt = [&](size_t i) -> const VolumeRecord& {
+        return i < mapped_count ? mapped_records[i] : tail[i - mapped_count];
+    };
+
+    // (cell, record) pairs sorted by cell -> contiguous ref ranges per cell
+    std::vector<std::pair<int64_t, uint32_t>> pairs;
+    pairs.reserve(total * 2);
+    for (size_t i = 0; i < total; ++i) {
+        forEachCell(recordAt(i), [&](int64_t key) {
+            pairs.emplace_back(key, static_cast<uint32_t>(i));
+        });
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    std::vector<CellEntry> cells;
+    std::vector<uint32_t> refs;
+    refs.reserve(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (cells.empty() || cells.back().key != pairs[i].first) {
+            cells.push_back({pairs[i].first, static_cast<uint64_t>(refs.size()), 0});
+        }
+        refs.push_back(pairs[i].second);
+        cells.back().count++;
+    }
+
+    IndexHeader header;
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = STORE_VERSION;
+    header.record_size = sizeof(VolumeRecord);
+    header.log_offset = log_end;
+    header.record_count = total;
+    header.cell_count = cells.size();
+    header.ref_count = refs.size();
+    header.cell_size = cell_size;
+
+    std::string path = indexPath();
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "[ERROR] Cannot create checkpoint: " << tmp_path << " - " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    bool ok = writeAll(fd, &header, sizeof(header));
+    if (ok && mapped_count > 0) ok = writeAll(fd, mapped_records, mapped_count * sizeof(VolumeRecord));
+    if (ok && !tail.empty()) ok = writeAll(fd, tail.data(), tail.size() * sizeof(VolumeRecord));
+    if (ok && !cells.empty()) ok = writeAll(fd, cells.data(), cells.size() * sizeof(CellEntry));
+    if (ok && !refs.empty()) ok = writeAll(fd, refs.data(), refs.size() * sizeof(uint32_t));
+    if (ok) ok = fsync(fd) == 0;
+    ::close(fd);
+
+    if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "[ERROR] Failed to write checkpoint: " << path << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        ::close(dir_fd);
+    }
+
+    // The tail is dropped only once the new checkpoint is mapped; until then the old
+    // mapping and the tail still hold every volume
+    if (!mapCheckpoint(true)) {
+        return false;
+    }
+    tail.clear();
+    tail_cells.clear();
+
+    std::cout << "[INFO] Volume store checkpoint: " << mapped_count << " volumes, "
+              << mapped_cell_count << " cells" << std::endl;
+    return true;
+}
+
+std::vector<uint32_t> VolumeStore::candidatesFor(const VolumeRecord& volume) const {
+    // Candidate ids: [0, mapped_count) checkpoint, [mapped_count, ...) tail
+    std::vector<uint32_t> candidates;
+    const CellEntry* cells = static_cast<const CellEntry*>(mapped_cells);
+
+    auto collect = [&](int64_t key) {
+        if (mapped_cell_count > 0) {
+            const CellEntry* end = cells + mapped_cell_count;
+            const CellEntry* it = std::lower_bound(cells, end, key,
+                [](const CellEntry& c, int64_t k) { return c.key < k; });
+            if (it != end && it->key == key) {
+                candidates.insert(candidates.end(), mapped_refs + it->first, mapped_refs + it->first + it->count);
+            }
+        }
+        auto tit = tail_cells.find(key);
+        if (tit != tail_cells.end()) {
+            for (uint32_t idx : tit->second) {
+                candidates.push_back(static_cast<uint32_t>(mapped_count) + idx);
+            }
+        }
+    };
+
+    int64_t ix0, ix1, iy0, iy1;
+    if (cellRange(volume, ix0, ix1, iy0, iy1)) {
+        forEachCell(volume, collect);
+        collect(WIDE_CELL);
+    } else {
+        // Too wide to walk cell by cell: every stored volume is a candidate
+        candidates.resize(mapped_count + tail.size());
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            candidates[i] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // A volume spanning several cells appears once per cell
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return candidates;
+}
+
+std::vector<VolumeRecord> VolumeStore::findConflicts(const VolumeRecord& volume) const {
+    std::vector<VolumeRecord> conflicts;
+    for (uint32_t idx : candidatesFor(volume)) {
+        const VolumeRecord& other = idx < mapped_count ? mapped_records[idx] : tail[idx - mapped_count];
+        if (volumesConflict(volume, other)) {
+            conflicts.push_back(other);
+        }
+    }
+    return conflicts;
+}
+
+bool VolumeStore::contains(const VolumeRecord& volume) const {
+    // A stored copy shares the volume's cells, so it is among its candidates
+    for (uint32_t idx : candidatesFor(volume)) {
+        const VolumeRecord& other = idx < mapped_count ? mapped_records[idx] : tail[idx - mapped_count];
+        if (other.plan_id == volume.plan_id && other.ordinal == volume.ordinal) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace UPlanGeneration
@@ -0,0 +1,96 @@
+#ifndef VOLUME_STORE_H
+#define VOLUME_STORE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "VolumeRecord.h"
+
+namespace UPlanGeneration {
+
+// Almacén persistente de volúmenes aceptados.
+//
+//  - <dir>/volumes.log : log append-only de VolumeRecord (cada registro con CRC32)
+//  - <dir>/volumes.idx : checkpoint periódico con los registros + índice de celdas
+//                        de rejilla, pensado para mapearse directamente con mmap
+//
+// Al arrancar se mapea el checkpoint y sólo se reproduce la cola del log escrita
+// después de él, de modo que no hay que reconstruir el índice desde los JSON.
+class VolumeStore {
+public:
+    explicit VolumeStore(const std::string& directory, double cell_size_deg = 0.01);
+    ~VolumeStore();
+
+    VolumeStore(const VolumeStore&) = delete;
+    VolumeStore& operator=(const VolumeStore&) = delete;
+
+    // Abre (o crea) el almacén: mapea el checkpoint y reproduce la cola del log
+    bool open();
+    void close();
+
+    // Añade los volúmenes de un plan aceptado (durable tras retornar true). Un fallo del
+    // checkpoint automático sólo se avisa: los volúmenes ya están en el log.
+    bool append(const std::vector<VolumeRecord>& volumes);
+
+    // Escribe un nuevo checkpoint con todo el contenido y lo vuelve a mapear
+    bool checkpoint();
+
+    // Checkpoint automático cada N registros en la cola (0 = desactivado)
+    void setCheckpointInterval(size_t records) { checkpoint_interval = records; }
+
+    // Volúmenes almacenados que entran en conflicto con el dado
+    std::vector<VolumeRecord> findConflicts(const VolumeRecord& volume) const;
+
+    // Si ya hay almacenado un volumen con el mismo (plan_id, ordinal) y las mismas celdas
+    bool contains(const VolumeRecord& volume) const;
+
+    size_t size() const { return mapped_count + tail.size(); }
+    size_t tailSize() const { return tail.size(); }
+
+private:
+    std::string directory;
+    double cell_size;
+    size_t checkpoint_interval = 50000;
+
+    int log_fd = -1;
+    uint64_t log_end = 0;
+
+    // Checkpoint mapeado
+    void* map_base = nullptr;
+    size_t map_size = 0;
+    const VolumeRecord* mapped_records = nullptr;
+    size_t mapped_count = 0;
+    const void* mapped_cells = nullptr;
+    size_t mapped_cell_count = 0;
+    const uint32_t* mapped_refs = nullptr;
+    uint64_t checkpoint_log_offset = 0;
+
+    // Registros posteriores al checkpoint (cola del log)
+    std::vector<VolumeRecord> tail;
+    std::unordered_map<int64_t, std::vector<uint32_t>> tail_cells;
+
+    std::string logPath() const;
+    std::string indexPath() const;
+
+    // Mapea volumes.idx y sustituye el mapeo actual sólo si es válido
+    // (required = false: la ausencia del fichero no es un error)
+    bool mapCheckpoint(bool required);
+    void unmapCheckpoint();
+    bool replayLog();
+    void indexTail(uint32_t tail_index);
+    // Índices (checkpoint y después cola) de los volúmenes que comparten celda con el dado
+    std::vector<uint32_t> candidatesFor(const VolumeRecord& volume) const;
+
+    // Rango de celdas del volumen; false si no es finito o cubre demasiadas celdas
+    bool cellRange(const VolumeRecord& volume, int64_t& ix0, int64_t& ix1,
+                   int64_t& iy0, int64_t& iy1) const;
+
+    template <typename Fn>
+    void forEachCell(const VolumeRecord& volume, Fn fn) const;
+};
+
+} // namespace UPlanGeneration
+
+#endif // VOLUME_STORE_H
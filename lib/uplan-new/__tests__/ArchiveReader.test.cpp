@@ -0,0 +1,225 @@
+/**
+ * Tests de la carga masiva (ArchiveReader.h, UplanIdAssigner.h): los zip (stored/deflate),
+ * tar (ustar con prefijo y nombres largos GNU) y multipart/form-data se extraen en memoria
+ * sin directorios; una entrada o un total por encima de ArchiveLimits se rechaza aunque el
+ * zip declare un tamaño menor; y los ids de los planes respetan el del nombre del fichero
+ * salvo que falte o se repita.
+ *
+ * Compilar desde lib/uplan-new:
+ *   g++ -std=c++17 -I. __tests__/ArchiveReader.test.cpp ArchiveReader.cpp -lz -o archive_reader_test && ./archive_reader_test
+ */
+
+#include "ArchiveReader.h"
+#include "UplanIdAssigner.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+
+using namespace UPlanGeneration;
+
+namespace {
+
+void put16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void put32(std::string& out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value & 0xFFFF));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+std::string deflateRaw(const std::string& data) {
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, data.size()), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+struct ZipFile {
+    std::string name;
+    std::string data;
+    bool deflated;
+    uint32_t declared_size;   // tamaño descomprimido que dice el zip
+};
+
+ZipFile zipFile(const std::string& name, const std::string& data, bool deflated) {
+    return {name, data, deflated, static_cast<uint32_t>(data.size())};
+}
+
+std::string makeZip(const std::vector<ZipFile>& files) {
+    std::string out;
+    std::string central;
+    for (const auto& file : files) {
+        const std::string payload = file.deflated ? deflateRaw(file.data) : file.data;
+        const uint16_t method = file.deflated ? 8 : 0;
+        const uint32_t crc = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(file.data.data()),
+                                                         static_cast<uInt>(file.data.size())));
+        const uint32_t local = static_cast<uint32_t>(out.size());
+
+        put32(out, 0x04034b50);
+        put16(out, 20); put16(out, 0); put16(out, method); put16(out, 0); put16(out, 0);
+        put32(out, crc); put32(out, static_cast<uint32_t>(payload.size())); put32(out, file.declared_size);
+        put16(out, static_cast<uint16_t>(file.name.size())); put16(out, 0);
+        out += file.name;
+        out += payload;
+
+        put32(central, 0x02014b50);
+        put16(central, 20); put16(central, 20); put16(central, 0); put16(central, method);
+        put16(central, 0); put16(central, 0);
+        put32(central, crc); put32(central, static_cast<uint32_t>(payload.size())); put32(central, file.declared_size);
+        put16(central, static_cast<uint16_t>(file.name.size())); put16(central, 0); put16(central, 0);
+        put16(central, 0); put16(central, 0); put32(central, 0); put32(central, local);
+        central += file.name;
+    }
+    const uint32_t central_offset = static_cast<uint32_t>(out.size());
+    out += central;
+    put32(out, 0x06054b50);
+    put16(out, 0); put16(out, 0);
+    put16(out, static_cast<uint16_t>(files.size())); put16(out, static_cast<uint16_t>(files.size()));
+    put32(out, static_cast<uint32_t>(central.size())); put32(out, central_offset);
+    put16(out, 0);
+    return out;
+}
+
+void tarEntry(std::string& out, const std::string& name, const std::string& data, char type,
+              const std::string& prefix = "") {
+    char header[512];
+    std::memset(header, 0, sizeof(header));
+    std::memcpy(header, name.data(), std::min<size_t>(name.size(), 100));
+    std::snprintf(header + 124, 12, "%011o", static_cast<unsigned>(data.size()));
+    header[156] = type;
+    std::memcpy(header + 257, "ustar", 5);
+    std::memcpy(header + 345, prefix.data(), std::min<size_t>(prefix.size(), 155));
+    out.append(header, sizeof(header));
+    out += data;
+    out.append((512 - data.size() % 512) % 512, '\0');
+}
+
+std::string makeTar() {
+    std::string out;
+    const std::string long_name = "batch/" + std::string(120, 'n') + "_0007_Scan.csv";
+    tarEntry(out, "batch/", "", '5');
+    tarEntry(out, "Open A2 MR_0001_Scan.csv", "a,b\n1,2\n", '0', "batch");
+    tarEntry(out, "././@LongLink", long_name, 'L');
+    tarEntry(out, "truncated", "c,d\n3,4\n", '0');
+    out.append(1024, '\0');
+    return out;
+}
+
+} // namespace
+
+int main() {
+    const std::string csv = "SimTime,Lat,Lon,Alt\n" + std::string(2000, '7') + "\n";
+
+    // Zip con entradas stored y deflate y un directorio
+    {
+        std::vector<ArchiveEntry> entries;
+        std::string zip = makeZip({zipFile("batch/", "", false), zipFile("batch/a_0001_Scan.csv", "x,y\n", false),
+                                   zipFile("batch/b_0002_Scan.csv", csv, true)});
+        assert(extractArchive(zip, entries));
+        assert(entries.size() == 2);
+        assert(entries[0].name == "batch/a_0001_Scan.csv" && entries[0].data == "x,y\n");
+        assert(entries[1].name == "batch/b_0002_Scan.csv" && entries[1].data == csv);
+    }
+
+    // Límites: una entrada que declara ser pequeña pero se infla más de lo permitido,
+    // una que declara más del límite, y un total que ya ocupan las entradas previas
+    {
+        ArchiveLimits limits;
+        limits.max_entry_bytes = 1000;
+        std::vector<ArchiveEntry> entries;
+        ZipFile bomb = zipFile("bomb.csv", csv, true);
+        bomb.declared_size = 10;
+        assert(!extractArchive(makeZip({bomb}), entries, limits));
+        assert(!extractArchive(makeZip({zipFile("big.csv", csv, true)}), entries, limits));
+        assert(entries.empty());
+
+        // Sin límite, el tamaño declarado tiene que coincidir con el real
+        assert(!extractArchive(makeZip({bomb}), entries));
+
+        ArchiveLimits total;
+        total.max_total_bytes = csv.size() + 100;
+        entries.push_back({"previous.csv", std::string(200, 'p')});
+        assert(!extractArchive(makeZip({zipFile("b.csv", csv, true)}), entries, total));
+        entries.clear();
+        assert(extractArchive(makeZip({zipFile("b.csv", csv, true)}), entries, total));
+    }
+
+    // Tar: el prefijo ustar y el nombre largo GNU forman la ruta; los directorios no se devuelven
+    {
+        std::vector<ArchiveEntry> entries;
+        assert(extractArchive(makeTar(), entries));
+        assert(entries.size() == 2);
+        assert(entries[0].name == "batch/Open A2 MR_0001_Scan.csv" && entries[0].data == "a,b\n1,2\n");
+        assert(entries[1].name == "batch/" + std::string(120, 'n') + "_0007_Scan.csv" && entries[1].data == "c,d\n3,4\n");
+
+        ArchiveLimits limits;
+        limits.max_entry_bytes = 4;
+        entries.clear();
+        assert(!extractArchive(makeTar(), entries, limits));
+
+        std::string truncated = makeTar();
+        truncated.resize(2 * 512 + 4);   // a mitad de los datos del primer fichero
+        assert(!extractArchive(truncated, entries));
+        assert(!extractArchive("not an archive", entries));
+    }
+
+    // Multipart: un CSV, un zip (que se extrae) y un campo sin fichero (que se ignora)
+    {
+        const std::string boundary = multipartBoundary("multipart/form-data; boundary=\"XyZ\"");
+        assert(boundary == "XyZ");
+        const std::string zip = makeZip({zipFile("z_0003_Scan.csv", csv, true)});
+        const std::string body =
+            "--XyZ\r\nContent-Disposition: form-data; name=\"note\"\r\n\r\nhola\r\n"
+            "--XyZ\r\nContent-Disposition: form-data; name=\"f\"; filename=\"p_0004_Scan.csv\"\r\n\r\nq,r\n\r\n"
+            "--XyZ\r\nContent-Disposition: form-data; name=\"z\"; filename=\"lote.zip\"\r\n\r\n" + zip + "\r\n"
+            "--XyZ--\r\n";
+        std::vector<ArchiveEntry> entries;
+        assert(parseMultipart(body, boundary, entries));
+        assert(entries.size() == 2);
+        assert(entries[0].name == "p_0004_Scan.csv" && entries[0].data == "q,r\n");
+        assert(entries[1].name == "z_0003_Scan.csv" && entries[1].data == csv);
+
+        ArchiveLimits limits;
+        limits.max_total_bytes = 100;
+        entries.clear();
+        assert(!parseMultipart(body, boundary, entries, limits));
+        entries.clear();
+        assert(!parseMultipart(body.substr(0, body.size() - 10), boundary, entries));
+        assert(!parseMultipart(body, "", entries));
+    }
+
+    // Ids: el del nombre si está libre; los repetidos y los que no tienen id reciben uno
+    // libre sin quitarle el suyo a un fichero posterior; la misma fuente, el mismo id
+    {
+        UplanIdAssigner ids;
+        const std::vector<std::pair<std::string, int>> sources = {
+            {"a/x_0002_Scan.csv", 2}, {"b/x_0002_Scan.csv", 2}, {"sin_id.csv", 0}, {"y_0001_Scan.csv", 1}};
+        for (const auto& source : sources) ids.claim(source.first, source.second);
+        assert(ids.assign("a/x_0002_Scan.csv", 2) == 2);
+        assert(ids.assign("b/x_0002_Scan.csv", 2) == 3);
+        assert(ids.assign("sin_id.csv", 0) == 4);
+        assert(ids.assign("y_0001_Scan.csv", 1) == 1);
+        assert(ids.assign("b/x_0002_Scan.csv", 2) == 3);
+        assert(ids.assign("nuevo_0004_Scan.csv", 4) == 5);
+    }
+
+    std::cout << "ArchiveReader tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * Tests de la API con corrutinas (AsyncGenerator.h): los Task encadenados devuelven su
+ * valor o su excepción; offload ejecuta en el pool y reanuda en el hilo del bucle; un
+ * socket no bloqueante transfiere más de lo que cabe en su buffer esperando con epoll
+ * (readable/writable) y detecta el cierre del otro extremo; una tarea lanzada con spawn
+ * que falla no detiene el bucle, y la carga y escritura de ficheros pasan por el pool de E/S.
+ *
+ * Requiere C++20. Compilar desde lib/uplan-new ($UPLAN_LIB: librería Uplan con Uplan.h,
+ * Volume.h y Functions.h; $UPLAN_SRCS: sus fuentes):
+ *   g++ -std=c++20 -pthread -I. -I$UPLAN_LIB __tests__/AsyncGenerator.test.cpp AsyncGenerator.cpp \
+ *       UplanGeneratorComplete.cpp UplanSchemaValidator.cpp VolumePyramid.cpp GeozoneIndex.cpp DemTileCache.cpp \
+ *       UplanFastReader.cpp $UPLAN_SRCS -lGeographic -o async_test && ./async_test
+ */
+
+#include "AsyncGenerator.h"
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace UPlanGeneration;
+
+namespace {
+
+struct Results {
+    int chained = 0;
+    bool offload_on_loop_thread = false;
+    bool offload_error_caught = false;
+    bool empty_task_rejected = false;
+    std::string received;
+    bool sent = false;
+    ssize_t after_close = -1;
+    size_t waypoints = 0;
+    bool written = false;
+    bool write_failed = false;
+    bool done = false;
+};
+
+Task<int> square(int value) {
+    co_return value * value;
+}
+
+Task<int> sumOfSquares(int a, int b) {
+    int x = co_await square(a);
+    int y = co_await square(b);
+    co_return x + y;
+}
+
+Task<void> failing() {
+    throw std::runtime_error("expected failure");
+    co_return;
+}
+
+Task<void> receive(EventLoop& loop, int fd, size_t expected, Results& results) {
+    std::vector<char> buffer(4096);
+    while (results.received.size() < expected) {
+        ssize_t n = co_await readSomeAsync(loop, fd, buffer.data(), buffer.size());
+        if (n <= 0) break;
+        results.received.append(buffer.data(), static_cast<size_t>(n));
+    }
+}
+
+// Por valor: la corrutina sigue viva después de que spawn retorne
+Task<void> scenario(AsyncRuntime& runtime, int fds[2], std::string payload, std::string csv_path,
+                    std::string out_path, Results& results) {
+    EventLoop& loop = runtime.loop;
+    const std::thread::id loop_thread = std::this_thread::get_id();
+
+    results.chained = co_await sumOfSquares(3, 4);
+
+    const std::thread::id worker = co_await offload(loop, runtime.cpu, [] { return std::this_thread::get_id(); });
+    results.offload_on_loop_thread = worker != loop_thread && std::this_thread::get_id() == loop_thread;
+
+    try {
+        co_await offload(loop, runtime.cpu, [] { throw std::runtime_error("worker failure"); });
+    } catch (const std::runtime_error&) {
+        results.offload_error_caught = true;
+    }
+
+    try {
+        Task<int> empty;
+        co_await empty;
+    } catch (const std::logic_error&) {
+        results.empty_task_rejected = true;
+    }
+
+    // El emisor llena el buffer del socket y espera a que el receptor lo vacíe
+    loop.spawn(receive(loop, fds[1], payload.size(), results));
+    results.sent = co_await writeAllAsync(loop, fds[0], payload);
+    while (results.received.size() < payload.size()) {
+        co_await offload(loop, runtime.io, [] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+    }
+    ::close(fds[0]);
+    char byte;
+    results.after_close = co_await readSomeAsync(loop, fds[1], &byte, 1);
+
+    results.waypoints = (co_await loadTrajectoryAsync(runtime, csv_path)).size();
+    results.written = co_await writeAsync(runtime, out_path, payload.substr(0, 100));
+    results.write_failed = !co_await writeAsync(runtime, "/nonexistent/dir/out.json", "{}");
+
+    results.done = true;
+    loop.stop();
+}
+
+} // namespace
+
+int main() {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "async_generator_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::string csv_path = (dir / "Open A2 MR_0001_Scan.csv").string();
+    {
+        std::ofstream csv(csv_path);
+        csv << "SimTime,Lat,Lon,Alt\n";
+        for (int i = 0; i < 30; ++i) csv << i << ",39." << i << ",-0.1,50\n";
+    }
+
+    int fds[2];
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    for (int fd : fds) ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    std::string payload(4 << 20, '\0');
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>(i * 31 + 7);
+
+    AsyncRuntime runtime(UplanConfigComplete(), 2, 1);
+    Results results;
+    runtime.loop.spawn(failing());   // se registra el error y el bucle sigue
+    runtime.loop.spawn(scenario(runtime, fds, payload, csv_path, (dir / "out.bin").string(), results));
+    assert(runtime.loop.run());
+
+    assert(results.done);
+    assert(results.chained == 25);
+    assert(results.offload_on_loop_thread);
+    assert(results.offload_error_caught);
+    assert(results.empty_task_rejected);
+    assert(results.sent && results.received == payload);
+    assert(results.after_close == 0);
+    assert(results.waypoints == 30);
+    assert(results.written && std::filesystem::file_size(dir / "out.bin") == 100);
+    assert(results.write_failed);
+    assert(runtime.loop.pendingTasks() == 0);
+
+    ::close(fds[1]);
+    std::filesystem::remove_all(dir);
+    std::cout << "AsyncGenerator tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,169 @@
+/**
+ * Tests del diario de lotes (BatchJournal.h): las entradas volcadas (con el id de cada
+ * plan) se recuperan al reabrir, una última línea rota (caída a mitad de escritura) se descarta sin perder las
+ * anteriores, y tras una escritura parcial fallida (límite RLIMIT_FSIZE) el siguiente
+ * volcado completa la línea en lugar de repetir los bytes ya escritos. Repetir una carga
+ * masiva no duplica planes en su fichero de carga aunque el diario guarde entradas antiguas.
+ *
+ * Compilar desde lib/uplan-new:
+ *   g++ -std=c++17 -I. __tests__/BatchJournal.test.cpp BatchJournal.cpp -o batch_journal_test && ./batch_journal_test
+ */
+
+#include "BatchJournal.h"
+#include <algorithm>
+#include <cassert>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+using namespace UPlanGeneration;
+
+namespace {
+
+std::string readAll(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+uint64_t hashOf(const std::string& name) {
+    return BatchJournal::hash(name.data(), name.size());
+}
+
+} // namespace
+
+int main() {
+    const std::string path = (std::filesystem::temp_directory_path() / "batch_journal_test.journal").string();
+    std::filesystem::remove(path);
+
+    // Volcado por grupos y al destruir
+    {
+        BatchJournal journal(path, 4);
+        assert(journal.open());
+        for (int i = 0; i < 10; ++i) {
+            std::string name = "plan_" + std::to_string(i);
+            journal.record(hashOf(name), name, "out/" + name + ".json", i + 1);
+        }
+    }
+    {
+        BatchJournal journal(path);
+        assert(journal.open());
+        assert(journal.size() == 10);
+        assert(journal.isCompleted(hashOf("plan_3")));
+        assert(journal.outputOf(hashOf("plan_3")) == "out/plan_3.json");
+        auto plans = journal.completedPlans();
+        assert(plans.size() == 10 && plans.front().name == "plan_0" && plans.front().uplan_id == 1);
+        assert(plans.front().input_hash == hashOf("plan_0") && plans.front().output == "out/plan_0.json");
+    }
+
+    // Línea rota al final y una línea sin campos: se descartan, las demás se conservan.
+    // Una línea sin la columna del id (diarios anteriores) se lee con id 0.
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << "not a journal line\n";
+        out << "00000000000000aa\tout/old.json\told\n";
+        out << "00000000000000ff\tout/torn.json\tpla";
+    }
+    {
+        BatchJournal journal(path);
+        assert(journal.open());
+        assert(journal.size() == 11);
+        assert(journal.outputOf(0xaa) == "out/old.json");
+        assert(journal.completedPlans().front().name == "old" && journal.completedPlans().front().uplan_id == 0);
+        journal.record(hashOf("plan_10"), "plan_10", "out/plan_10.json", 11);
+        assert(journal.flush());
+    }
+    {
+        const std::string content = readAll(path);
+        assert(content.find("pla0") == std::string::npos);
+        assert(content.back() == '\n');
+        BatchJournal journal(path);
+        assert(journal.open());
+        assert(journal.size() == 12 && journal.isCompleted(hashOf("plan_10")));
+    }
+
+    // Escritura parcial: el límite de tamaño corta el grupo a mitad de una línea
+    {
+        BatchJournal journal(path, 1000);
+        assert(journal.open());
+        for (int i = 11; i < 31; ++i) {
+            std::string name = "plan_" + std::to_string(i);
+            journal.record(hashOf(name), name, "out/" + name + ".json", i + 1);
+        }
+
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit original;
+        getrlimit(RLIMIT_FSIZE, &original);
+        rlimit limited = original;
+        limited.rlim_cur = std::filesystem::file_size(path) + 100;
+        setrlimit(RLIMIT_FSIZE, &limited);
+        assert(!journal.flush());
+        assert(std::filesystem::file_size(path) == limited.rlim_cur);
+        setrlimit(RLIMIT_FSIZE, &original);
+
+        assert(journal.flush());
+    }
+    {
+        // Cada entrada una sola vez y entera (más la línea ignorada de arriba)
+        const std::string content = readAll(path);
+        size_t lines = 0;
+        for (size_t pos = 0, end; (end = content.find('\n', pos)) != std::string::npos; pos = end + 1) {
+            std::string line = content.substr(pos, end - pos);
+            assert(line == "not a journal line" || line.rfind("00000000000000aa", 0) == 0 ||
+                   std::count(line.begin(), line.end(), '\t') == 3);
+            ++lines;
+        }
+        assert(lines == 33);
+
+        BatchJournal journal(path);
+        assert(journal.open());
+        assert(journal.size() == 32);
+        for (int i = 0; i < 31; ++i) {
+            std::string name = "plan_" + std::to_string(i);
+            assert(journal.outputOf(hashOf(name)) == "out/" + name + ".json");
+        }
+        for (const auto& plan : journal.completedPlans()) {
+            assert(plan.name == "old" || plan.uplan_id == std::stoi(plan.name.substr(5)) + 1);
+        }
+    }
+
+    // Dos ejecuciones de carga masiva sobre el mismo diario: la segunda repite el archivo
+    // con un CSV modificado y el fichero de carga (completedPlans de sus entradas) lista
+    // cada plan una sola vez, con la salida nueva del modificado
+    std::filesystem::remove(path);
+    auto bulkRun = [&](const std::string& changed) {
+        BatchJournal journal(path);
+        assert(journal.open());
+        std::vector<uint64_t> inputs;
+        for (int i = 0; i < 5; ++i) {
+            std::string name = "bulk_" + std::to_string(i) + ".csv";
+            std::string content = name == changed ? name + "-v2" : name;
+            inputs.push_back(hashOf(content));
+            if (!journal.isCompleted(inputs.back())) {
+                journal.record(inputs.back(), name, "out/" + content + ".json", i + 1);
+            }
+        }
+        return journal.completedPlans(inputs);
+    };
+    for (const std::string& changed : {std::string(), std::string(), std::string("bulk_2.csv")}) {
+        auto plans = bulkRun(changed);
+        assert(plans.size() == 5);
+        for (size_t i = 0; i < plans.size(); ++i) {
+            assert(plans[i].name == "bulk_" + std::to_string(i) + ".csv");
+        }
+        assert(plans[2].output == (changed.empty() ? "out/bulk_2.csv.json" : "out/bulk_2.csv-v2.json"));
+    }
+    {
+        BatchJournal journal(path);
+        assert(journal.open());
+        assert(journal.size() == 6 && journal.completedPlans().size() == 6);   // la entrada antigua sigue
+    }
+
+    std::filesystem::remove(path);
+    std::cout << "BatchJournal tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * Tests del almacén columnar (ColumnarTrajectoryStore.h): las muestras sólo se ven tras
+ * flush() y un segundo flush no las duplica; las consultas devuelven lo mismo que filtrar
+ * todas las muestras, descartando particiones por día/celda y bloques por zone map sin
+ * leer sus columnas; el diccionario de vuelos y la rejilla sobreviven al reabrir, y un
+ * bloque con CRC erróneo se salta sin perder los demás.
+ *
+ * Compilar desde lib/uplan-new ($UPLAN_LIB: librería Uplan, por UplanGeneratorComplete.h):
+ *   g++ -std=c++17 -I. -I$UPLAN_LIB __tests__/ColumnarTrajectoryStore.test.cpp ColumnarTrajectoryStore.cpp \
+ *       UplanFastReader.cpp -lz -o columnar_store_test && ./columnar_store_test
+ */
+
+#include "ColumnarTrajectoryStore.h"
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace UPlanGeneration;
+
+namespace {
+
+const double DAY0 = 1756717200.0;   // 2025-09-01T09:00:00Z
+
+struct Sample {
+    std::string id;
+    WaypointComplete wp;   // time absoluto
+};
+
+// Vuelo de 200 muestras cada 10 s que recorre 0.3º de longitud (varias celdas de 0.1º)
+std::vector<WaypointComplete> makeFlight(double lat, double lon, double alt) {
+    std::vector<WaypointComplete> waypoints;
+    for (int i = 0; i < 200; ++i) {
+        WaypointComplete wp;
+        wp.time = 10.0 * i;
+        wp.lat = lat + 0.0001 * i;
+        wp.lon = lon + 0.0015 * i;
+        wp.h = alt + (i % 20);
+        waypoints.push_back(wp);
+    }
+    return waypoints;
+}
+
+std::map<std::string, size_t> bruteForce(const std::vector<Sample>& all, const TrajectoryQuery& q) {
+    std::map<std::string, size_t> counts;
+    for (const auto& s : all) {
+        if (s.wp.time >= q.t0 && s.wp.time <= q.t1 && s.wp.lat >= q.min_lat && s.wp.lat <= q.max_lat &&
+            s.wp.lon >= q.min_lon && s.wp.lon <= q.max_lon && s.wp.h >= q.min_alt && s.wp.h <= q.max_alt) {
+            counts[s.id]++;
+        }
+    }
+    return counts;
+}
+
+std::map<std::string, size_t> counts(const std::vector<FlightSamples>& flights) {
+    std::map<std::string, size_t> result;
+    for (const auto& flight : flights) {
+        for (size_t i = 1; i < flight.samples.size(); ++i) {
+            assert(flight.samples[i - 1].time <= flight.samples[i].time);
+        }
+        result[flight.id] = flight.samples.size();
+    }
+    return result;
+}
+
+} // namespace
+
+int main() {
+    const std::string dir = (std::filesystem::temp_directory_path() / "columnar_store_test").string();
+    std::filesystem::remove_all(dir);
+
+    // Tres vuelos: dos el primer día en zonas distintas y uno al día siguiente
+    const std::vector<std::pair<std::string, double>> flights = {
+        {"Open A2 MR_0001_Scan", DAY0}, {"PDRA_STS FW_0002_Fijo", DAY0 + 600}, {"Open A1 MR_0003_Scan", DAY0 + 86400}};
+    const std::vector<std::vector<WaypointComplete>> paths = {
+        makeFlight(39.05, -0.45, 30), makeFlight(38.55, 0.05, 100), makeFlight(39.05, -0.45, 30)};
+    std::vector<Sample> all;
+    {
+        ColumnarTrajectoryStore store(dir, 0.1, 16);
+        assert(store.open());
+        assert(!store.append("bad\nid", paths[0], DAY0));
+        for (size_t f = 0; f < flights.size(); ++f) {
+            assert(store.append(flights[f].first, paths[f], flights[f].second));
+            for (auto wp : paths[f]) {
+                wp.time += flights[f].second;
+                all.push_back({flights[f].first, wp});
+            }
+        }
+        assert(store.pendingRows() == all.size());
+        assert(store.query(TrajectoryQuery()).empty());   // nothing flushed yet
+        assert(store.flush());
+        assert(store.pendingRows() == 0);
+        assert(store.flush());   // nothing pending: no blocks written twice
+    }
+
+    // Reabrir con otros parámetros: se usan los guardados
+    ColumnarTrajectoryStore store(dir, 1.0, 100000);
+    assert(store.open());
+    assert(store.flightCount() == 3);
+
+    TrajectoryQueryStats stats;
+    auto everything = store.query(TrajectoryQuery(), &stats);
+    assert(counts(everything) == bruteForce(all, TrajectoryQuery()));
+    assert(stats.rows_read == all.size() && stats.blocks_read == stats.blocks_total);
+    const size_t partitions = stats.partitions_total;
+    const size_t blocks = stats.blocks_total;
+    assert(partitions > 3 && blocks > partitions);
+
+    // Día: sólo se recorren las particiones del primer día
+    TrajectoryQuery first_day;
+    first_day.t0 = DAY0;
+    first_day.t1 = DAY0 + 7200;
+    assert(counts(store.query(first_day, &stats)) == bruteForce(all, first_day));
+    assert(stats.partitions_total == partitions && stats.partitions_scanned < partitions);
+
+    // Ventana corta: los zone maps de tiempo descartan la mayoría de bloques sin leerlos
+    TrajectoryQuery window;
+    window.t0 = DAY0 + 300;
+    window.t1 = DAY0 + 400;
+    assert(counts(store.query(window, &stats)) == bruteForce(all, window));
+    assert(stats.rows_matched == 11);
+    assert(stats.blocks_read < stats.blocks_total && stats.rows_read < all.size() / 4);
+
+    // Bbox y altitud
+    TrajectoryQuery area;
+    area.min_lon = 0.0;
+    area.max_lon = 0.2;
+    area.min_lat = 38.5;
+    area.max_lat = 38.6;
+    area.min_alt = 110;
+    assert(counts(store.query(area, &stats)) == bruteForce(all, area));
+    assert(store.query(area).size() == 1 && store.query(area)[0].id == "PDRA_STS FW_0002_Fijo");
+    assert(stats.partitions_scanned < partitions);
+
+    TrajectoryQuery empty;
+    empty.min_lon = 100.0;
+    empty.max_lon = 101.0;
+    assert(store.query(empty, &stats).empty() && stats.partitions_scanned == 0 && stats.rows_read == 0);
+
+    // CRC erróneo en el primer bloque de una partición: el resto de bloques se sigue leyendo
+    std::string corrupted;
+    size_t corrupted_rows = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+        if (entry.path().extension() == ".col" && std::filesystem::file_size(entry.path()) > 2 * (80 + 16 * 36)) {
+            corrupted = entry.path().string();
+            break;
+        }
+    }
+    assert(!corrupted.empty());
+    {
+        std::fstream f(corrupted, std::ios::binary | std::ios::in | std::ios::out);
+        uint32_t rows = 0;
+        f.seekg(8);
+        f.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+        corrupted_rows = rows;
+        f.seekp(80 + 2);
+        f.put('\x7f');
+    }
+    auto after = store.query(TrajectoryQuery(), &stats);
+    size_t total = 0;
+    for (const auto& flight : after) total += flight.samples.size();
+    assert(total == all.size() - corrupted_rows);
+    assert(stats.blocks_read == blocks - 1);
+
+    std::filesystem::remove_all(dir);
+    std::cout << "ColumnarTrajectoryStore tests passed" << std::endl;
+    return 0;
+}
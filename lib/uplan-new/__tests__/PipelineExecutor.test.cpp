@@ -0,0 +1,141 @@
+/**
+ * Tests del pipeline por etapas (PipelineExecutor.h): la cola MPMC entrega cada elemento
+ * una vez y en orden con un solo hilo, y una sola vez con varios productores y
+ * consumidores; cada elemento recorre las etapas en orden (o se descarta en la que
+ * retorna false) con colas pequeñas que fuerzan el back-pressure; las métricas cuentan
+ * elementos y descartes, y rebalance reparte los hilos según el tiempo de cada etapa.
+ *
+ * Compilar desde lib/uplan-new:
+ *   g++ -std=c++17 -pthread -I. __tests__/PipelineExecutor.test.cpp -o pipeline_test && ./pipeline_test
+ */
+
+#include "PipelineExecutor.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace UPlanGeneration;
+
+namespace {
+
+// Elemento sólo movible: el pipeline no puede copiarlo
+struct Plan {
+    std::unique_ptr<int> id;
+    int stages_seen = 0;
+};
+
+} // namespace
+
+int main() {
+    // Cola: capacidad redondeada a potencia de 2, llena/vacía y FIFO
+    {
+        MpmcQueue<int> queue(5);
+        for (int i = 0; i < 8; ++i) {
+            int value = i;
+            assert(queue.tryPush(value));
+        }
+        int extra = 8;
+        assert(!queue.tryPush(extra));
+        for (int i = 0; i < 8; ++i) {
+            int value = -1;
+            assert(queue.tryPop(value) && value == i);
+        }
+        int value = -1;
+        assert(!queue.tryPop(value));
+    }
+
+    // Cola con 4 productores y 4 consumidores: cada valor sale una sola vez
+    {
+        const int per_producer = 20000;
+        MpmcQueue<int> queue(64);
+        std::vector<std::atomic<int>> seen(4 * per_producer);
+        std::atomic<int> popped{0};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < 4; ++p) {
+            threads.emplace_back([&, p] {
+                for (int i = 0; i < per_producer; ++i) {
+                    int value = p * per_producer + i;
+                    while (!queue.tryPush(value)) std::this_thread::yield();
+                }
+            });
+            threads.emplace_back([&] {
+                int value;
+                while (popped.load() < 4 * per_producer) {
+                    if (queue.tryPop(value)) {
+                        seen[value]++;
+                        popped++;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        for (const auto& count : seen) assert(count.load() == 1);
+    }
+
+    // Pipeline de tres etapas: los impares se descartan en la segunda, la tercera es la lenta
+    const int items = 2000;
+    std::vector<std::atomic<int>> arrived(items);
+    std::atomic<bool> bad_thread{false};
+    PipelineExecutor<Plan> pipeline(2);
+    pipeline.addStage("load", 2, [&](Plan& plan, unsigned thread) {
+        if (thread >= 2 || plan.stages_seen != 0) bad_thread = true;
+        plan.stages_seen = 1;
+        return true;
+    });
+    pipeline.addStage("filter", 3, [&](Plan& plan, unsigned thread) {
+        if (thread >= 3 || plan.stages_seen != 1) bad_thread = true;
+        plan.stages_seen = 2;
+        return *plan.id % 2 == 0;
+    });
+    pipeline.addStage("write", 1, [&](Plan& plan, unsigned thread) {
+        if (thread != 0 || plan.stages_seen != 2) bad_thread = true;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        arrived[*plan.id]++;
+        return true;
+    });
+    pipeline.start();
+    for (int i = 0; i < items; ++i) {
+        Plan plan;
+        plan.id = std::make_unique<int>(i);
+        pipeline.submit(std::move(plan));
+    }
+    pipeline.finish();
+    pipeline.finish();   // idempotent
+
+    assert(!bad_thread);
+    for (int i = 0; i < items; ++i) {
+        assert(arrived[i].load() == (i % 2 == 0 ? 1 : 0));
+    }
+
+    auto stats = pipeline.stats();
+    assert(stats.size() == 3);
+    assert(stats[0].items == items && stats[0].dropped == 0);
+    assert(stats[1].items == items && stats[1].dropped == items / 2);
+    assert(stats[2].items == items / 2 && stats[2].dropped == 0);
+    assert(stats[2].occupancy() > stats[0].occupancy());
+    assert(stats[0].wait_out_seconds > 0.0);   // back-pressure from the slow stage
+
+    // La etapa lenta recibe la mayor parte de los hilos, y cada etapa al menos uno
+    std::vector<unsigned> threads = pipeline.rebalance(12);
+    assert(threads.size() == 3);
+    assert(std::accumulate(threads.begin(), threads.end(), 0u) == 12);
+    assert(threads[0] >= 1 && threads[1] >= 1 && threads[2] > threads[0] && threads[2] > threads[1]);
+    assert(pipeline.rebalance(2) == std::vector<unsigned>(3, 1));
+
+    // Un pipeline sin elementos termina igualmente
+    PipelineExecutor<Plan> idle;
+    idle.addStage("only", 4, [](Plan&, unsigned) { return true; });
+    idle.start();
+    idle.finish();
+    assert(idle.stats()[0].items == 0);
+
+    std::cout << "PipelineExecutor tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,166 @@
+/**
+ * Tests de la deconflicción repartida (ShardedDeconfliction.h): dos shards en hilos del
+ * mismo proceso detectan conflictos que cruzan la frontera entre ellos, reenviar un plan
+ * no duplica volúmenes en ningún shard, un shard que no responde cuenta como fallido al
+ * agotarse el timeout, y las peticiones enviadas antes de un half-close se responden.
+ *
+ * Compilar desde lib/uplan-new:
+ *   g++ -std=c++17 -pthread -I. __tests__/ShardedDeconfliction.test.cpp ShardedDeconfliction.cpp VolumeStore.cpp -o sharded_test && ./sharded_test
+ */
+
+#include "ShardedDeconfliction.h"
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace UPlanGeneration;
+
+namespace {
+
+VolumeRecord makeVolume(int32_t plan_id, int32_t ordinal, double lon, double lat) {
+    VolumeRecord r{};
+    r.plan_id = plan_id;
+    r.ordinal = ordinal;
+    r.min_lon = lon;
+    r.max_lon = lon + 0.02;
+    r.min_lat = lat;
+    r.max_lat = lat + 0.02;
+    r.min_alt = 30.0;
+    r.max_alt = 90.0;
+    r.time_begin = 1756717200;
+    r.time_end = r.time_begin + 600;
+    return r;
+}
+
+// Plan que recorre varias celdas de shard (0.1º) a lo largo de 1º de longitud
+std::vector<VolumeRecord> makePlan(int32_t plan_id) {
+    std::vector<VolumeRecord> volumes;
+    for (int i = 0; i < 50; ++i) {
+        volumes.push_back(makeVolume(plan_id, i, -0.5 + 0.02 * i, 39.05));
+    }
+    return volumes;
+}
+
+int connectTo(const std::string& path) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+struct RunningShard {
+    std::unique_ptr<ShardServer> server;
+    std::thread thread;
+
+    RunningShard(const std::string& socket, const std::string& store) : server(new ShardServer(socket, store)) {
+        thread = std::thread([this] { server->run(); });
+        int fd = connectTo(socket);   // wait until it listens
+        assert(fd >= 0);
+        ::close(fd);
+    }
+    ~RunningShard() {
+        server->stop();
+        thread.join();
+    }
+};
+
+} // namespace
+
+int main() {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "sharded_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::vector<std::string> sockets = {(dir / "s0.sock").string(), (dir / "s1.sock").string()};
+    const std::vector<std::string> stores = {(dir / "store0").string(), (dir / "store1").string()};
+
+    std::vector<size_t> stored_per_shard(2, 0);
+    {
+        RunningShard shard0(sockets[0], stores[0]);
+        RunningShard shard1(sockets[1], stores[1]);
+        ShardRouter router(sockets);
+
+        const std::vector<VolumeRecord> plan = makePlan(1);
+        for (const auto& v : plan) {
+            for (size_t shard : router.shardsFor(v)) stored_per_shard[shard]++;
+        }
+        assert(stored_per_shard[0] > 0 && stored_per_shard[1] > 0);   // the plan crosses shards
+
+        // Reenviar el plan (como tras un fallo parcial) y reenviar parte dentro de la misma petición
+        assert(router.insert(plan));
+        assert(router.insert(plan));
+        std::vector<VolumeRecord> twice(plan.begin(), plan.begin() + 5);
+        twice.insert(twice.end(), plan.begin(), plan.begin() + 5);
+        assert(router.insert(twice));
+
+        // Otro plan sobre el mismo recorrido: conflicto con cada volumen, cada uno una vez
+        bool ok = false;
+        std::vector<VolumeRecord> conflicts = router.findConflicts(makePlan(2), &ok);
+        assert(ok);
+        assert(conflicts.size() == plan.size());
+
+        // Half-close: la consulta enviada antes del FIN se responde igualmente
+        int fd = connectTo(sockets[0]);
+        struct { uint32_t magic; uint32_t code; uint64_t count; } header{0x48535055, 2, 1};
+        VolumeRecord query = makeVolume(3, 0, -0.5, 39.05);
+        assert(::write(fd, &header, sizeof(header)) == sizeof(header));
+        assert(::write(fd, &query, sizeof(query)) == sizeof(query));
+        ::shutdown(fd, SHUT_WR);
+        char reply[sizeof(header)];
+        size_t got = 0;
+        while (got < sizeof(reply)) {
+            ssize_t n = ::read(fd, reply + got, sizeof(reply) - got);
+            assert(n > 0);
+            got += static_cast<size_t>(n);
+        }
+        ::close(fd);
+    }
+
+    // Cada shard guardó cada volumen una sola vez
+    for (size_t shard = 0; shard < 2; ++shard) {
+        VolumeStore store(stores[shard]);
+        assert(store.open());
+        assert(store.size() == stored_per_shard[shard]);
+    }
+
+    // Un shard que acepta la conexión pero nunca responde
+    {
+        const std::string silent = (dir / "silent.sock").string();
+        int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, silent.c_str(), sizeof(addr.sun_path) - 1);
+        assert(::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        assert(::listen(listen_fd, 4) == 0);
+
+        ShardRouter router({silent});
+        router.setTimeout(200);
+        auto start = std::chrono::steady_clock::now();
+        bool ok = true;
+        router.findConflicts(makePlan(2), &ok);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        assert(!ok);
+        assert(elapsed < std::chrono::seconds(5));
+        ::close(listen_fd);
+    }
+
+    std::filesystem::remove_all(dir);
+    std::cout << "ShardedDeconfliction tests passed" << std::endl;
+    return 0;
+}
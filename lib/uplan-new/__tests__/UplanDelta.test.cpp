@@ -0,0 +1,109 @@
+/**
+ * Tests del delta binario de volúmenes (UplanDelta.h): encodeVolumeDelta -> applyVolumeDelta
+ * reconstruye exactamente los volúmenes nuevos, y los deltas truncados o con una
+ * cabecera manipulada se rechazan sin reservar memoria a partir de ella.
+ *
+ * Compilar desde lib/uplan-new:
+ *   g++ -std=c++17 -I. __tests__/UplanDelta.test.cpp UplanDelta.cpp -o uplan_delta_test && ./uplan_delta_test
+ */
+
+#include "UplanDelta.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace UPlanGeneration;
+
+namespace {
+
+std::vector<VolumeRecord> makeVolumes(size_t count, int32_t plan_id) {
+    std::vector<VolumeRecord> volumes(count);
+    for (size_t i = 0; i < count; ++i) {
+        VolumeRecord& r = volumes[i];
+        r = VolumeRecord{};
+        r.plan_id = plan_id;
+        r.ordinal = static_cast<int32_t>(i);
+        for (int k = 0; k < 4; ++k) {
+            r.corner_lon[k] = -0.1 + 0.001 * static_cast<double>(i) + 0.0001 * k;
+            r.corner_lat[k] = 39.0 + 0.001 * static_cast<double>(i) - 0.0001 * k;
+        }
+        r.min_lon = r.corner_lon[0];
+        r.max_lon = r.corner_lon[3];
+        r.min_lat = r.corner_lat[3];
+        r.max_lat = r.corner_lat[0];
+        r.min_alt = 30.0;
+        r.max_alt = 90.0;
+        r.time_begin = 1756717200 + static_cast<int64_t>(i) * 10;
+        r.time_end = r.time_begin + 12;
+    }
+    return volumes;
+}
+
+bool sameVolumes(const std::vector<VolumeRecord>& a, const std::vector<VolumeRecord>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::memcmp(&a[i], &b[i], sizeof(VolumeRecord)) != 0) return false;
+    }
+    return true;
+}
+
+void roundTrip(const std::vector<VolumeRecord>& old_volumes, const std::vector<VolumeRecord>& new_volumes) {
+    std::string delta = encodeVolumeDelta(old_volumes, new_volumes);
+    std::vector<VolumeRecord> rebuilt;
+    assert(applyVolumeDelta(old_volumes, delta, rebuilt));
+    assert(sameVolumes(rebuilt, new_volumes));
+}
+
+} // namespace
+
+int main() {
+    const std::vector<VolumeRecord> old_volumes = makeVolumes(200, 7);
+
+    // Sin cambios, desplazamiento común, retiempo, cambio de forma, volúmenes añadidos y eliminados
+    roundTrip(old_volumes, old_volumes);
+
+    std::vector<VolumeRecord> shifted = old_volumes;
+    for (auto& r : shifted) {
+        r.time_begin += 3600;
+        r.time_end += 3600;
+    }
+    roundTrip(old_volumes, shifted);
+
+    std::vector<VolumeRecord> edited = shifted;
+    edited[3].time_end += 5;
+    edited[10].max_alt = 120.0;
+    edited.resize(150);
+    roundTrip(old_volumes, edited);
+
+    std::vector<VolumeRecord> longer = makeVolumes(260, 7);
+    longer[0].corner_lon[1] += 0.0005;
+    roundTrip(old_volumes, longer);
+
+    roundTrip(old_volumes, {});
+    roundTrip({}, longer);
+
+    // Deltas truncados
+    std::string delta = encodeVolumeDelta(old_volumes, longer);
+    std::vector<VolumeRecord> rebuilt;
+    for (size_t cut = 0; cut < delta.size(); cut += 7) {
+        assert(!applyVolumeDelta(old_volumes, delta.substr(0, cut), rebuilt));
+    }
+
+    // Cabecera con un número de volúmenes imposible: se rechaza antes de reservar
+    std::string forged = encodeVolumeDelta(old_volumes, old_volumes);
+    const uint32_t huge = 0xFFFFFFF0u;
+    std::memcpy(&forged[4 + sizeof(int32_t)], &huge, sizeof(huge));
+    assert(!applyVolumeDelta(old_volumes, forged, rebuilt));
+
+    // Uno más de los que pueden cubrir los volúmenes anteriores y las operaciones
+    std::string one_more = encodeVolumeDelta(old_volumes, old_volumes);
+    const uint32_t count = static_cast<uint32_t>(old_volumes.size()) + 1;
+    std::memcpy(&one_more[4 + sizeof(int32_t)], &count, sizeof(count));
+    assert(!applyVolumeDelta(old_volumes, one_more, rebuilt));
+
+    std::cout << "UplanDelta tests passed" << std::endl;
+    return 0;
+}
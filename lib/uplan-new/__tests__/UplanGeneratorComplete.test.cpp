@@ -0,0 +1,103 @@
+/**
+ * Tests de la carga de CSV combinados (UplanGeneratorComplete::loadMultiFlightCSV): cada
+ * vuelo se entrega una vez y en orden con sus filas, las columnas se toman de la cabecera,
+ * las filas intercaladas se rechazan en modo agrupado (tras entregar los vuelos anteriores)
+ * y se aceptan con grouped = false.
+ *
+ * Compilar desde lib/uplan-new ($UPLAN_LIB: librería Uplan con Uplan.h, Volume.h y Functions.h;
+ * $UPLAN_SRCS: sus fuentes):
+ *   g++ -std=c++17 -I. -I$UPLAN_LIB __tests__/UplanGeneratorComplete.test.cpp UplanGeneratorComplete.cpp \
+ *       UplanSchemaValidator.cpp VolumePyramid.cpp GeozoneIndex.cpp DemTileCache.cpp UplanFastReader.cpp \
+ *       $UPLAN_SRCS -lGeographic -o generator_test && ./generator_test
+ */
+
+#include "UplanGeneratorComplete.h"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace UPlanGeneration;
+
+namespace {
+
+struct Delivery {
+    std::string id;
+    std::vector<WaypointComplete> waypoints;
+};
+
+std::string writeCsv(const std::string& name, const std::string& content) {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream out(path, std::ios::binary);
+    out << content;
+    return path;
+}
+
+size_t load(UplanGeneratorComplete& generator, const std::string& path, bool grouped, std::vector<Delivery>& deliveries) {
+    deliveries.clear();
+    return generator.loadMultiFlightCSV(path, [&](const std::string& id, std::vector<WaypointComplete>& waypoints) {
+        deliveries.push_back({id, std::move(waypoints)});
+    }, grouped);
+}
+
+} // namespace
+
+int main() {
+    UplanGeneratorComplete generator;
+    std::vector<Delivery> deliveries;
+
+    // Vuelos contiguos; FlightId no es la primera columna, líneas CRLF, comentarios y una fila rota
+    const std::string grouped = writeCsv("multi_flight_grouped.csv",
+        "SimTime,FlightId,Lat,Lon,Alt\r\n"
+        "// escenario de prueba\r\n"
+        "0,A,39.00,-0.10,30\r\n"
+        "1,A,39.01,-0.11,31\r\n"
+        "2,A,39.02,-0.12,32\r\n"
+        "0,B,38.50,-0.50,50\r\n"
+        "x,B,38.51,-0.51,51\r\n"
+        "1,B,38.52,-0.52,52\r\n"
+        "\r\n"
+        "0,C,40.00,0.10,70\r\n");
+    assert(load(generator, grouped, true, deliveries) == 3);
+    assert(deliveries.size() == 3);
+    assert(deliveries[0].id == "A" && deliveries[0].waypoints.size() == 3);
+    assert(deliveries[1].id == "B" && deliveries[1].waypoints.size() == 2);
+    assert(deliveries[2].id == "C" && deliveries[2].waypoints.size() == 1);
+    const WaypointComplete& wp = deliveries[0].waypoints[1];
+    assert(wp.time == 1 && wp.lat == 39.01 && wp.lon == -0.11 && wp.h == 31);
+    assert(deliveries[1].waypoints[1].h == 52);
+
+    // Filas de A que reaparecen tras entregar A: la carga se detiene sin volver a entregarlo
+    const std::string interleaved = writeCsv("multi_flight_interleaved.csv",
+        "FlightId,SimTime,Lat,Lon,Alt\n"
+        "A,0,39.00,-0.10,30\n"
+        "B,0,38.50,-0.50,50\n"
+        "A,1,39.01,-0.11,31\n"
+        "B,1,38.51,-0.51,51\n");
+    assert(load(generator, interleaved, true, deliveries) == 0);
+    assert(deliveries.size() == 1 && deliveries[0].id == "A" && deliveries[0].waypoints.size() == 1);
+
+    // Sin agrupar: todas las filas de cada vuelo, entregadas al final
+    assert(load(generator, interleaved, false, deliveries) == 2);
+    assert(deliveries.size() == 2);
+    for (const auto& delivery : deliveries) {
+        assert(delivery.waypoints.size() == 2);
+        assert(delivery.waypoints[0].time == 0 && delivery.waypoints[1].time == 1);
+    }
+
+    // Sin cabecera se usa el orden por defecto (FlightId,SimTime,Lat,Lon,Alt)
+    const std::string headerless = writeCsv("multi_flight_headerless.csv", "7,0,39.0,-0.1,30\n7,1,39.1,-0.2,40\n");
+    assert(load(generator, headerless, true, deliveries) == 1);
+    assert(deliveries[0].id == "7" && deliveries[0].waypoints[1].lon == -0.2);
+
+    assert(load(generator, "/nonexistent/multi_flight.csv", true, deliveries) == 0 && deliveries.empty());
+
+    for (const auto& path : {grouped, interleaved, headerless}) {
+        std::filesystem::remove(path);
+    }
+    std::cout << "UplanGeneratorComplete tests passed" << std::endl;
+    return 0;
+}
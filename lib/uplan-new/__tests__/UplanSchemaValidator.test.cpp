@@ -0,0 +1,97 @@
+/**
+ * Tests del validador de esquema (UplanSchemaValidator.h): el Uplan de ejemplo de lib/uplan
+ * cumple uplan_schema_UPV.json validando el documento (validate) y su texto en una pasada
+ * SAX (validateText), y cada variante rota se rechaza igual por los dos caminos. Un número
+ * entero escrito como 3.0 cuenta como "integer", como en JSON Schema y en UplanFastReader.
+ *
+ * Compilar desde lib/uplan-new:
+ *   g++ -std=c++17 -I. __tests__/UplanSchemaValidator.test.cpp UplanSchemaValidator.cpp -o schema_validator_test && ./schema_validator_test
+ */
+
+#include "UplanSchemaValidator.h"
+#include <cassert>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using namespace UPlanGeneration;
+using json = nlohmann::json;
+
+namespace {
+
+const UplanSchemaValidator* validator = nullptr;
+json example;
+
+// Resultado de los dos caminos, que deben coincidir
+bool validBoth(const json& uplan) {
+    std::vector<std::string> dom_errors;
+    std::vector<std::string> sax_errors;
+    bool dom = validator->validate(uplan, &dom_errors);
+    bool sax = validator->validateText(uplan.dump(4), &sax_errors);
+    assert(dom == sax);
+    assert(dom == dom_errors.empty() && sax == sax_errors.empty());
+    return dom;
+}
+
+bool validVariant(const std::function<void(json&)>& edit) {
+    json uplan = example;
+    edit(uplan);
+    return validBoth(uplan);
+}
+
+} // namespace
+
+int main() {
+    UplanSchemaValidator schema;
+    assert(!schema.isLoaded());
+    assert(!schema.validateText("{}"));
+    assert(schema.loadSchema("../uplan/uplan_schema_UPV.json"));
+    validator = &schema;
+
+    // El ejemplo no trae idplan ni nameplan, que añade el generador, y escribe privateFlight
+    // como 0 (el validador de la web lo convierte); el generador escribe false
+    std::ifstream file("../uplan/uplan_example.json");
+    example = json::parse(file);
+    example["idplan"] = 21;
+    example["nameplan"] = "Open A2 MR_0021_Scan.csv";
+    assert(!validBoth(example));
+    example["flightDetails"]["privateFlight"] = false;
+    assert(validBoth(example));
+    assert(!validVariant([](json& u) { u.erase("nameplan"); }));
+
+    // Tipos y rangos
+    assert(!validVariant([](json& u) { u["idplan"] = "21"; }));
+    assert(!validVariant([](json& u) { u["operationVolumes"][0]["ordinal"] = 2.5; }));
+    assert(!validVariant([](json& u) { u["operationVolumes"][0]["ordinal"] = -1; }));
+    assert(validVariant([](json& u) { u["operationVolumes"][0]["ordinal"] = 3.0; }));
+    assert(!validVariant([](json& u) { u["operationVolumes"][0].erase("timeEnd"); }));
+    assert(!validVariant([](json& u) { u["operationVolumes"][0]["extra"] = true; }));
+
+    // Enumerados, longitudes y formatos
+    assert(!validVariant([](json& u) { u["state"] = "FLYING"; }));
+    assert(!validVariant([](json& u) { u["dataOwnerIdentifier"]["sac"] = "UP"; }));
+    assert(!validVariant([](json& u) { u["creationTime"] = "yesterday"; }));
+    assert(!validVariant([](json& u) { u["contactDetails"]["emails"][0] = "hola"; }));
+
+    // Sólo el texto: 3.0 tal cual en los bytes, y un texto truncado o que no es JSON
+    std::string text = example.dump(4);
+    const std::string ordinal = "\"ordinal\": 0";
+    size_t pos = text.find(ordinal);
+    assert(pos != std::string::npos);
+    std::string as_float = text;
+    as_float.replace(pos, ordinal.size(), "\"ordinal\": 3.0");
+    assert(schema.validateText(as_float));
+    as_float.replace(pos, ordinal.size() + 2, "\"ordinal\": 3.5");
+    assert(!schema.validateText(as_float));
+
+    std::vector<std::string> errors;
+    assert(!schema.validateText(text.substr(0, text.size() / 2), &errors));
+    assert(!errors.empty());
+    assert(!schema.validateText("not json"));
+
+    std::cout << "UplanSchemaValidator tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * Tests de VolumeStore (VolumeStore.h): los volúmenes añadidos sobreviven a un reinicio
+ * (reproduciendo el log o mapeando el checkpoint), una escritura rota al final del log se
+ * descarta, un checkpoint corrupto o con contadores desbordados se rechaza, y los
+ * volúmenes con bbox no finito o enorme se siguen encontrando sin recorrer millones de celdas.
+ *
+ * Compilar desde lib/uplan-new:
+ *   g++ -std=c++17 -fsanitize=address -I. __tests__/VolumeStore.test.cpp VolumeStore.cpp -o volume_store_test && ./volume_store_test
+ */
+
+#include "VolumeStore.h"
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace UPlanGeneration;
+
+namespace {
+
+VolumeRecord makeVolume(int32_t plan_id, int32_t ordinal, double lon, double lat) {
+    VolumeRecord r{};
+    r.plan_id = plan_id;
+    r.ordinal = ordinal;
+    for (int k = 0; k < 4; ++k) {
+        r.corner_lon[k] = lon + 0.0005 * (k % 2);
+        r.corner_lat[k] = lat + 0.0005 * (k / 2);
+    }
+    r.min_lon = lon;
+    r.max_lon = lon + 0.0005;
+    r.min_lat = lat;
+    r.max_lat = lat + 0.0005;
+    r.min_alt = 30.0;
+    r.max_alt = 90.0;
+    r.time_begin = 1756717200 + ordinal * 10;
+    r.time_end = r.time_begin + 12;
+    return r;
+}
+
+std::vector<VolumeRecord> makePlan(int32_t plan_id, int count) {
+    std::vector<VolumeRecord> volumes;
+    for (int i = 0; i < count; ++i) {
+        volumes.push_back(makeVolume(plan_id, i, -0.1 + 0.001 * i, 39.0 + 0.001 * i));
+    }
+    return volumes;
+}
+
+// Un volumen de otro plan encima de cada volumen de makePlan: conflicto con todos
+size_t conflictsWithPlan(const VolumeStore& store, int count) {
+    size_t found = 0;
+    for (const auto& v : makePlan(999, count)) {
+        found += store.findConflicts(v).size();
+    }
+    return found;
+}
+
+size_t bruteForceConflicts(const std::vector<VolumeRecord>& stored, const VolumeRecord& volume) {
+    size_t found = 0;
+    for (const auto& other : stored) {
+        found += volumesConflict(volume, other) ? 1 : 0;
+    }
+    return found;
+}
+
+void appendBytes(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    out << bytes;
+}
+
+} // namespace
+
+int main() {
+    const std::string dir = (std::filesystem::temp_directory_path() / "volume_store_test").string();
+    std::filesystem::remove_all(dir);
+    const std::string log_path = dir + "/volumes.log";
+    const std::string idx_path = dir + "/volumes.idx";
+
+    // Reinicio reproduciendo sólo el log
+    {
+        VolumeStore store(dir);
+        store.setCheckpointInterval(0);
+        assert(store.open());
+        assert(store.append(makePlan(1, 40)));
+        assert(store.size() == 40);
+    }
+    {
+        VolumeStore store(dir);
+        store.setCheckpointInterval(0);
+        assert(store.open());
+        assert(store.size() == 40 && store.tailSize() == 40);
+        assert(conflictsWithPlan(store, 40) == 40);
+    }
+
+    // Escritura rota al final del log (caída a mitad de append): se trunca al reabrir
+    const auto log_size = std::filesystem::file_size(log_path);
+    appendBytes(log_path, std::string(100, 'x'));
+    {
+        VolumeStore store(dir);
+        store.setCheckpointInterval(0);
+        assert(store.open());
+        assert(store.size() == 40);
+        assert(std::filesystem::file_size(log_path) == log_size);
+    }
+
+    // Checkpoint explícito + cola posterior: ambos sobreviven y la cola se reproduce sola
+    {
+        VolumeStore store(dir);
+        store.setCheckpointInterval(0);
+        assert(store.open());
+        assert(store.checkpoint());
+        assert(store.tailSize() == 0 && store.size() == 40);
+        assert(store.append(makePlan(2, 10)));
+    }
+    {
+        VolumeStore store(dir);
+        store.setCheckpointInterval(0);
+        assert(store.open());
+        assert(store.size() == 50 && store.tailSize() == 10);
+        assert(conflictsWithPlan(store, 40) == 50);
+    }
+
+    // Checkpoint automático: append devuelve true y vacía la cola
+    {
+        VolumeStore store(dir);
+        store.setCheckpointInterval(20);
+        assert(store.open());
+        assert(store.append(makePlan(3, 20)));
+        assert(store.size() == 70 && store.tailSize() == 0);
+    }
+
+    // Volúmenes con bbox no finito o de medio mundo: se guardan y se encuentran igual que
+    // comparando contra todos, antes y después del checkpoint
+    {
+        VolumeStore store(dir);
+        store.setCheckpointInterval(0);
+        assert(store.open());
+        VolumeRecord wide = makeVolume(4, 0, -170.0, -80.0);
+        wide.max_lon = 170.0;
+        wide.max_lat = 80.0;
+        wide.time_end = wide.time_begin + 3600;
+        VolumeRecord huge = makeVolume(5, 0, -1e300, -1e300);
+        huge.max_lon = 1e300;
+        huge.max_lat = 1e300;
+        VolumeRecord nan = makeVolume(6, 0, 0.0, 0.0);
+        nan.min_lon = std::numeric_limits<double>::quiet_NaN();
+        assert(store.append({wide, huge, nan}));
+
+        std::vector<VolumeRecord> stored = makePlan(1, 40);
+        for (int32_t plan = 2; plan <= 3; ++plan) {
+            auto more = makePlan(plan, plan == 2 ? 10 : 20);
+            stored.insert(stored.end(), more.begin(), more.end());
+        }
+        stored.insert(stored.end(), {wide, huge, nan});
+        std::vector<VolumeRecord> queries = makePlan(999, 40);
+        queries.push_back(makeVolume(999, 0, 120.0, -45.0));
+        for (VolumeRecord q : {wide, huge, nan}) {
+            q.plan_id = 999;
+            queries.push_back(q);
+        }
+        for (int round = 0; round < 2; ++round) {
+            for (const auto& q : queries) {
+                assert(store.findConflicts(q).size() == bruteForceConflicts(stored, q));
+            }
+            assert(store.checkpoint());
+        }
+        assert(store.findConflicts(makeVolume(999, 0, 120.0, -45.0)).size() == 2);   // wide + huge
+    }
+
+    // Checkpoint corrupto: contadores que desbordan el tamaño esperado o refs fuera de rango
+    const auto idx_size = std::filesystem::file_size(idx_path);
+    std::filesystem::copy_file(idx_path, idx_path + ".good");
+    const size_t record_count_offset = 8 + 4 + 4 + 8;
+    auto patch = [&](size_t offset, uint64_t value) {
+        std::fstream f(idx_path, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(static_cast<std::streamoff>(offset));
+        f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    auto reopenFails = [&]() {
+        VolumeStore store(dir);
+        return !store.open();
+    };
+
+    // record_count * 136 + ref_count * 4 vuelve a dar el tamaño real módulo 2^64
+    patch(record_count_offset, (uint64_t(1) << 62) + 73);
+    assert(reopenFails());
+    std::filesystem::copy_file(idx_path + ".good", idx_path, std::filesystem::copy_options::overwrite_existing);
+
+    // Una celda cuyo rango de refs se sale del array
+    {
+        std::ifstream in(idx_path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        uint64_t record_count = 0;
+        std::memcpy(&record_count, &data[record_count_offset], sizeof(record_count));
+        const size_t first_cell = 56 + record_count * sizeof(VolumeRecord);
+        patch(first_cell + 8, UINT64_MAX - 1);
+    }
+    assert(reopenFails());
+    std::filesystem::copy_file(idx_path + ".good", idx_path, std::filesystem::copy_options::overwrite_existing);
+    assert(std::filesystem::file_size(idx_path) == idx_size);
+    assert(!reopenFails());
+
+    std::filesystem::remove_all(dir);
+    std::cout << "VolumeStore tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <iostream>
+#include <csignal>
+#include <string>
+#include "ShardedDeconfliction.h"
+
+// Proceso shard de deconflicción.
+// Uso: shardserver <socket_path> <store_directory>
+// Varios procesos (uno por shard) se combinan desde el cliente con ShardRouter.
+
+static UPlanGeneration::ShardServer* g_server = nullptr;
+
+static void handleSignal(int) {
+    if (g_server) g_server->stop();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <socket_path> <store_directory>" << std::endl;
+        return 1;
+    }
+
+    UPlanGeneration::ShardServer server(argv[1], argv[2]);
+    g_server = &server;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    return server.run() ? 0 : 1;
+}
@@ -1,10 +1,31 @@
 #include <iostream>
 #include <fstream>
+#include <csignal>
 #include <filesystem>
 #include <nlohmann/json.hpp>
 #include <map>
 #include <algorithm>
+#include <iterator>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <mutex>
 #include "UplanGeneratorComplete.h"
+#include "ArchiveReader.h"
+#include "BatchDriver.h"
+#include "DirectoryWatcher.h"
+#include "FlightPlanLoadWriter.h"
+#include "JsonPrecisionWriter.h"
+#include "PipelineExecutor.h"
+#include "UplanDelta.h"
+#include "CzmlWriter.h"
+#include "GltfExporter.h"
+#include "MvtExporter.h"
+#include "UplanFastReader.h"
+#include "UplanIdAssigner.h"
+#include "TrajectoryStore.h"
+#include "ColumnarTrajectoryStore.h"
 #include "Uplan.h"
 #include "OperationalIntent.h"
 #include "Functions.h"
@@ -81,8 +102,11 @@ TrajectoryInfo parseTrajectoryFilename(const std::string& filename) {
             std::string potential_id = filename.substr(start, end - start);
             bool is_number = !potential_id.empty() && 
                 std::all_of(potential_id.begin(), potential_id.end(), ::isdigit);
-            if (is_number) {
-                info.flightId = std::stoi(potential_id);
+            // An all-digit field too long for an int is not an id
+            int id = 0;
+            auto result = std::from_chars(potential_id.data(), potential_id.data() + potential_id.size(), id);
+            if (is_number && result.ec == std::errc()) {
+                info.flightId = id;
                 break;
             }
         }
@@ -121,9 +145,678 @@ UASData getUASData(const std::string& category, const std::string& aircraftType)
     return {0.0, 0.0};  // Default si no se encuentra
 }
 
-int main() {
+// Precisión por campo de los JSON de salida (--fixed-precision); nullptr = dump(4) completo
+const UPlanGeneration::JsonPrecision* output_precision = nullptr;
+
+std::string dumpOutput(const json& value) {
+    return output_precision ? UPlanGeneration::dumpWithPrecision(value, *output_precision, 4) : value.dump(4);
+}
+
+// --geozones <fichero>: los planes que entran en una geozona prohibida se rechazan al generarlos
+const UPlanGeneration::GeozoneIndex* geozone_index = nullptr;
+
+// --delta: al regenerar un plan ya guardado se escribe también Uplan_<id>.patch.json
+bool write_delta = false;
+
+// Esquema contra el que se validan los bytes de cada Uplan antes de escribirlos. El
+// generador ya valida el documento en memoria; aquí se valida el texto que se guarda
+// (con --fixed-precision, p. ej., los tiempos redondeados salen como enteros).
+const UPlanGeneration::UplanSchemaValidator* output_validator = nullptr;
+
+bool validateOutput(const std::string& uplan_text, const std::string& label) {
+    if (!output_validator) return true;
+    std::vector<std::string> errors;
+    if (output_validator->validateText(uplan_text, &errors)) return true;
+    std::cerr << "[ERROR] Serialized Uplan " << label << " does not match the schema:" << std::endl;
+    for (const auto& error : errors) {
+        std::cerr << "        " << error << std::endl;
+    }
+    return false;
+}
+
+// JSON Patch (RFC 6902) del Uplan guardado anteriormente al nuevo. Se compara con el
+// texto que se va a escribir (uplan_text, ya redondeado con --fixed-precision), no con
+// el documento en memoria: si no, los volúmenes que no cambian aparecerían modificados.
+void saveUplanDelta(const std::string& uplan_text, const std::string& uplan_output_file, const std::string& patch_output_file) {
+    std::ifstream previous_file(uplan_output_file);
+    if (!previous_file) return;   // first generation: nothing to diff against
+    json previous = json::parse(previous_file, nullptr, false);
+    if (previous.is_discarded()) {
+        std::cerr << "[WARNING] Cannot parse previous Uplan, no delta written: " << uplan_output_file << std::endl;
+        return;
+    }
+
+    json current = json::parse(uplan_text, nullptr, false);
+    if (current.is_discarded()) {
+        std::cerr << "[WARNING] Cannot parse new Uplan, no delta written: " << uplan_output_file << std::endl;
+        return;
+    }
+
+    UPlanGeneration::UplanDeltaStats stats;
+    std::string patch_text = dumpOutput(UPlanGeneration::diffUplan(previous, current, &stats));
+    std::ofstream patch_file(patch_output_file);
+    patch_file << patch_text;
+    std::cout << "[INFO] Saved Uplan delta: " << patch_output_file << " (" << patch_text.size() << " bytes; volumes "
+              << stats.volumes_kept << " kept, " << stats.volumes_retimed << " retimed, " << stats.volumes_reshaped
+              << " reshaped, " << stats.volumes_added << " added, " << stats.volumes_removed << " removed)" << std::endl;
+}
+
+// Guarda el Uplan y genera/guarda su OperationalIntent
+bool saveUplanAndOI(const json& uplanJson, int flightId, const std::string& output_path, const std::string& label) {
+    // Guardar Uplan JSON
+    std::string uplan_output_file = output_path + "Uplan_" + std::to_string(flightId) + ".json";
+    std::string uplan_text = dumpOutput(uplanJson);
+    if (!validateOutput(uplan_text, label)) return false;
+    if (write_delta) {
+        saveUplanDelta(uplan_text, uplan_output_file, output_path + "Uplan_" + std::to_string(flightId) + ".patch.json");
+    }
+    std::ofstream uplan_file(uplan_output_file);
+    uplan_file << uplan_text;
+    uplan_file.close();
+    std::cout << "[INFO] Saved Uplan: " << uplan_output_file << std::endl;
+
+    // 2. Crear objeto Uplan a partir del JSON
+    try {
+        Uplan uplan(uplanJson);
+        std::cout << "[INFO] Created Uplan object: " << uplan.getNameplan() << std::endl;
+
+        // 3. Crear OperationalIntent a partir del Uplan
+        OPERATOR_FAS::OperationalIntent oi(uplan);
+        std::cout << "[INFO] Created OperationalIntent: " << oi.getNameoi() << std::endl;
+
+        // 4. Guardar OperationalIntent JSON
+        json oiJson = oi.toJson();
+        std::string oi_output_file = output_path + "OI_" + std::to_string(flightId) + ".json";
+        std::ofstream oi_file(oi_output_file);
+        oi_file << dumpOutput(oiJson);
+        oi_file.close();
+        std::cout << "[INFO] Saved OperationalIntent: " << oi_output_file << std::endl;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Error creating Uplan/OI for " << label << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Procesa un CSV combinado con varios vuelos (columna FlightId). Cada vuelo se
+// genera en cuanto terminan sus filas; el FlightId sigue el mismo formato que los
+// nombres de fichero individuales ("Open A2 MR_0021_Scan").
+int runCombined(UPlanGeneration::UplanGeneratorComplete& generator, const std::string& combined_csv,
+                const std::string& output_path, double start_timestamp) {
+    size_t generated = 0;
+    size_t delivered = 0;
+    UPlanGeneration::UplanIdAssigner ids;
+    size_t flights = generator.loadMultiFlightCSV(combined_csv,
+        [&](const std::string& flight_id, std::vector<UPlanGeneration::WaypointComplete>& waypoints) {
+            ++delivered;
+            TrajectoryInfo trajInfo = parseTrajectoryFilename(flight_id);
+            UASData uasData = getUASData(trajInfo.category, trajInfo.aircraftType);
+            // FlightIds without a number (or repeating one) would share Uplan_0.json
+            const int uplan_id = ids.assign(flight_id, trajInfo.flightId);
+
+            std::cout << "\n[INFO] Processing flight: " << flight_id << " (ID " << uplan_id << ")" << std::endl;
+
+            json uplanJson = generator.generateCompleteUplan(
+                uplan_id,
+                trajInfo.csvFile,
+                waypoints,
+                start_timestamp,
+                getCategorySchema(trajInfo.category),
+                getAircraftTypeSchema(trajInfo.aircraftType),
+                uasData.mtom,
+                uasData.vMax
+            );
+            start_timestamp += 3600.0;
+
+            if (uplanJson.empty()) {
+                std::cerr << "[ERROR] Failed to generate Uplan for: " << flight_id << std::endl;
+                return;
+            }
+            if (saveUplanAndOI(uplanJson, uplan_id, output_path, flight_id)) {
+                ++generated;
+            }
+        });
+
+    // 0 flights means the file was rejected (unreadable, or a FlightId group that is not
+    // contiguous), possibly after some flights were already generated and saved
+    if (flights == 0) {
+        std::cerr << "[ERROR] Combined CSV rejected: " << combined_csv << " (" << generated << "/" << delivered
+                  << " flights delivered before the error were generated)" << std::endl;
+        return 1;
+    }
+    std::cout << "\n=== Generation completed: " << generated << "/" << flights << " flights ===" << std::endl;
+    return generated == flights ? 0 : 1;
+}
+
+// Trabajo de generación para un CSV de trayectoria (datos UAS según su nombre)
+UPlanGeneration::BatchJob makeJob(const std::string& filename, double start_timestamp) {
+    TrajectoryInfo trajInfo = parseTrajectoryFilename(filename);
+    UASData uasData = getUASData(trajInfo.category, trajInfo.aircraftType);
+
+    UPlanGeneration::BatchJob job;
+    job.uplan_id = trajInfo.flightId;
+    job.name = trajInfo.csvFile;
+    job.start_timestamp = start_timestamp;
+    job.category = getCategorySchema(trajInfo.category);
+    job.uasType = getAircraftTypeSchema(trajInfo.aircraftType);
+    job.mtom = uasData.mtom;
+    job.vMax = uasData.vMax;
+    return job;
+}
+
+// Construye los trabajos de una carga masiva a partir de los CSV extraídos
+std::vector<UPlanGeneration::BatchJob> makeBulkJobs(std::vector<UPlanGeneration::ArchiveEntry>& entries,
+                                                    double start_timestamp) {
+    // Entries are keyed by their path in the archive: the same file name may appear in
+    // several folders
+    UPlanGeneration::UplanIdAssigner ids;
+    for (const auto& entry : entries) {
+        std::string filename = fs::path(entry.name).filename().string();
+        if (fs::path(filename).extension() == ".csv") ids.claim(entry.name, parseTrajectoryFilename(filename).flightId);
+    }
+
+    std::vector<UPlanGeneration::BatchJob> jobs;
+    for (auto& entry : entries) {
+        std::string filename = fs::path(entry.name).filename().string();
+        if (fs::path(filename).extension() != ".csv") {
+            std::cout << "[WARNING] Skipping non-CSV entry: " << entry.name << std::endl;
+            continue;
+        }
+        UPlanGeneration::BatchJob job = makeJob(filename, start_timestamp + 3600.0 * static_cast<double>(jobs.size()));
+        job.uplan_id = ids.assign(entry.name, job.uplan_id);
+        job.csv_content = std::move(entry.data);
+        jobs.push_back(std::move(job));
+    }
+    entries.clear();
+    return jobs;
+}
+
+std::string readAll(std::istream& in) {
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Carga masiva desde un zip/tar: los planes se generan en paralelo y se guardan
+// (Uplan + OI) según van terminando
+int runBulk(const UPlanGeneration::UplanConfigComplete& config, const UPlanGeneration::UplanSchemaValidator* validator,
+            const std::string& archive_path, const std::string& output_path, double start_timestamp,
+            size_t memory_budget, const std::string& load_file,
+            const UPlanGeneration::FlightPlanLoadOptions& load_options) {
+    std::ifstream file(archive_path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "[ERROR] Cannot open archive: " << archive_path << std::endl;
+        return 1;
+    }
+    // Everything is extracted before admission: the extracted CSVs must fit in the budget
+    UPlanGeneration::ArchiveLimits limits;
+    limits.max_total_bytes = memory_budget;
+    std::vector<UPlanGeneration::ArchiveEntry> entries;
+    if (!UPlanGeneration::extractArchive(readAll(file), entries, limits)) return 1;
+
+    auto jobs = makeBulkJobs(entries, start_timestamp);
+    const size_t total = jobs.size();
+    std::cout << "[INFO] Bulk upload: " << total << " trajectories in " << archive_path << std::endl;
+
+    // Inputs of this run: the load file only lists their plans
+    std::vector<uint64_t> input_hashes;
+    input_hashes.reserve(jobs.size());
+    for (const auto& job : jobs) {
+        input_hashes.push_back(UPlanGeneration::BatchDriver::inputHash(job, job.csv_content));
+    }
+
+    // Progress journal next to the outputs: a rerun after a crash skips finished plans
+    UPlanGeneration::BatchJournal journal(output_path + "bulk.journal");
+    if (!journal.open()) return 1;
+
+    UPlanGeneration::BatchDriver driver(config);
+    driver.setValidator(validator);
+    driver.setGeozones(geozone_index);
+    driver.setJournal(&journal);
+    driver.setMemoryBudget(memory_budget);
+    std::mutex progress_mutex;
+    size_t done = 0;
+    size_t saved = 0;
+    driver.run(std::move(jobs), [&](UPlanGeneration::BatchResult& result) {
+        // Runs in the worker: serialize and write first, lock only for the counters
+        bool ok = false;
+        if (!result.ok) {
+            std::cerr << "[ERROR] Failed to generate Uplan for " << result.job.name << ": " << result.error << std::endl;
+        } else if (saveUplanAndOI(result.uplan, result.job.uplan_id, output_path, result.job.name)) {
+            result.output = output_path + "Uplan_" + std::to_string(result.job.uplan_id) + ".json";
+            ok = true;
+        }
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        ++done;
+        if (ok) ++saved;
+        std::cout << "[INFO] Progress: " << done + driver.skipped() << "/" << total << std::endl;
+    });
+    saved += driver.skipped();
+
+    // Fichero de carga para flightplan con los planes de este archivo, generados ahora o
+    // en una ejecución anterior interrumpida (según el diario). Las entradas del diario
+    // de otros archivos, o de versiones anteriores de éste, no se incluyen.
+    if (!load_file.empty()) {
+        UPlanGeneration::FlightPlanLoadWriter writer(load_file, load_options);
+        if (!writer.open()) return 1;
+        for (const auto& plan : journal.completedPlans(input_hashes)) {
+            std::ifstream uplan_file(plan.output);
+            json uplan = json::parse(uplan_file, nullptr, false);
+            if (uplan.is_discarded() || !writer.add(plan.name, uplan)) {
+                std::cerr << "[ERROR] Cannot add " << plan.output << " to " << load_file << std::endl;
+                return 1;
+            }
+        }
+        if (!writer.close()) return 1;
+    }
+
+    std::cout << "\n=== Bulk generation completed: " << saved << "/" << total << " plans";
+    if (driver.skipped() > 0) std::cout << " (" << driver.skipped() << " from a previous run)";
+    std::cout << " ===" << std::endl;
+    return total > 0 && saved == total ? 0 : 1;
+}
+
+// Carga masiva para el servicio: el cuerpo de la petición (multipart/form-data o
+// zip/tar) llega por stdin y cada resultado se escribe en stdout como una línea
+// NDJSON en cuanto termina, seguido de una línea de resumen. Los logs van a stderr.
+int runBulkStdin(const UPlanGeneration::UplanConfigComplete& config, const UPlanGeneration::UplanSchemaValidator* validator,
+                 const std::string& content_type, double start_timestamp, std::ostream& results,
+                 size_t memory_budget) {
+    std::string body = readAll(std::cin);
+    UPlanGeneration::ArchiveLimits limits;
+    limits.max_total_bytes = memory_budget;
+    std::vector<UPlanGeneration::ArchiveEntry> entries;
+    bool ok = content_type.find("multipart/") != std::string::npos
+        ? UPlanGeneration::parseMultipart(body, UPlanGeneration::multipartBoundary(content_type), entries, limits)
+        : UPlanGeneration::extractArchive(body, entries, limits);
+    body.clear();
+    body.shrink_to_fit();
+    if (!ok) {
+        results << json{{"status", "error"}, {"error", "invalid upload body"}}.dump() << std::endl;
+        return 1;
+    }
+
+    UPlanGeneration::BatchDriver driver(config);
+    driver.setValidator(validator);
+    driver.setGeozones(geozone_index);
+    driver.setMemoryBudget(memory_budget);
+    std::mutex results_mutex;
+    driver.run(makeBulkJobs(entries, start_timestamp), [&](UPlanGeneration::BatchResult& result) {
+        json line = {{"name", result.job.name}, {"idplan", result.job.uplan_id}};
+        if (result.ok) {
+            line["status"] = "ok";
+            line["uplan"] = std::move(result.uplan);
+        } else {
+            line["status"] = "error";
+            line["error"] = result.error;
+        }
+        // Serialized in the worker; the shared stream is only locked to write the line
+        const std::string text = line.dump();
+        std::lock_guard<std::mutex> lock(results_mutex);
+        results << text << std::endl;
+    });
+    results << json{{"summary", {{"ok", driver.succeeded()}, {"failed", driver.failed()}}}}.dump() << std::endl;
+    return driver.failed() == 0 ? 0 : 1;
+}
+
+static UPlanGeneration::DirectoryWatcher* g_watcher = nullptr;
+
+static void stopWatching(int) {
+    if (g_watcher) g_watcher->stop();
+}
+
+// Modo vigilancia: cada CSV que se termina de escribir en la carpeta se encola en el
+// pool de workers y su Uplan + OI se guardan en cuanto terminan. Todos los planes usan
+// el mismo instante de inicio, de modo que la entrada (y su hash en el diario) no
+// depende del orden de llegada: al reiniciar se omiten los ficheros ya generados, y
+// cada fichero del diario conserva su id para que otro no sobrescriba su salida.
+// Termina con SIGINT/SIGTERM tras completar los planes ya encolados.
+int runWatch(const UPlanGeneration::UplanConfigComplete& config, const UPlanGeneration::UplanSchemaValidator* validator,
+             const std::string& watch_dir, const std::string& output_path, double start_timestamp,
+             size_t memory_budget) {
+    UPlanGeneration::BatchJournal journal(output_path + "watch.journal");
+    if (!journal.open()) return 1;
+
+    UPlanGeneration::BatchDriver driver(config);
+    driver.setValidator(validator);
+    driver.setGeozones(geozone_index);
+    driver.setJournal(&journal);
+    driver.setMemoryBudget(memory_budget);
+    driver.start([&](UPlanGeneration::BatchResult& result) {
+        if (!result.ok) {
+            std::cerr << "[ERROR] Failed to generate Uplan for " << result.job.name << ": " << result.error << std::endl;
+        } else if (saveUplanAndOI(result.uplan, result.job.uplan_id, output_path, result.job.name)) {
+            result.output = output_path + "Uplan_" + std::to_string(result.job.uplan_id) + ".json";
+        }
+    });
+
+    UPlanGeneration::DirectoryWatcher watcher(watch_dir, ".csv");
+    g_watcher = &watcher;
+    std::signal(SIGINT, stopWatching);
+    std::signal(SIGTERM, stopWatching);
+
+    // The folder is flat, so the file name identifies the source across restarts
+    UPlanGeneration::UplanIdAssigner ids;
+    for (const auto& plan : journal.completedPlans()) {
+        ids.claim(plan.name, plan.uplan_id);
+    }
+    bool ok = watcher.run([&](const std::string& path) {
+        std::cout << "[INFO] Queued trajectory: " << path << std::endl;
+        UPlanGeneration::BatchJob job = makeJob(fs::path(path).filename().string(), start_timestamp);
+        job.uplan_id = ids.assign(job.name, job.uplan_id);
+        job.csv_path = path;
+        driver.submit(std::move(job));
+    }, true, [&]() {
+        // record() only checks the group delay when a plan completes: flush the last
+        // group while the folder is quiet so it does not stay pending indefinitely
+        journal.flushIfDue();
+    });
+
+    g_watcher = nullptr;
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    driver.finish();
+
+    std::cout << "\n=== Watch mode stopped: " << driver.succeeded() << " generated, " << driver.failed() << " failed, "
+              << driver.skipped() << " already completed ===" << std::endl;
+    return ok && driver.failed() == 0 ? 0 : 1;
+}
+
+// Plan en curso por las etapas del pipeline
+struct PipelinePlan {
+    UPlanGeneration::BatchJob job;
+    std::vector<UPlanGeneration::WaypointComplete> waypoints;
+    json uplan;
+    std::string uplan_text;
+    std::string oi_text;
+};
+
+// Genera todos los CSV de una carpeta con un pipeline carga -> generación ->
+// serialización -> escritura, con sus propios hilos por etapa, de modo que la E/S y
+// el cálculo se solapan. Al terminar muestra la ocupación de cada etapa y el reparto
+// de hilos sugerido para la siguiente ejecución.
+int runPipeline(const UPlanGeneration::UplanConfigComplete& config, const UPlanGeneration::UplanSchemaValidator* validator,
+                const std::string& trajectory_dir, const std::string& output_path, double start_timestamp,
+                std::vector<unsigned> stage_threads) {
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(trajectory_dir, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".csv") files.push_back(entry.path().string());
+    }
+    if (files.empty()) {
+        std::cerr << "[ERROR] No trajectory CSV files in " << trajectory_dir << std::endl;
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    // Stage threads: load, generate, serialize, write
+    const unsigned hw = std::max(4u, std::thread::hardware_concurrency());
+    const std::vector<unsigned> defaults = {1, hw - 3, 1, 1};
+    for (size_t i = stage_threads.size(); i < defaults.size(); ++i) stage_threads.push_back(defaults[i]);
+
+    for (auto& n : stage_threads) n = std::max(1u, n);
+
+    // One generator per thread of the stages that use one
+    std::vector<std::unique_ptr<UPlanGeneration::UplanGeneratorComplete>> loaders, generators;
+    for (unsigned i = 0; i < stage_threads[0]; ++i) {
+        loaders.push_back(std::make_unique<UPlanGeneration::UplanGeneratorComplete>(config));
+    }
+    for (unsigned i = 0; i < stage_threads[1]; ++i) {
+        generators.push_back(std::make_unique<UPlanGeneration::UplanGeneratorComplete>(config));
+        generators.back()->setValidator(validator);
+        generators.back()->setGeozones(geozone_index);
+    }
+
+    std::atomic<size_t> failed{0};
+    UPlanGeneration::PipelineExecutor<PipelinePlan> pipeline;
+    pipeline.addStage("load", stage_threads[0], [&](PipelinePlan& plan, unsigned thread) {
+        plan.waypoints = loaders[thread]->loadWaypointsFromCSV(plan.job.csv_path);
+        if (plan.waypoints.empty()) ++failed;
+        return !plan.waypoints.empty();
+    });
+    pipeline.addStage("generate", stage_threads[1], [&](PipelinePlan& plan, unsigned thread) {
+        const auto& job = plan.job;
+        plan.uplan = generators[thread]->generateCompleteUplan(job.uplan_id, job.name, plan.waypoints, job.start_timestamp,
+                                                               job.category, job.uasType, job.mtom, job.vMax);
+        plan.waypoints = {};
+        if (plan.uplan.empty()) {
+            std::cerr << "[ERROR] Failed to generate Uplan for: " << job.name << std::endl;
+            ++failed;
+        }
+        return !plan.uplan.empty();
+    });
+    pipeline.addStage("serialize", stage_threads[2], [&](PipelinePlan& plan, unsigned) {
+        try {
+            Uplan uplan(plan.uplan);
+            OPERATOR_FAS::OperationalIntent oi(uplan);
+            plan.oi_text = dumpOutput(oi.toJson());
+            plan.uplan_text = dumpOutput(plan.uplan);
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Error creating Uplan/OI for " << plan.job.name << ": " << e.what() << std::endl;
+            ++failed;
+            return false;
+        }
+        if (!validateOutput(plan.uplan_text, plan.job.name)) {
+            ++failed;
+            return false;
+        }
+        if (!write_delta) plan.uplan = json();   // the write stage diffs against the previous file
+        return true;
+    });
+    pipeline.addStage("write", stage_threads[3], [&](PipelinePlan& plan, unsigned) {
+        const std::string id = std::to_string(plan.job.uplan_id);
+        if (write_delta) {
+            saveUplanDelta(plan.uplan_text, output_path + "Uplan_" + id + ".json", output_path + "Uplan_" + id + ".patch.json");
+        }
+        std::ofstream uplan_file(output_path + "Uplan_" + id + ".json", std::ios::binary);
+        uplan_file << plan.uplan_text;
+        std::ofstream oi_file(output_path + "OI_" + id + ".json", std::ios::binary);
+        oi_file << plan.oi_text;
+        if (!uplan_file || !oi_file) {
+            std::cerr << "[ERROR] Cannot write outputs for " << plan.job.name << std::endl;
+            ++failed;
+            return false;
+        }
+        return true;
+    });
+
+    UPlanGeneration::UplanIdAssigner ids;
+    for (const auto& path : files) {
+        ids.claim(path, parseTrajectoryFilename(fs::path(path).filename().string()).flightId);
+    }
+
+    pipeline.start();
+    for (size_t i = 0; i < files.size(); ++i) {
+        PipelinePlan plan;
+        plan.job = makeJob(fs::path(files[i]).filename().string(), start_timestamp + 3600.0 * static_cast<double>(i));
+        plan.job.uplan_id = ids.assign(files[i], plan.job.uplan_id);
+        plan.job.csv_path = files[i];
+        pipeline.submit(std::move(plan));
+    }
+    pipeline.finish();
+
+    std::cout << "\n=== Pipeline completed: " << files.size() - failed << "/" << files.size() << " plans ===" << std::endl;
+    unsigned total_threads = 0;
+    for (const auto& stage : pipeline.stats()) {
+        total_threads += stage.threads;
+        std::cout << "[INFO] Stage " << stage.name << ": " << stage.threads << " threads, " << stage.items << " items, occupancy "
+                  << static_cast<int>(stage.occupancy() * 100.0 + 0.5) << "%, waiting for input " << stage.wait_in_seconds
+                  << " s, blocked on output " << stage.wait_out_seconds << " s" << std::endl;
+    }
+    std::cout << "[INFO] Suggested threads (load generate serialize write):";
+    for (unsigned n : pipeline.rebalance(total_threads)) std::cout << " " << n;
+    std::cout << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+// Exporta un CSV combinado a CZML para reproducir el escenario en Cesium: trayectoria
+// decimada de cada vuelo y sus volúmenes, escritos en streaming según se leen los vuelos
+int runCzml(UPlanGeneration::UplanGeneratorComplete& generator, const std::string& combined_csv,
+            const std::string& czml_path, double start_timestamp) {
+    std::ofstream file(czml_path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "[ERROR] Cannot open file for writing: " << czml_path << std::endl;
+        return 1;
+    }
+
+    UPlanGeneration::CzmlWriter writer(file);
+    writer.begin(fs::path(combined_csv).stem().string());
+    size_t flights = generator.loadMultiFlightCSV(combined_csv,
+        [&](const std::string& flight_id, std::vector<UPlanGeneration::WaypointComplete>& waypoints) {
+            TrajectoryInfo trajInfo = parseTrajectoryFilename(flight_id);
+            auto records = generator.generateVolumeRecords(generator.reduceWaypoints(waypoints),
+                                                           start_timestamp, trajInfo.flightId);
+            writer.addFlight(flight_id, trajInfo.csvFile, waypoints, start_timestamp, records);
+            start_timestamp += 3600.0;
+        });
+    writer.finish();
+
+    std::cout << "[INFO] Saved CZML: " << czml_path << " (" << flights << " flights, "
+              << writer.sampleCount() << " position samples)" << std::endl;
+    return flights > 0 ? 0 : 1;
+}
+
+// Posiciones de los vuelos de un CSV combinado en un instante (segundos desde el
+// inicio del escenario), opcionalmente dentro de un bbox; una línea JSON por vuelo
+int runPositions(UPlanGeneration::UplanGeneratorComplete& generator, const std::string& combined_csv,
+                 double start_timestamp, double offset, const std::vector<double>& bbox) {
+    UPlanGeneration::TrajectoryStore store;
+    double flight_start = start_timestamp;
+    generator.loadMultiFlightCSV(combined_csv,
+        [&](const std::string& flight_id, std::vector<UPlanGeneration::WaypointComplete>& waypoints) {
+            store.addFlight(flight_id, waypoints, flight_start);
+            flight_start += 3600.0;
+        });
+
+    double t = start_timestamp + offset;
+    UPlanGeneration::PositionSnapshot snapshot;
+    if (bbox.size() == 4) {
+        store.positionsInBox(t, bbox[0], bbox[1], bbox[2], bbox[3], snapshot);
+    } else {
+        store.positionsAt(t, snapshot);
+    }
+
+    std::cout << "[INFO] " << snapshot.size() << " of " << store.flightCount() << " flights at "
+              << Functions::timestamp_to_iso_string(t) << std::endl;
+    for (size_t k = 0; k < snapshot.size(); ++k) {
+        std::cout << json{{"flight", store.flightId(snapshot.flight[k])}, {"lat", snapshot.lat[k]},
+                          {"lon", snapshot.lon[k]}, {"h", snapshot.h[k]}}.dump() << std::endl;
+    }
+    return 0;
+}
+
+// Carga un CSV combinado en el almacén histórico de trayectorias
+int runIngest(UPlanGeneration::UplanGeneratorComplete& generator, const std::string& store_dir,
+              const std::string& combined_csv, double start_timestamp) {
+    UPlanGeneration::ColumnarTrajectoryStore store(store_dir);
+    if (!store.open()) return 1;
+    bool ok = true;
+    size_t flights = generator.loadMultiFlightCSV(combined_csv,
+        [&](const std::string& flight_id, std::vector<UPlanGeneration::WaypointComplete>& waypoints) {
+            ok = store.append(flight_id, waypoints, start_timestamp) && ok;
+            start_timestamp += 3600.0;
+        });
+    return ok && flights > 0 && store.flush() ? 0 : 1;
+}
+
+// Vuelos del almacén histórico dentro de un bbox entre t0 y t1; una línea JSON por vuelo
+int runQuery(const std::string& store_dir, double t0, double t1, const std::vector<double>& bbox) {
+    UPlanGeneration::ColumnarTrajectoryStore store(store_dir);
+    if (!store.open()) return 1;
+
+    UPlanGeneration::TrajectoryQuery query;
+    query.t0 = t0;
+    query.t1 = t1;
+    if (bbox.size() == 4) {
+        query.min_lon = bbox[0];
+        query.min_lat = bbox[1];
+        query.max_lon = bbox[2];
+        query.max_lat = bbox[3];
+    }
+
+    UPlanGeneration::TrajectoryQueryStats stats;
+    auto flights = store.query(query, &stats);
+    std::cout << "[INFO] Partitions " << stats.partitions_scanned << "/" << stats.partitions_total
+              << ", blocks " << stats.blocks_read << "/" << stats.blocks_total
+              << ", rows " << stats.rows_matched << "/" << stats.rows_read << std::endl;
+    for (const auto& flight : flights) {
+        std::cout << json{{"flight", flight.id}, {"samples", flight.samples.size()},
+                          {"begin", Functions::timestamp_to_iso_string(flight.samples.front().time)},
+                          {"end", Functions::timestamp_to_iso_string(flight.samples.back().time)}}.dump() << std::endl;
+    }
+    return 0;
+}
+
+// Lee los volúmenes de un conjunto de Uplans ya generados
+std::vector<UPlanGeneration::VolumeRecord> readUplanVolumes(const std::vector<std::string>& uplan_files) {
+    UPlanGeneration::UplanFastReader reader;
+    std::vector<UPlanGeneration::VolumeRecord> records;
+    for (const auto& file : uplan_files) {
+        if (!reader.readFile(file, records)) {
+            std::cerr << "[WARNING] Skipping Uplan: " << file << std::endl;
+        }
+    }
+    std::cout << "[INFO] Read " << records.size() << " volumes from " << uplan_files.size() << " Uplans" << std::endl;
+    return records;
+}
+
+// Argumento numérico completo de la línea de órdenes (sin excepciones)
+template <typename T>
+bool parseArg(const char* text, T& value) {
+    const char* end = text + std::strlen(text);
+    auto result = std::from_chars(text, end, value);
+    if (result.ec != std::errc() || result.ptr != end) return false;
+    if constexpr (std::is_floating_point_v<T>) return std::isfinite(value);
+    return true;
+}
+
+// Uso del programa tras un argumento inválido
+int printUsage(const std::string& problem) {
+    std::cerr << "[ERROR] " << problem << "\n"
+              << "Usage: uplangenerator [--schema <file>] [--fixed-precision] [--delta] [--geozones <file>] [--lod]\n"
+              << "       uplangenerator --combined <combined.csv>\n"
+              << "       uplangenerator --positions <combined.csv> <seconds> [min_lon min_lat max_lon max_lat]\n"
+              << "       uplangenerator --ingest <dir> <combined.csv>\n"
+              << "       uplangenerator --query <dir> <t0 ISO> <t1 ISO> [min_lon min_lat max_lon max_lat]\n"
+              << "       uplangenerator --czml <out.czml> <combined.csv>\n"
+              << "       uplangenerator --gltf <out_dir> <Uplan_*.json>...\n"
+              << "       uplangenerator --mvt <out_dir|out.mbtiles> <Uplan_*.json>...\n"
+              << "       uplangenerator --bulk <archive.zip|.tar> [--memory-budget <MB>] [--load-file <file.tsv>]\n"
+              << "                      [--load-user <id>] [--load-folder <id>]\n"
+              << "       uplangenerator --bulk-stdin [content-type] [--memory-budget <MB>]\n"
+              << "       uplangenerator --watch <dir> [--memory-budget <MB>]\n"
+              << "       uplangenerator --pipeline <dir> [load generate serialize write threads]" << std::endl;
+    return 1;
+}
+
+// bbox opcional (hasta 4 números) a partir de argv[first]
+bool parseBbox(int argc, char* argv[], int first, std::vector<double>& bbox) {
+    for (int i = first; i < argc && i < first + 4; ++i) {
+        double value = 0.0;
+        if (!parseArg(argv[i], value)) return false;
+        bbox.push_back(value);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    // En modo --bulk-stdin stdout queda reservado para los resultados NDJSON
+    std::ostream results(std::cout.rdbuf());
+    if (argc >= 2 && std::string(argv[1]) == "--bulk-stdin") {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
     std::cout << "=== Generating Uplans and Operational Intents ===" << std::endl;
 
+    // --fixed-precision: coordenadas con 7 decimales, altitudes con 2 y tiempos enteros
+    // en los JSON de salida (Uplan, OI y fichero de carga)
+    UPlanGeneration::JsonPrecision geographic_precision = UPlanGeneration::JsonPrecision::geographic();
+    if (std::find_if(argv + 1, argv + argc, [](const char* arg) { return std::string(arg) == "--fixed-precision"; }) != argv + argc) {
+        output_precision = &geographic_precision;
+    }
+    write_delta = std::find_if(argv + 1, argv + argc, [](const char* arg) {
+        return std::string(arg) == "--delta";
+    }) != argv + argc;
+
     // Configuración de rutas
     std::string setup_path = "setup/scenarios/Benidorm/BelowVLL/traj/";
     std::string output_path = "output/examples/";
@@ -152,6 +845,135 @@ int main() {
     config.tbuf = 5.0;
     UPlanGeneration::UplanGeneratorComplete generator(config);
 
+    // Validación contra uplan_schema_UPV.json (compilado una vez). Por defecto el de
+    // lib/uplan, relativo a la raíz del repositorio como las demás rutas; --schema <fichero>
+    // indica otro. Sin esquema no se genera nada.
+    std::string schema_path = "lib/uplan/uplan_schema_UPV.json";
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--schema") schema_path = argv[i + 1];
+    }
+    UPlanGeneration::UplanSchemaValidator validator;
+    if (!validator.loadSchema(schema_path)) {
+        return printUsage("Cannot load Uplan schema: " + schema_path + " (use --schema <file>)");
+    }
+    generator.setValidator(&validator);
+    output_validator = &validator;
+
+    // Geozonas del servicio de geo-awareness (p. ej. lib/geozones/geozones_static_NEW.json)
+    UPlanGeneration::GeozoneIndex geozones;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--geozones") {
+            if (!geozones.load(argv[i + 1])) return 1;
+            geozone_index = &geozones;
+            generator.setGeozones(geozone_index);
+        }
+    }
+
+    // Modo CSV combinado: uplangenerator --combined <fichero.csv>
+    if (argc >= 3 && std::string(argv[1]) == "--combined") {
+        return runCombined(generator, argv[2], output_path, start_timestamp);
+    }
+
+    // Posiciones en un instante: uplangenerator --positions <combinado.csv> <segundos> [min_lon min_lat max_lon max_lat]
+    if (argc >= 4 && std::string(argv[1]) == "--positions") {
+        std::vector<double> bbox;
+        double seconds = 0.0;
+        if (!parseArg(argv[3], seconds)) return printUsage(std::string("Invalid seconds: ") + argv[3]);
+        if (!parseBbox(argc, argv, 4, bbox)) return printUsage("Invalid bbox");
+        return runPositions(generator, argv[2], start_timestamp, seconds, bbox);
+    }
+
+    // Almacén histórico: uplangenerator --ingest <carpeta> <combinado.csv>
+    //                   uplangenerator --query <carpeta> <t0 ISO> <t1 ISO> [min_lon min_lat max_lon max_lat]
+    if (argc >= 4 && std::string(argv[1]) == "--ingest") {
+        return runIngest(generator, argv[2], argv[3], start_timestamp);
+    }
+    if (argc >= 5 && std::string(argv[1]) == "--query") {
+        std::vector<double> bbox;
+        if (!parseBbox(argc, argv, 5, bbox)) return printUsage("Invalid bbox");
+        return runQuery(argv[2], Functions::iso_string_to_timestamp(argv[3]),
+                        Functions::iso_string_to_timestamp(argv[4]), bbox);
+    }
+
+    // Reproducción en Cesium: uplangenerator --czml <salida.czml> <fichero_combinado.csv>
+    if (argc >= 4 && std::string(argv[1]) == "--czml") {
+        return runCzml(generator, argv[3], argv[2], start_timestamp);
+    }
+
+    // Exportación 3D: uplangenerator --gltf <carpeta_salida> <Uplan_*.json>...
+    if (argc >= 4 && std::string(argv[1]) == "--gltf") {
+        auto records = readUplanVolumes(std::vector<std::string>(argv + 3, argv + argc));
+        return UPlanGeneration::writeVolumesTileset(records, argv[2]) ? 0 : 1;
+    }
+
+    // Teselas vectoriales 2D: uplangenerator --mvt <carpeta|fichero.mbtiles> <Uplan_*.json>...
+    if (argc >= 4 && std::string(argv[1]) == "--mvt") {
+        auto records = readUplanVolumes(std::vector<std::string>(argv + 3, argv + argc));
+        return UPlanGeneration::writeVolumeTiles(records, argv[2]) >= 0 ? 0 : 1;
+    }
+
+    // Carga masiva: uplangenerator --bulk <fichero.zip|.tar> [--memory-budget <MB>] [--load-file <fichero.tsv>]
+    //                                     [--load-user <id>] [--load-folder <id>]
+    //               uplangenerator --bulk-stdin [content-type] [--memory-budget <MB>]
+    // Por defecto los planes en curso se limitan a 3/4 de la memoria del contenedor.
+    // --load-file escribe además los planes para cargarlos en flightplan con LOAD DATA;
+    // --load-user y --load-folder fijan su usuario y carpeta (NULL si no se indican).
+    size_t memory_budget = UPlanGeneration::BatchDriver::availableMemory() / 4 * 3;
+    std::string load_file;
+    UPlanGeneration::FlightPlanLoadOptions load_options;
+    load_options.precision = output_precision;
+    for (int i = 2; i + 1 < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--memory-budget") {
+            size_t megabytes = 0;
+            if (!parseArg(argv[i + 1], megabytes) || megabytes > (SIZE_MAX >> 20)) {
+                return printUsage(std::string("Invalid --memory-budget: ") + argv[i + 1]);
+            }
+            memory_budget = megabytes << 20;
+        } else if (option == "--load-file") {
+            load_file = argv[i + 1];
+        } else if (option == "--load-user" || option == "--load-folder") {
+            int id = 0;
+            if (!parseArg(argv[i + 1], id)) return printUsage("Invalid " + option + ": " + argv[i + 1]);
+            (option == "--load-user" ? load_options.user_id : load_options.folder_id) = id;
+        }
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--bulk") {
+        return runBulk(config, &validator, argv[2], output_path, start_timestamp, memory_budget, load_file,
+                       load_options);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--bulk-stdin") {
+        std::string content_type = argc >= 3 && std::string(argv[2]).rfind("--", 0) != 0 ? argv[2] : "";
+        int rc = runBulkStdin(config, &validator, content_type, start_timestamp, results, memory_budget);
+        std::cout.rdbuf(results.rdbuf());
+        return rc;
+    }
+
+    // Vigilancia de carpeta: uplangenerator --watch <carpeta_trayectorias> [--memory-budget <MB>]
+    if (argc >= 3 && std::string(argv[1]) == "--watch") {
+        return runWatch(config, &validator, argv[2], output_path, start_timestamp, memory_budget);
+    }
+
+    // Pipeline por etapas: uplangenerator --pipeline <carpeta_trayectorias> [hilos carga generación serialización escritura]
+    // Todos los modos aceptan --fixed-precision (JSON de salida con precisión por campo),
+    // --delta (JSON Patch respecto al Uplan guardado en una ejecución anterior),
+    // --geozones <fichero> (rechazo temprano de planes que entran en zonas prohibidas) y
+    // --schema <fichero> (esquema de validación de los Uplans).
+    if (argc >= 3 && std::string(argv[1]) == "--pipeline") {
+        std::vector<unsigned> stage_threads;
+        for (int i = 3; i < argc && i < 7 && std::isdigit(static_cast<unsigned char>(argv[i][0])); ++i) {
+            unsigned threads = 0;
+            if (!parseArg(argv[i], threads)) return printUsage(std::string("Invalid thread count: ") + argv[i]);
+            stage_threads.push_back(threads);
+        }
+        return runPipeline(config, &validator, argv[2], output_path, start_timestamp, stage_threads);
+    }
+
+    // --lod: guarda además la pirámide de niveles de detalle (LOD_<id>.json) para el mapa
+    bool write_lod = std::find_if(argv + 1, argv + argc, [](const char* arg) {
+        return std::string(arg) == "--lod";
+    }) != argv + argc;
+
     for (const auto& csvFile : trajectoryFiles) {
         std::string csv_path = setup_path + csvFile;
 
@@ -174,6 +996,7 @@ int main() {
         std::cout << "       Vmax: " << uasData.vMax << " m/s, MTOM: " << uasData.mtom << " kg" << std::endl;
 
         // 1. Generar Uplan completo (JSON)
+        UPlanGeneration::VolumePyramid pyramid;
         json uplanJson = generator.generateCompleteUplan(
             trajInfo.flightId,
             trajInfo.csvFile,
@@ -182,7 +1005,8 @@ int main() {
             getCategorySchema(trajInfo.category),
             getAircraftTypeSchema(trajInfo.aircraftType),
             uasData.mtom,
-            uasData.vMax
+            uasData.vMax,
+            write_lod ? &pyramid : nullptr
         );
 
         if (uplanJson.empty()) {
@@ -190,32 +1014,18 @@ int main() {
             continue;
         }
 
-        // Guardar Uplan JSON
-        std::string uplan_output_file = output_path + "Uplan_" + std::to_string(trajInfo.flightId) + ".json";
-        std::ofstream uplan_file(uplan_output_file);
-        uplan_file << uplanJson.dump(4);
-        uplan_file.close();
-        std::cout << "[INFO] Saved Uplan: " << uplan_output_file << std::endl;
-
-        // 2. Crear objeto Uplan a partir del JSON
-        try {
-            Uplan uplan(uplanJson);
-            std::cout << "[INFO] Created Uplan object: " << uplan.getNameplan() << std::endl;
+        saveUplanAndOI(uplanJson, trajInfo.flightId, output_path, csvFile);
 
-            // 3. Crear OperationalIntent a partir del Uplan
-            OPERATOR_FAS::OperationalIntent oi(uplan);
-            std::cout << "[INFO] Created OperationalIntent: " << oi.getNameoi() << std::endl;
-
-            // 4. Guardar OperationalIntent JSON
-            json oiJson = oi.toJson();
-            std::string oi_output_file = output_path + "OI_" + std::to_string(trajInfo.flightId) + ".json";
-            std::ofstream oi_file(oi_output_file);
-            oi_file << oiJson.dump(4);
-            oi_file.close();
-            std::cout << "[INFO] Saved OperationalIntent: " << oi_output_file << std::endl;
-
-        } catch (const std::exception& e) {
-            std::cerr << "[ERROR] Error creating Uplan/OI for " << csvFile << ": " << e.what() << std::endl;
+        if (write_lod) {
+            std::string lod_output_file = output_path + "LOD_" + std::to_string(trajInfo.flightId) + ".json";
+            std::ofstream lod_file(lod_output_file);
+            lod_file << generator.pyramidToJson(pyramid).dump();
+            lod_file.close();
+            std::cout << "[INFO] Saved LOD pyramid: " << lod_output_file << " (";
+            for (size_t l = 0; l < pyramid.levels.size(); ++l) {
+                std::cout << (l ? "/" : "") << pyramid.levels[l].records.size();
+            }
+            std::cout << " volumes)" << std::endl;
         }
 
         start_timestamp += 3600.0;